@@ -195,6 +195,7 @@
 #define QD_PHY_INT_ENABLE_REG            18
 #define QD_PHY_INT_STATUS_REG            19
 #define QD_PHY_INT_PORT_SUMMARY_REG        20
+#define QD_PHY_PAGE_ANY_REG            22
 
 /* Definitions for VCT registers */
 #define QD_REG_MDI0_VCT_STATUS     16
@@ -1719,8 +1719,8 @@ MV_STATUS gvtuGetEntryNext
 *
 * RETURNS:
 *       GT_OK      - on success.
-*       GT_FAIL    - on error or entry does not exist.
-*       GT_NO_SUCH - no more entries.
+*       GT_FAIL    - on error.
+*       GT_NO_SUCH - the entry does not exist.
 *
 * COMMENTS:
 *
@@ -22033,7 +22033,7 @@ MV_STATUS gprtPortPowerSet(IN GT_QD_DEV  *dev,
 			   IN MV_BOOL    onoff);
 
 
-MV_STATUS gprtPortPowerGet( IN GT_QD_DEV  *dev, IN GT_LPORT port);
+MV_STATUS gprtPortPowerGet( IN GT_QD_DEV  *dev, IN GT_LPORT port, OUT MV_BOOL *powerOn);
 
 
 #ifdef __cplusplus
@@ -74,6 +74,23 @@ extern "C" {
 /* defines */
 #define ETH_PHY_TIMEOUT		    10000
 
+/* SMI engine wait budget. One MDIO frame is 64 bits, i.e. ~26usec at the */
+/* default 2.5MHz MDC: poll a few times, then sleep for about one frame    */
+/* with exponential backoff. The frame time is measured at init and the    */
+/* timeout set to ETH_PHY_SMI_TIMEOUT_FRAMES frames, bounded by             */
+/* ETH_PHY_SMI_TIMEOUT_MIN_US and ETH_PHY_SMI_TIMEOUT_US.                   */
+#define ETH_PHY_SMI_SPIN_POLLS		    8
+#define ETH_PHY_SMI_FRAME_US		    26
+#define ETH_PHY_SMI_BACKOFF_MAX_US	    200
+#define ETH_PHY_SMI_TIMEOUT_FRAMES	    64
+#define ETH_PHY_SMI_TIMEOUT_MIN_US	    200
+#define ETH_PHY_SMI_TIMEOUT_US		    10000
+#define ETH_PHY_SMI_CALIBRATE_READS	    16
+
+/* The data field may settle a few bus cycles after read-valid is set: it */
+/* is re-read until two reads agree, at most ETH_PHY_SMI_DATA_READS times. */
+#define ETH_PHY_SMI_DATA_READS		    4
+
 /* registers offsetes defines */
 
 /* SMI register fields (ETH_PHY_SMI_REG) */
@@ -27,6 +27,11 @@ disclaimer.
 
 #include <linux/etherdevice.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/semaphore.h>
 
 #include "os/mvOs.h"
 #include "ctrlEnv/mvCtrlEnvSpec.h"
@@ -59,173 +64,1105 @@ static MV_U32 switch_dbg = 0;
 
 GT_QD_DEV qddev;
 
-static spinlock_t switch_lock;
+/* Run on the software register model instead of the switch hardware */
+static int switch_sim;
+module_param(switch_sim, int, 0444);
+MODULE_PARM_DESC(switch_sim, "Use the software switch register model as MDIO backend");
+
+/* Bus lock: serializes SMI transactions and protects the register shadow. */
+/* Waiting for the SMI unit may sleep, so this is a mutex and the register */
+/* access API must be called from process context. It is held for single   */
+/* register accesses or lists only; multi-access sequences on one table    */
+/* engine (ATU, VTU, PVT, stats, PHY) are serialized by the per-unit GT_SEM */
+/* semaphores in GT_QD_DEV, so different engines can be driven at the same */
+/* time.                                                                   */
+static DEFINE_MUTEX(switch_lock);
+
+/* Guards the SMI command/response window only: issuing a command and      */
+/* fetching the read data. Interrupts are off for a few MMIO accesses.     */
+static DEFINE_SPINLOCK(switch_smi_lock);
+
+/* Backing store of the GT_SEM handles, handle = index + 1 */
+#define MV_SWITCH_SEM_MAX	16
+static struct semaphore	switch_sem[MV_SWITCH_SEM_MAX];
+static MV_U32		switch_sem_used;
+static DEFINE_MUTEX(switch_sem_lock);
 static MV_BOOL initBridgeDone = MV_FALSE;
 
+/* SMI timing. Defaults until mv_switch_smi_calibrate() has measured the    */
+/* transaction time; all waits are ktime deadlines derived from it.        */
+static struct {
+	MV_U32	turnaroundNs;	/* one register read transaction */
+	MV_U32	smiTimeoutNs;	/* SMI unit busy / read valid */
+	MV_U32	regWaitNs;	/* switch register bit polls (table engines) */
+	MV_BOOL	calibrated;
+} switch_smi_timing = {
+	.turnaroundNs	= ETH_PHY_SMI_FRAME_US * NSEC_PER_USEC,
+	.smiTimeoutNs	= ETH_PHY_SMI_TIMEOUT_US * NSEC_PER_USEC,
+	.regWaitNs	= MV_SWITCH_REG_WAIT_MAX_US * NSEC_PER_USEC,
+};
+
+static inline MV_BOOL mvEthSmiReady(MV_U32 mask, MV_U32 value, MV_U32 *smiReg)
+{
+	*smiReg = MV_REG_READ(ETH_SMI_REG(MV_ETH_SMI_PORT));
+	return (*smiReg & mask) == value;
+}
+
+/*******************************************************************************
+* mvEthSmiWait - Wait for the SMI unit to reach a given state.
+*
+* DESCRIPTION:
+*       Waits until (SMI register & mask) == value. The register is polled a
+*       few times and then with a sleeping, exponentially growing backoff that
+*       starts at one MDIO frame time, so the CPU is not held for the whole
+*       transaction.
+*
+* INPUT:
+*       mask  - SMI register bits to test.
+*       value - expected value of the tested bits.
+*
+* OUTPUT:
+*       smiReg - last value read from the SMI register.
+*
+* RETURN:
+*       MV_OK on success, MV_TIMEOUT if the SMI unit did not reach the state
+*       within switch_smi_timing.smiTimeoutNs.
+*
+*******************************************************************************/
+static MV_STATUS mvEthSmiWait(MV_U32 mask, MV_U32 value, MV_U32 *smiReg)
+{
+	s64	deadline;
+	MV_U32	i, delay, frame;
+
+	for (i = 0; i < ETH_PHY_SMI_SPIN_POLLS; i++) {
+		if (mvEthSmiReady(mask, value, smiReg))
+			return MV_OK;
+		cpu_relax();
+	}
+
+	deadline = ktime_to_ns(ktime_get()) + switch_smi_timing.smiTimeoutNs;
+	frame = max_t(MV_U32, switch_smi_timing.turnaroundNs / NSEC_PER_USEC, 1);
+	delay = frame;
+	while (ktime_to_ns(ktime_get()) < deadline) {
+		usleep_range(delay, delay + frame);
+		if (mvEthSmiReady(mask, value, smiReg))
+			return MV_OK;
+		delay = min_t(MV_U32, delay * 2, ETH_PHY_SMI_BACKOFF_MAX_US);
+	}
+
+	return mvEthSmiReady(mask, value, smiReg) ? MV_OK : MV_TIMEOUT;
+}
+
+/*******************************************************************************
+* mvEthSmiIssue - Write an SMI command once the SMI unit is idle.
+*
+* DESCRIPTION:
+*       Waits (possibly sleeping) for the SMI unit to become idle, then
+*       re-checks it and writes the command with interrupts disabled, so
+*       the IRQ-off window covers only the final check and the write. If
+*       another SMI user won the race the wait is repeated.
+*
+* INPUT:
+*       cmd - value for the SMI register.
+*
+* RETURN:
+*       MV_OK on success, MV_BUSY if the SMI unit stayed busy.
+*
+*******************************************************************************/
+static MV_STATUS mvEthSmiIssue(MV_U32 cmd)
+{
+	MV_U32		smiReg;
+	unsigned long	flags;
+
+	while (1) {
+		if (mvEthSmiWait(ETH_PHY_SMI_BUSY_MASK, 0, &smiReg) != MV_OK)
+			return MV_BUSY;
+
+		spin_lock_irqsave(&switch_smi_lock, flags);
+		if (mvEthSmiReady(ETH_PHY_SMI_BUSY_MASK, 0, &smiReg)) {
+			MV_REG_WRITE(ETH_SMI_REG(MV_ETH_SMI_PORT), cmd);
+			spin_unlock_irqrestore(&switch_smi_lock, flags);
+			return MV_OK;
+		}
+		spin_unlock_irqrestore(&switch_smi_lock, flags);
+	}
+}
+
 /*******************************************************************************
 * mvEthPhyRegRead - Read from ethernet phy register.
 *
 * DESCRIPTION:
-*       This function reads ethernet phy register.
-*
-* INPUT:
-*       phyAddr - Phy address.
-*       regOffs - Phy register offset.
-*
-* OUTPUT:
-*       None.
+*       This function reads ethernet phy register.
+*
+* INPUT:
+*       phyAddr - Phy address.
+*       regOffs - Phy register offset.
+*
+* OUTPUT:
+*       data    - 16bit phy register value.
+*
+* RETURN:
+*       MV_OK on success, MV_FAIL on bad parameters, MV_BUSY if the SMI unit
+*       stayed busy, MV_TIMEOUT if the read data did not become valid.
+*
+*******************************************************************************/
+MV_STATUS mvEthPhyRegRead(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 *data)
+{
+	MV_U32 		smiReg, cmd, i, val;
+
+	/* check parameters */
+	if ((phyAddr << ETH_PHY_SMI_DEV_ADDR_OFFS) & ~ETH_PHY_SMI_DEV_ADDR_MASK) {
+		mvOsPrintf("mvEthPhyRegRead: Err. Illegal PHY device address %d\n",
+				phyAddr);
+		return MV_FAIL;
+	}
+	if ((regOffs <<  ETH_PHY_SMI_REG_ADDR_OFFS) & ~ETH_PHY_SMI_REG_ADDR_MASK) {
+		mvOsPrintf("mvEthPhyRegRead: Err. Illegal PHY register offset %d\n",
+				regOffs);
+		return MV_FAIL;
+	}
+
+	/* fill the phy address and regiser offset and read opcode */
+	cmd = (phyAddr <<  ETH_PHY_SMI_DEV_ADDR_OFFS) | (regOffs << ETH_PHY_SMI_REG_ADDR_OFFS)|
+			   ETH_PHY_SMI_OPCODE_READ;
+
+	/* wait till the SMI is not busy and write the smi register */
+	if (mvEthSmiIssue(cmd) != MV_OK) {
+		mvOsPrintf("mvEthPhyRegRead: SMI busy timeout\n");
+		return MV_BUSY;
+	}
+
+	/* wait till the read value is valid */
+	if (mvEthSmiWait(ETH_PHY_SMI_READ_VALID_MASK, ETH_PHY_SMI_READ_VALID_MASK, &smiReg) != MV_OK) {
+		mvOsPrintf("mvEthPhyRegRead: SMI read-valid timeout\n");
+		return MV_TIMEOUT;
+	}
+
+	/* wait for the data to update in the SMI register: re-read until stable */
+	for (i = 0; i < ETH_PHY_SMI_DATA_READS; i++) {
+		val = MV_REG_READ(ETH_SMI_REG(MV_ETH_SMI_PORT));
+		if ((val & ETH_PHY_SMI_DATA_MASK) == (smiReg & ETH_PHY_SMI_DATA_MASK))
+			break;
+		smiReg = val;
+	}
+
+	*data = (MV_U16)(smiReg & ETH_PHY_SMI_DATA_MASK);
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* mvEthPhyRegWrite - Write to ethernet phy register.
+*
+* DESCRIPTION:
+*       This function write to ethernet phy register.
+*
+* INPUT:
+*       phyAddr - Phy address.
+*       regOffs - Phy register offset.
+*       data    - 16bit data.
+*
+* OUTPUT:
+*       None.
+*
+* RETURN:
+*       MV_OK if write succeed, MV_BAD_PARAM on bad parameters , MV_ERROR on error .
+*		MV_BUSY if the SMI unit stayed busy
+*
+*******************************************************************************/
+MV_STATUS mvEthPhyRegWrite(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 data)
+{
+	MV_U32 		smiReg;
+
+	/* check parameters */
+	if ((phyAddr <<  ETH_PHY_SMI_DEV_ADDR_OFFS) & ~ETH_PHY_SMI_DEV_ADDR_MASK) {
+		mvOsPrintf("mvEthPhyRegWrite: Err. Illegal phy address 0x%x\n", phyAddr);
+		return MV_BAD_PARAM;
+	}
+	if ((regOffs <<  ETH_PHY_SMI_REG_ADDR_OFFS) & ~ETH_PHY_SMI_REG_ADDR_MASK) {
+		mvOsPrintf("mvEthPhyRegWrite: Err. Illegal register offset 0x%x\n", regOffs);
+		return MV_BAD_PARAM;
+	}
+
+	/* fill the phy address and regiser offset and write opcode and data*/
+	smiReg = (data << ETH_PHY_SMI_DATA_OFFS);
+	smiReg |= (phyAddr <<  ETH_PHY_SMI_DEV_ADDR_OFFS) | (regOffs << ETH_PHY_SMI_REG_ADDR_OFFS);
+	smiReg &= ~ETH_PHY_SMI_OPCODE_READ;
+
+	/* wait till the SMI is not busy and write the smi register */
+	if (mvEthSmiIssue(smiReg) != MV_OK) {
+		mvOsPrintf("mvEthPhyRegWrite: SMI busy timeout\n");
+		return MV_BUSY;
+	}
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* mvSwitchSem* - GT_SEM routines (FGT_SEM_CREATE/DELETE/TAKE/GIVE).
+*
+* DESCRIPTION:
+*       Counting semaphores backing the per-unit GT_SEM fields of GT_QD_DEV.
+*       A GT_SEM handle is the index of the semaphore plus one, 0 means none.
+*       semTake timeOut is in milliseconds, OS_WAIT_FOREVER waits forever.
+*
+*******************************************************************************/
+static GT_SEM mvSwitchSemCreate(GT_SEM_BEGIN_STATE state)
+{
+	GT_SEM	sem;
+
+	mutex_lock(&switch_sem_lock);
+	for (sem = 0; sem < MV_SWITCH_SEM_MAX; sem++) {
+		if (!MV_BIT_CHECK(switch_sem_used, sem)) {
+			switch_sem_used |= (1 << sem);
+			sema_init(&switch_sem[sem], (state == GT_SEM_FULL) ? 1 : 0);
+			mutex_unlock(&switch_sem_lock);
+			return sem + 1;
+		}
+	}
+	mutex_unlock(&switch_sem_lock);
+
+	return 0;
+}
+
+static MV_STATUS mvSwitchSemDelete(GT_SEM semId)
+{
+	if (semId == 0 || semId > MV_SWITCH_SEM_MAX)
+		return MV_BAD_PARAM;
+
+	mutex_lock(&switch_sem_lock);
+	switch_sem_used &= ~(1 << (semId - 1));
+	mutex_unlock(&switch_sem_lock);
+
+	return MV_OK;
+}
+
+static MV_STATUS mvSwitchSemTake(GT_SEM semId, MV_U32 timOut)
+{
+	if (semId == 0 || semId > MV_SWITCH_SEM_MAX)
+		return MV_BAD_PARAM;
+
+	if (timOut == OS_WAIT_FOREVER) {
+		down(&switch_sem[semId - 1]);
+		return MV_OK;
+	}
+
+	return down_timeout(&switch_sem[semId - 1], msecs_to_jiffies(timOut)) ? MV_TIMEOUT : MV_OK;
+}
+
+static MV_STATUS mvSwitchSemGive(GT_SEM semId)
+{
+	if (semId == 0 || semId > MV_SWITCH_SEM_MAX)
+		return MV_BAD_PARAM;
+
+	up(&switch_sem[semId - 1]);
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* gtSemTake / gtSemGive - Take/give a per-unit semaphore of the device.
+*
+* DESCRIPTION:
+*       No-ops when the device has no semaphore routines or the semaphore
+*       was not created, so a GT_QD_DEV set up without them keeps working.
+*
+*******************************************************************************/
+MV_STATUS gtSemTake(GT_QD_DEV *dev, GT_SEM sem, MV_U32 timOut)
+{
+	if (dev == NULL || dev->semTake == NULL || sem == 0)
+		return MV_OK;
+
+	return dev->semTake(sem, timOut);
+}
+
+MV_STATUS gtSemGive(GT_QD_DEV *dev, GT_SEM sem)
+{
+	if (dev == NULL || dev->semGive == NULL || sem == 0)
+		return MV_OK;
+
+	return dev->semGive(sem);
+}
+
+/* Shadow of the switch port (0x10+p), Global (0x1b) and Global2 (0x1c)    */
+/* register files. Only configuration registers that the hardware never    */
+/* modifies on its own are cached; status, counter, indirect table and     */
+/* self-clearing command registers are always accessed over SMI.           */
+#define SWITCH_SHADOW_FIRST_ADDR	PORT_REGS_START_ADDR_8PORT
+#define SWITCH_SHADOW_LAST_ADDR		(GLOBAL_REGS_START_ADDR_8PORT + 1)
+#define SWITCH_SHADOW_DEVS		(SWITCH_SHADOW_LAST_ADDR - SWITCH_SHADOW_FIRST_ADDR + 1)
+
+/* PCS/jamming control, port control 0/1/2, VLAN map, PVID, rate control, */
+/* PAV, priority override, policy, Ether type, prio remap. Port ATU       */
+/* control (0x0C) is not cached: LimitReached is set by the hardware and  */
+/* ReadLearnCnt turns the register into a read of the learn counter.      */
+#define SWITCH_SHADOW_PORT_REGS		(BIT1 | BIT2 | BIT4 | BIT5 | BIT6 | BIT7 | BIT8 | \
+					 BIT9 | BIT10 | BIT11 | BIT13 | BIT14 |  \
+					 BIT15 | BIT24 | BIT25)
+/* ATU control, IP/IEEE priority mapping, monitor control, control 2 */
+#define SWITCH_SHADOW_GLOBAL_REGS	(BIT10 | BIT16 | BIT17 | BIT18 | BIT19 | BIT20 | \
+					 BIT21 | BIT22 | BIT23 | BIT24 | BIT26 | BIT28)
+/* interrupt mask, management enables, management control */
+#define SWITCH_SHADOW_GLOBAL2_REGS	(BIT1 | BIT2 | BIT3 | BIT5)
+
+static struct {
+	MV_U32	valid[SWITCH_SHADOW_DEVS];
+	MV_U16	regs[SWITCH_SHADOW_DEVS][32];
+} switch_shadow;
+
+static MV_U32 mvSwitchShadowRegs(MV_U32 phyAddr)
+{
+	if (phyAddr < SWITCH_SHADOW_FIRST_ADDR || phyAddr > SWITCH_SHADOW_LAST_ADDR)
+		return 0;
+	if (phyAddr == GLOBAL_REGS_START_ADDR_8PORT)
+		return SWITCH_SHADOW_GLOBAL_REGS;
+	if (phyAddr == GLOBAL_REGS_START_ADDR_8PORT + 1)
+		return SWITCH_SHADOW_GLOBAL2_REGS;
+	return SWITCH_SHADOW_PORT_REGS;
+}
+
+static inline MV_BOOL mvSwitchShadowable(MV_U32 phyAddr, MV_U32 regOffs)
+{
+	return (mvSwitchShadowRegs(phyAddr) & (1 << regOffs)) ? MV_TRUE : MV_FALSE;
+}
+
+/*******************************************************************************
+* mv_switch_shadow_invalidate - Drop all cached switch register values.
+*
+* DESCRIPTION:
+*       Must be called whenever the switch registers may have been changed
+*       behind the driver's back, e.g. after a switch reset or raw SMI access.
+*
+*******************************************************************************/
+void mv_switch_shadow_invalidate(void)
+{
+	mutex_lock(&switch_lock);
+	memset(switch_shadow.valid, 0, sizeof(switch_shadow.valid));
+	mutex_unlock(&switch_lock);
+}
+
+/* Drops the shadow of registers written behind the shadow, e.g. over RMU */
+static void mvSwitchShadowDrop(HW_DEV_RW_REG *list, MV_U32 entries)
+{
+	MV_U32 i;
+
+	mutex_lock(&switch_lock);
+	for (i = 0; i < entries; i++)
+		if (list[i].cmd == HW_REG_WRITE && mvSwitchShadowable(list[i].addr, list[i].reg))
+			switch_shadow.valid[list[i].addr - SWITCH_SHADOW_FIRST_ADDR] &= ~(1 << list[i].reg);
+	mutex_unlock(&switch_lock);
+}
+
+/* SMI transaction statistics per MV_SWITCH_*_ACCESS type, under switch_lock */
+static MV_SWITCH_SMI_STATS switch_smi_stats[MV_SWITCH_SMI_ACCESS + 1];
+
+static const char *switch_smi_type_name[MV_SWITCH_SMI_ACCESS + 1] = {
+	"", "phy", "port", "global", "global2", "smi"
+};
+
+/* MV_SWITCH_*_ACCESS type of an SMI device address */
+static inline MV_SWITCH_SMI_STATS *mvSwitchSmiStats(MV_U32 phyAddr)
+{
+	if (phyAddr < PORT_REGS_START_ADDR_8PORT)
+		return &switch_smi_stats[MV_SWITCH_PHY_ACCESS];
+	if (phyAddr == GLOBAL_REGS_START_ADDR_8PORT)
+		return &switch_smi_stats[MV_SWITCH_GLOBAL_ACCESS];
+	if (phyAddr == GLOBAL_REGS_START_ADDR_8PORT + 1)
+		return &switch_smi_stats[MV_SWITCH_GLOBAL2_ACCESS];
+
+	return &switch_smi_stats[MV_SWITCH_PORT_ACCESS];
+}
+
+/* Accounts one SMI transaction started at 'start' */
+static void mvSwitchSmiStatsUpdate(MV_SWITCH_SMI_STATS *stats, MV_U32 *counter,
+				   ktime_t start, MV_STATUS status)
+{
+	s64	us = ktime_us_delta(ktime_get(), start);
+	int	bucket = (us > 0) ? fls64(us) : 0;
+
+	(*counter)++;
+	if (status == MV_BUSY)
+		stats->busyTimeouts++;
+	else if (status == MV_TIMEOUT)
+		stats->readTimeouts++;
+	else if (status != MV_OK)
+		stats->errors++;
+
+	stats->hist[min_t(int, bucket, MV_SWITCH_SMI_HIST_BUCKETS - 1)]++;
+}
+
+/*******************************************************************************
+* mvSwitchMiiRead / mvSwitchMiiWrite - Raw register access through the backend.
+*
+* DESCRIPTION:
+*       Dispatches to GT_QD_DEV::fgtReadMii/fgtWriteMii when a backend is
+*       installed (e.g. the software register model, see mv_switch_sim.c),
+*       and to the SoC SMI unit otherwise. Must be called with switch_lock
+*       held.
+*
+*******************************************************************************/
+static MV_STATUS mvSwitchMiiRead(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 *data)
+{
+	MV_SWITCH_SMI_STATS	*stats = mvSwitchSmiStats(phyAddr);
+	ktime_t			start = ktime_get();
+	unsigned int		value;
+	MV_STATUS		status;
+
+	if (qddev.fgtReadMii == NULL) {
+		status = mvEthPhyRegRead(phyAddr, regOffs, data);
+	} else if (qddev.fgtReadMii(&qddev, phyAddr, regOffs, &value)) {
+		*data = (MV_U16)value;
+		status = MV_OK;
+	} else {
+		status = MV_FAIL;
+	}
+
+	mvSwitchSmiStatsUpdate(stats, &stats->reads, start, status);
+	return status;
+}
+
+static MV_STATUS mvSwitchMiiWrite(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 data)
+{
+	MV_SWITCH_SMI_STATS	*stats = mvSwitchSmiStats(phyAddr);
+	ktime_t			start = ktime_get();
+	MV_STATUS		status;
+
+	if (qddev.fgtWriteMii == NULL)
+		status = mvEthPhyRegWrite(phyAddr, regOffs, data);
+	else
+		status = qddev.fgtWriteMii(&qddev, phyAddr, regOffs, data) ? MV_OK : MV_FAIL;
+
+	mvSwitchSmiStatsUpdate(stats, &stats->writes, start, status);
+	return status;
+}
+
+/*******************************************************************************
+* mv_switch_smi_stats_show - Format the SMI transaction statistics.
+*
+* DESCRIPTION:
+*       One line of counters per access type followed by the latency
+*       histogram: bucket 0 counts transactions under 1us, bucket i those
+*       of [2^(i-1), 2^i) us, the last bucket everything slower.
+*
+* RETURN:
+*       Number of characters written to buf.
+*
+*******************************************************************************/
+int mv_switch_smi_stats_show(char *buf)
+{
+	MV_SWITCH_SMI_STATS	*stats;
+	int			off = 0, type, i;
+
+	mutex_lock(&switch_lock);
+	off += sprintf(buf + off, "timing%s: turnaround %u ns, smi timeout %u us, wait timeout %u us\n",
+		       switch_smi_timing.calibrated ? "" : " (default)", switch_smi_timing.turnaroundNs,
+		       (MV_U32)(switch_smi_timing.smiTimeoutNs / NSEC_PER_USEC),
+		       (MV_U32)(switch_smi_timing.regWaitNs / NSEC_PER_USEC));
+	for (type = MV_SWITCH_PHY_ACCESS; type <= MV_SWITCH_SMI_ACCESS; type++) {
+		stats = &switch_smi_stats[type];
+		off += sprintf(buf + off, "%-8s reads %u writes %u rmws %u cached %u timeouts busy %u read %u wait %u errors %u\n",
+			       switch_smi_type_name[type], stats->reads, stats->writes, stats->rmws,
+			       stats->cached, stats->busyTimeouts, stats->readTimeouts,
+			       stats->waitTimeouts, stats->errors);
+		off += sprintf(buf + off, "%-8s us:", "");
+		for (i = 0; i < MV_SWITCH_SMI_HIST_BUCKETS; i++)
+			off += sprintf(buf + off, " %u", stats->hist[i]);
+		off += sprintf(buf + off, "\n");
+	}
+	mutex_unlock(&switch_lock);
+
+	return off;
+}
+
+void mv_switch_smi_stats_clear(void)
+{
+	mutex_lock(&switch_lock);
+	memset(switch_smi_stats, 0, sizeof(switch_smi_stats));
+	mutex_unlock(&switch_lock);
+}
+
+/* One SMI read, timed from the command write to read-valid by busy polling */
+static MV_STATUS mvEthSmiTimedRead(MV_U32 phyAddr, MV_U32 regOffs, s64 *ns)
+{
+	MV_U32	cmd;
+	s64	start, deadline;
+
+	cmd = (phyAddr << ETH_PHY_SMI_DEV_ADDR_OFFS) | (regOffs << ETH_PHY_SMI_REG_ADDR_OFFS) |
+	      ETH_PHY_SMI_OPCODE_READ;
+	if (mvEthSmiIssue(cmd) != MV_OK)
+		return MV_BUSY;
+
+	start = ktime_to_ns(ktime_get());
+	deadline = start + ETH_PHY_SMI_TIMEOUT_US * NSEC_PER_USEC;
+	while (!(MV_REG_READ(ETH_SMI_REG(MV_ETH_SMI_PORT)) & ETH_PHY_SMI_READ_VALID_MASK)) {
+		if (ktime_to_ns(ktime_get()) >= deadline)
+			return MV_TIMEOUT;
+		cpu_relax();
+	}
+	*ns = ktime_to_ns(ktime_get()) - start;
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* mv_switch_smi_calibrate - Measure the SMI transaction time, derive timeouts.
+*
+* DESCRIPTION:
+*       Times ETH_PHY_SMI_CALIBRATE_READS reads of the port 0 switch
+*       identifier register and takes the fastest as the turnaround time
+*       (the others include preemption and bus contention). On the SMI unit
+*       the time runs from the command write to read-valid, busy-polled, so
+*       it is the MDIO transaction and not the sleeping backoff of the
+*       regular waits; a register model backend is timed per read. The SMI unit
+*       timeout becomes ETH_PHY_SMI_TIMEOUT_FRAMES turnarounds and the
+*       register poll timeout MV_SWITCH_BATCH_WAIT_POLLS turnarounds, both
+*       bounded, so the waits scale with the MDC clock instead of the CPU
+*       clock.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_smi_calibrate(void)
+{
+	ktime_t		start;
+	s64		ns, best = 0;
+	MV_U16		data;
+	MV_U32		i;
+	MV_STATUS	status = MV_OK;
+
+	mutex_lock(&switch_lock);
+	for (i = 0; i < ETH_PHY_SMI_CALIBRATE_READS; i++) {
+		if (qddev.fgtReadMii == NULL)
+			status = mvEthSmiTimedRead(PORT_REGS_START_ADDR_8PORT, QD_REG_SWITCH_ID, &ns);
+		else {
+			start = ktime_get();
+			status = mvSwitchMiiRead(PORT_REGS_START_ADDR_8PORT, QD_REG_SWITCH_ID, &data);
+			ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		}
+		if (status != MV_OK)
+			break;
+		if (best == 0 || ns < best)
+			best = ns;
+	}
+
+	if (status == MV_OK) {
+		switch_smi_timing.turnaroundNs = max_t(s64, best, 1);
+		switch_smi_timing.smiTimeoutNs =
+			clamp_t(s64, best * ETH_PHY_SMI_TIMEOUT_FRAMES, ETH_PHY_SMI_TIMEOUT_MIN_US * NSEC_PER_USEC,
+				ETH_PHY_SMI_TIMEOUT_US * NSEC_PER_USEC);
+		switch_smi_timing.regWaitNs =
+			clamp_t(s64, best * MV_SWITCH_BATCH_WAIT_POLLS, MV_SWITCH_REG_WAIT_MIN_US * NSEC_PER_USEC,
+				MV_SWITCH_REG_WAIT_MAX_US * NSEC_PER_USEC);
+		switch_smi_timing.calibrated = MV_TRUE;
+	}
+	mutex_unlock(&switch_lock);
+
+	if (status != MV_OK)
+		printk(KERN_ERR "%s: SMI read failed (%d), keeping default timeouts\n", __func__, status);
+
+	return status;
+}
+
+/* Shadow aware register read/write. Must be called with switch_lock held. */
+static MV_STATUS mvSwitchRegRead(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 *data)
+{
+	MV_U32		dev = phyAddr - SWITCH_SHADOW_FIRST_ADDR;
+	MV_STATUS	status;
+
+	if (!mvSwitchShadowable(phyAddr, regOffs))
+		return mvSwitchMiiRead(phyAddr, regOffs, data);
+
+	if (switch_shadow.valid[dev] & (1 << regOffs)) {
+		*data = switch_shadow.regs[dev][regOffs];
+		mvSwitchSmiStats(phyAddr)->cached++;
+		return MV_OK;
+	}
+
+	status = mvSwitchMiiRead(phyAddr, regOffs, data);
+	if (status == MV_OK) {
+		switch_shadow.regs[dev][regOffs] = *data;
+		switch_shadow.valid[dev] |= (1 << regOffs);
+	}
+	return status;
+}
+
+static MV_STATUS mvSwitchRegWrite(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 data)
+{
+	MV_U32		dev = phyAddr - SWITCH_SHADOW_FIRST_ADDR;
+	MV_STATUS	status;
+
+	if (!mvSwitchShadowable(phyAddr, regOffs))
+		return mvSwitchMiiWrite(phyAddr, regOffs, data);
+
+	/* the register already holds this value */
+	if ((switch_shadow.valid[dev] & (1 << regOffs)) &&
+	    (switch_shadow.regs[dev][regOffs] == data)) {
+		mvSwitchSmiStats(phyAddr)->cached++;
+		return MV_OK;
+	}
+
+	status = mvSwitchMiiWrite(phyAddr, regOffs, data);
+	if (status == MV_OK) {
+		switch_shadow.regs[dev][regOffs] = data;
+		switch_shadow.valid[dev] |= (1 << regOffs);
+	} else {
+		switch_shadow.valid[dev] &= ~(1 << regOffs);
+	}
+	return status;
+}
+
+/* Batch deferring the calling task's register writes, see mv_switch_batch_begin() */
+static DEFINE_MUTEX(switch_batch_lock);
+static MV_SWITCH_BATCH		*switch_batch;
+static struct task_struct	*switch_batch_owner;
+
+static inline MV_SWITCH_BATCH *mv_switch_batch_get(void)
+{
+	return (switch_batch_owner == current) ? switch_batch : NULL;
+}
+
+/*******************************************************************************
+* mvSwitchRegWait - Poll a register bit until it reaches a given value.
+*
+* DESCRIPTION:
+*       Implements HW_REG_WAIT_TILL_0 / HW_REG_WAIT_TILL_1. Must be called
+*       with switch_lock held.
+*
+*******************************************************************************/
+static MV_STATUS mvSwitchRegWait(MV_U32 phyAddr, MV_U32 regOffs, MV_U32 bit, MV_U16 value)
+{
+	s64		deadline = ktime_to_ns(ktime_get()) + switch_smi_timing.regWaitNs;
+	MV_U16		data;
+	MV_STATUS	status;
+
+	do {
+		status = mvSwitchMiiRead(phyAddr, regOffs, &data);
+		if (status != MV_OK)
+			return status;
+		if (((data >> bit) & 1) == value)
+			return MV_OK;
+	} while (ktime_to_ns(ktime_get()) < deadline);
+
+	mvSwitchSmiStats(phyAddr)->waitTimeouts++;
+	return MV_NOT_READY;
+}
+
+/*******************************************************************************
+* mvSwitchMultiChipAccess - Access a switch register in multi-chip mode.
+*
+* DESCRIPTION:
+*       In SMI_MULTI_ADDR_MODE the switch only answers at its own SMI address
+*       (GT_QD_DEV::phyAddr) through the SMI command/data register pair, so
+*       that several switches can share one MDIO bus. The internal device
+*       address and register are passed in the command register. Must be
+*       called with switch_lock held.
+*
+* INPUT:
+*       smiAddr - SMI address of the switch (dev->phyAddr).
+*       devAddr - internal device address (PHY, port, Global, Global2).
+*       regOffs - register offset.
+*       op      - QD_SMI_READ or QD_SMI_WRITE.
+*       data    - value to write (QD_SMI_WRITE).
+*
+* OUTPUT:
+*       data    - value read (QD_SMI_READ).
+*
+*******************************************************************************/
+static MV_STATUS mvSwitchMultiChipAccess(MV_U32 smiAddr, MV_U32 devAddr, MV_U32 regOffs,
+					 MV_U32 op, MV_U16 *data)
+{
+	MV_U16		cmd;
+	MV_STATUS	status;
+
+	status = mvSwitchRegWait(smiAddr, QD_REG_SMI_COMMAND, 15, 0);
+	if (status != MV_OK)
+		return status;
+
+	if (op == QD_SMI_WRITE) {
+		status = mvSwitchMiiWrite(smiAddr, QD_REG_SMI_DATA, *data);
+		if (status != MV_OK)
+			return status;
+	}
+
+	cmd = (MV_U16)(QD_SMI_BUSY | (QD_SMI_CLAUSE22 << QD_SMI_MODE_BIT) |
+		       (op << QD_SMI_OP_BIT) | (devAddr << QD_SMI_DEV_ADDR_BIT) |
+		       (regOffs << QD_SMI_REG_ADDR_BIT));
+	status = mvSwitchMiiWrite(smiAddr, QD_REG_SMI_COMMAND, cmd);
+	if (status != MV_OK)
+		return status;
+
+	status = mvSwitchRegWait(smiAddr, QD_REG_SMI_COMMAND, 15, 0);
+	if (status != MV_OK || op != QD_SMI_READ)
+		return status;
+
+	return mvSwitchMiiRead(smiAddr, QD_REG_SMI_DATA, data);
+}
+
+static inline MV_BOOL mvSwitchMultiChip(GT_QD_DEV *dev)
+{
+	return (dev != NULL && dev->accessMode == SMI_MULTI_ADDR_MODE) ? MV_TRUE : MV_FALSE;
+}
+
+/* Device aware register access. Must be called with switch_lock held. */
+static MV_STATUS mvSwitchDevRegRead(GT_QD_DEV *dev, MV_U32 devAddr, MV_U32 regOffs, MV_U16 *data)
+{
+	if (mvSwitchMultiChip(dev))
+		return mvSwitchMultiChipAccess(dev->phyAddr, devAddr, regOffs, QD_SMI_READ, data);
+
+	return mvSwitchRegRead(devAddr, regOffs, data);
+}
+
+static MV_STATUS mvSwitchDevRegWrite(GT_QD_DEV *dev, MV_U32 devAddr, MV_U32 regOffs, MV_U16 data)
+{
+	if (mvSwitchMultiChip(dev))
+		return mvSwitchMultiChipAccess(dev->phyAddr, devAddr, regOffs, QD_SMI_WRITE, &data);
+
+	return mvSwitchRegWrite(devAddr, regOffs, data);
+}
+
+static MV_STATUS mvSwitchDevRegWait(GT_QD_DEV *dev, MV_U32 devAddr, MV_U32 regOffs,
+				    MV_U32 bit, MV_U16 value)
+{
+	s64		deadline;
+	MV_U16		data;
+	MV_STATUS	status;
+
+	if (!mvSwitchMultiChip(dev))
+		return mvSwitchRegWait(devAddr, regOffs, bit, value);
+
+	deadline = ktime_to_ns(ktime_get()) + switch_smi_timing.regWaitNs;
+	do {
+		status = mvSwitchMultiChipAccess(dev->phyAddr, devAddr, regOffs, QD_SMI_READ, &data);
+		if (status != MV_OK)
+			return status;
+		if (((data >> bit) & 1) == value)
+			return MV_OK;
+	} while (ktime_to_ns(ktime_get()) < deadline);
+
+	mvSwitchSmiStats(devAddr)->waitTimeouts++;
+	return MV_NOT_READY;
+}
+
+/* Execute a register list under one switch_lock hold, see mv_switch_dev_rw_reg_list */
+static MV_STATUS mvSwitchRwRegList(GT_QD_DEV *dev, HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed)
+{
+	MV_U32		i;
+	MV_U16		data, mask;
+	MV_STATUS	status = MV_OK;
+
+	mutex_lock(&switch_lock);
+	for (i = 0; i < entries; i++) {
+		switch (list[i].cmd) {
+		case HW_REG_READ:
+			status = mvSwitchDevRegRead(dev, list[i].addr, list[i].reg, &data);
+			list[i].data = data;
+			break;
+
+		case HW_REG_WRITE:
+			status = mvSwitchDevRegWrite(dev, list[i].addr, list[i].reg, (MV_U16)list[i].data);
+			break;
+
+		case HW_REG_WAIT_TILL_0:
+		case HW_REG_WAIT_TILL_1:
+			status = mvSwitchDevRegWait(dev, list[i].addr, list[i].reg, list[i].data,
+						    (list[i].cmd == HW_REG_WAIT_TILL_1) ? 1 : 0);
+			break;
+
+		case HW_REG_RMW:
+			mvSwitchSmiStats(list[i].addr)->rmws++;
+			mask = (MV_U16)(list[i].data >> 16);
+			if (mask == 0xFFFF) {
+				/* full register update, no need to read it */
+				status = mvSwitchDevRegWrite(dev, list[i].addr, list[i].reg,
+							     (MV_U16)list[i].data);
+				break;
+			}
+			status = mvSwitchDevRegRead(dev, list[i].addr, list[i].reg, &data);
+			if (status != MV_OK)
+				break;
+			data = (data & ~mask) | ((MV_U16)list[i].data & mask);
+			status = mvSwitchDevRegWrite(dev, list[i].addr, list[i].reg, data);
+			break;
+
+		default:
+			status = MV_BAD_PARAM;
+			break;
+		}
+		if (status != MV_OK)
+			break;
+	}
+	mutex_unlock(&switch_lock);
+
+	if (failed)
+		*failed = i;
+
+	return status;
+}
+
+/*******************************************************************************
+* mv_switch_dev_rw_reg_list - Execute a list of register operations.
+*
+* DESCRIPTION:
+*       Executes the operations back-to-back under a single acquisition of
+*       switch_lock. Stops at the first failing operation. Addresses are
+*       internal switch device addresses (see portToSmiMapping); when 'dev'
+*       is in SMI_MULTI_ADDR_MODE they are reached indirectly through the
+*       SMI command/data registers at dev->phyAddr. A batch opened by the
+*       caller is executed first. Lists of MV_SWITCH_RMU_MIN_OPS or more
+*       operations go in one RMU request frame when RMU is running; they
+*       are redone over SMI only when the request could not be sent. An
+*       unanswered request may have been executed and is not repeated.
+*
+* INPUT:
+*       dev     - switch device, or NULL for direct addressing.
+*       list    - operations (cmd, SMI address, register, data).
+*                 HW_REG_READ       - data is set to the value read.
+*                 HW_REG_WRITE      - data is written.
+*                 HW_REG_WAIT_TILL_0/1 - wait until bit 'data' is 0/1.
+*                 HW_REG_RMW        - data = (mask << 16) | value; only the
+*                                     mask bits are replaced with value.
+*       entries - number of operations in the list.
+*
+* OUTPUT:
+*       failed  - index of the failing operation, or entries on success.
+*                 May be NULL.
+*
+* RETURN:
+*       MV_OK on success, the status of the failing operation otherwise.
+*       MV_TIMEOUT means that it is not known which operations were done
+*       (unanswered RMU request); failed is 0 then and the list must be
+*       failed as a whole, without a retry.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_dev_rw_reg_list(GT_QD_DEV *dev, HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed)
+{
+	MV_SWITCH_BATCH	*batch = mv_switch_batch_get();
+	MV_STATUS	status;
+
+	if (batch) {
+		status = mv_switch_batch_exec(batch);
+		if (status != MV_OK)
+			return status;
+	}
+
+	if (!mvSwitchMultiChip(dev) && entries >= MV_SWITCH_RMU_MIN_OPS) {
+		status = mv_switch_rmu_rw_reg_list(list, entries, failed);
+		/* only a request that never left can be redone over SMI */
+		if (status != MV_NOT_READY && status != MV_TX_ERROR) {
+			mvSwitchShadowDrop(list, entries);
+			return status;
+		}
+	}
+
+	return mvSwitchRwRegList(dev, list, entries, failed);
+}
+
+MV_STATUS mv_switch_rw_reg_list(HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed)
+{
+	return mv_switch_dev_rw_reg_list(NULL, list, entries, failed);
+}
+
+/* Same as mv_switch_rw_reg_list, but always over SMI (used by the RMU stand-in) */
+MV_STATUS mv_switch_smi_rw_reg_list(HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed)
+{
+	return mvSwitchRwRegList(NULL, list, entries, failed);
+}
+
+/*******************************************************************************
+* mv_switch_hw_access - FGT_HW_ACCESS compatible batch register access.
+*
+*******************************************************************************/
+MV_BOOL mv_switch_hw_access(GT_QD_DEV *dev, HW_DEV_REG_ACCESS *regList)
+{
+	if (regList->entries > MAX_ACCESS_REG_NUM)
+		return MV_FALSE;
+
+	return mv_switch_dev_rw_reg_list(dev, regList->rw_reg_list, regList->entries, NULL) == MV_OK;
+}
+
+/*******************************************************************************
+* mvSwitchBatchMerge - Coalesce a register update with a queued one.
+*
+* DESCRIPTION:
+*       A write or RMW of a shadowed configuration register is merged into
+*       the last queued operation when that is a write/RMW of the same
+*       register. Consecutive field updates of one register thus result in
+*       a single SMI write, while the batch stays an ordered replay of the
+*       register stream: an update is never moved across an access to any
+*       other register (e.g. a port disable around an ATU flush).
 *
 * RETURN:
-*       16bit phy register value, or 0xffff on error
+*       MV_TRUE if the operation was merged and must not be queued.
 *
 *******************************************************************************/
-MV_STATUS mvEthPhyRegRead(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 *data)
+static MV_BOOL mvSwitchBatchMerge(MV_SWITCH_BATCH *batch, MV_U32 cmd, MV_U32 phyAddr,
+				  MV_U32 regOffs, MV_U32 data)
 {
-	MV_U32 		smiReg;
-	volatile MV_U32 timeout;
-
-	/* check parameters */
-	if ((phyAddr << ETH_PHY_SMI_DEV_ADDR_OFFS) & ~ETH_PHY_SMI_DEV_ADDR_MASK) {
-		mvOsPrintf("mvEthPhyRegRead: Err. Illegal PHY device address %d\n",
-				phyAddr);
-		return MV_FAIL;
+	HW_DEV_RW_REG	*op;
+	MV_U32		mask, oldMask;
+
+	if ((cmd != HW_REG_WRITE && cmd != HW_REG_RMW) || !mvSwitchShadowable(phyAddr, regOffs))
+		return MV_FALSE;
+	if (batch->entries == 0)
+		return MV_FALSE;
+
+	op = &batch->list[batch->entries - 1];
+	if (op->addr != phyAddr || op->reg != regOffs ||
+	    (op->cmd != HW_REG_WRITE && op->cmd != HW_REG_RMW))
+		return MV_FALSE;
+
+	mask = (cmd == HW_REG_WRITE) ? 0xFFFF : (data >> 16);
+	oldMask = (op->cmd == HW_REG_WRITE) ? 0xFFFF : (op->data >> 16);
+	data = ((op->data & ~mask) | (data & mask)) & 0xFFFF;
+	mask |= oldMask;
+
+	if (mask == 0xFFFF) {
+		op->cmd = HW_REG_WRITE;
+		op->data = data;
+	} else {
+		op->cmd = HW_REG_RMW;
+		op->data = (mask << 16) | data;
 	}
-	if ((regOffs <<  ETH_PHY_SMI_REG_ADDR_OFFS) & ~ETH_PHY_SMI_REG_ADDR_MASK) {
-		mvOsPrintf("mvEthPhyRegRead: Err. Illegal PHY register offset %d\n",
-				regOffs);
-		return MV_FAIL;
-	}
-
-	timeout = ETH_PHY_TIMEOUT;
-	/* wait till the SMI is not busy*/
-	do {
-		/* read smi register */
-		smiReg = MV_REG_READ( ETH_SMI_REG(MV_ETH_SMI_PORT));    
-		if (timeout-- == 0) {
-			mvOsPrintf("mvEthPhyRegRead: SMI busy timeout\n");
-			return MV_FAIL;
-		}
-	} while (smiReg & ETH_PHY_SMI_BUSY_MASK);
-
-	/* fill the phy address and regiser offset and read opcode */
-	smiReg = (phyAddr <<  ETH_PHY_SMI_DEV_ADDR_OFFS) | (regOffs << ETH_PHY_SMI_REG_ADDR_OFFS)|
-			   ETH_PHY_SMI_OPCODE_READ;
+	return MV_TRUE;
+}
 
-	/* write the smi register */
-	MV_REG_WRITE( ETH_SMI_REG(MV_ETH_SMI_PORT), smiReg); 
+/*******************************************************************************
+* mv_switch_batch_add - Queue a register operation into a batch.
+*
+* DESCRIPTION:
+*       Appends one operation (see mv_switch_rw_reg_list for cmd/data). A full
+*       batch is executed first to make room.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_batch_add(MV_SWITCH_BATCH *batch, MV_U32 cmd, MV_U32 phyAddr,
+			      MV_U32 regOffs, MV_U32 data)
+{
+	HW_DEV_RW_REG	*op;
+	MV_STATUS	status;
 
-	timeout = 0xffffffff; //ETH_PHY_TIMEOUT;
+	if (mvSwitchBatchMerge(batch, cmd, phyAddr, regOffs, data))
+		return MV_OK;
 
-	/*wait till readed value is ready */
-	do {
-		/* read smi register */
-		smiReg = MV_REG_READ( ETH_SMI_REG(MV_ETH_SMI_PORT));   
+	if (batch->entries == MV_SWITCH_BATCH_MAX_OPS) {
+		status = mv_switch_batch_exec(batch);
+		if (status != MV_OK)
+			return status;
+	}
 
-		if (timeout-- == 0) {
-			mvOsPrintf("mvEthPhyRegRead: SMI read-valid timeout\n");
-			return MV_FAIL;
-		}
-	} while (!(smiReg & ETH_PHY_SMI_READ_VALID_MASK));
+	op = &batch->list[batch->entries++];
+	op->cmd = cmd;
+	op->addr = phyAddr;
+	op->reg = regOffs;
+	op->data = data;
 
-	/* Wait for the data to update in the SMI register */
-	for (timeout = 0; timeout < ETH_PHY_TIMEOUT; timeout++)
-		;
+	return MV_OK;
+}
 
-        *data = (MV_U16)(MV_REG_READ( ETH_SMI_REG(MV_ETH_SMI_PORT)) & ETH_PHY_SMI_DATA_MASK); 
+/*******************************************************************************
+* mv_switch_batch_exec - Execute and empty a batch.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_batch_exec(MV_SWITCH_BATCH *batch)
+{
+	MV_U32		failed;
+	MV_STATUS	status;
+
+	if (batch->entries == 0)
+		return MV_OK;
+
+	status = mvSwitchRwRegList(NULL, batch->list, batch->entries, &failed);
+	if (status != MV_OK) {
+		printk(KERN_ERR "%s: op %d (cmd %ld, smi 0x%lx, reg 0x%lx) failed, status=%d\n",
+		       __func__, failed, batch->list[failed].cmd, batch->list[failed].addr,
+		       batch->list[failed].reg, status);
+		batch->failed = status;
+	}
+	batch->entries = 0;
 
-	return MV_OK;
+	return status;
 }
 
 /*******************************************************************************
-* mvEthPhyRegWrite - Write to ethernet phy register.
+* mv_switch_batch_begin - Start deferring register writes of the caller.
 *
 * DESCRIPTION:
-*       This function write to ethernet phy register.
+*       Until mv_switch_batch_end() is called, mv_switch_mii_write() and
+*       mv_switch_mii_write_RegField() issued by the calling task are queued
+*       into 'batch' instead of being executed, so that sequences of g*
+*       helper calls run as a few lock acquisitions. Reads flush the batch
+*       first to preserve ordering. Writes return MV_OK when queued, errors
+*       are reported by the flushing read or by mv_switch_batch_end().
+*       Other tasks are not affected; only one batch may be open at a time.
 *
-* INPUT:
-*       phyAddr - Phy address.
-*       regOffs - Phy register offset.
-*       data    - 16bit data.
-*
-* OUTPUT:
-*       None.
+*******************************************************************************/
+void mv_switch_batch_begin(MV_SWITCH_BATCH *batch)
+{
+	mutex_lock(&switch_batch_lock);
+	batch->entries = 0;
+	batch->failed = MV_OK;
+	switch_batch = batch;
+	switch_batch_owner = current;
+}
+
+/*******************************************************************************
+* mv_switch_batch_end - Execute the open batch and stop deferring writes.
 *
 * RETURN:
-*       MV_OK if write succeed, MV_BAD_PARAM on bad parameters , MV_ERROR on error .
-*		MV_TIMEOUT on timeout
+*       MV_OK if every queued operation of the batch succeeded, the status of
+*       the first failure otherwise.
 *
 *******************************************************************************/
-MV_STATUS mvEthPhyRegWrite(MV_U32 phyAddr, MV_U32 regOffs, MV_U16 data)
+MV_STATUS mv_switch_batch_end(void)
 {
-	MV_U32 		smiReg;
-	volatile MV_U32 timeout;
-
-	/* check parameters */
-	if ((phyAddr <<  ETH_PHY_SMI_DEV_ADDR_OFFS) & ~ETH_PHY_SMI_DEV_ADDR_MASK) {
-		mvOsPrintf("mvEthPhyRegWrite: Err. Illegal phy address 0x%x\n", phyAddr);
-		return MV_BAD_PARAM;
-	}
-	if ((regOffs <<  ETH_PHY_SMI_REG_ADDR_OFFS) & ~ETH_PHY_SMI_REG_ADDR_MASK) {
-		mvOsPrintf("mvEthPhyRegWrite: Err. Illegal register offset 0x%x\n", regOffs);
-		return MV_BAD_PARAM;
-	}
-
-	timeout = ETH_PHY_TIMEOUT;
-
-	/* wait till the SMI is not busy*/
-	do {
-		/* read smi register */
-		smiReg = MV_REG_READ( ETH_SMI_REG(MV_ETH_SMI_PORT));   
-		if (timeout-- == 0) {
-			mvOsPrintf("mvEthPhyRegWrite: SMI busy timeout\n");
-		return MV_TIMEOUT;
-		}
-	} while (smiReg & ETH_PHY_SMI_BUSY_MASK);
+	MV_SWITCH_BATCH	*batch = switch_batch;
+	MV_STATUS	status;
 
-	/* fill the phy address and regiser offset and write opcode and data*/
-	smiReg = (data << ETH_PHY_SMI_DATA_OFFS);
-	smiReg |= (phyAddr <<  ETH_PHY_SMI_DEV_ADDR_OFFS) | (regOffs << ETH_PHY_SMI_REG_ADDR_OFFS);
-	smiReg &= ~ETH_PHY_SMI_OPCODE_READ;
+	mv_switch_batch_exec(batch);
+	status = batch->failed;
 
-	/* write the smi register */
-	MV_REG_WRITE( ETH_SMI_REG(MV_ETH_SMI_PORT), smiReg);  
+	switch_batch = NULL;
+	switch_batch_owner = NULL;
+	mutex_unlock(&switch_batch_lock);
 
-	return MV_OK;
+	return status;
 }
 
 MV_STATUS mv_switch_mii_read( unsigned int phy, unsigned int reg, unsigned int *data)
 {
-	unsigned long	flags;
+	MV_SWITCH_BATCH	*batch = mv_switch_batch_get();
+	MV_U16		value;
 	MV_STATUS 	status;
 
-	spin_lock_irqsave(&switch_lock, flags);
-	status = mvEthPhyRegRead(phy, reg, (MV_U16 *) data);
-	spin_unlock_irqrestore(&switch_lock, flags);
+	if (batch) {
+		status = mv_switch_batch_exec(batch);
+		if (status != MV_OK)
+			return status;
+	}
+
+	mutex_lock(&switch_lock);
+	status = mvSwitchRegRead(phy, reg, &value);
+	mutex_unlock(&switch_lock);
+
+	/* all of *data: callers test and shift it as a whole */
+	if (status == MV_OK)
+		*data = value;
 
 	return status;
 }
 
 MV_STATUS mv_switch_mii_write( unsigned int phy, unsigned int reg, unsigned int data)
 {
-	unsigned long	flags;
+	MV_SWITCH_BATCH	*batch = mv_switch_batch_get();
 	MV_STATUS 	status;
 
-	spin_lock_irqsave(&switch_lock, flags);
-	status = mvEthPhyRegWrite(phy, reg, (MV_U16) data);
-	spin_unlock_irqrestore(&switch_lock, flags);
+	if (batch)
+		return mv_switch_batch_add(batch, HW_REG_WRITE, phy, reg, data & 0xFFFF);
+
+	mutex_lock(&switch_lock);
+	status = mvSwitchRegWrite(phy, reg, (MV_U16) data);
+	mutex_unlock(&switch_lock);
 
 	return status;
 }
 
-/* This macro calculates the mask for partial read /    */
-/* write of register's data.                            */
-#define CALC_MASK(fieldOffset,fieldLen,mask)        \
-            if((fieldLen + fieldOffset) >= 16)      \
-                mask = (0 - (1 << fieldOffset));    \
-            else                                    \
-                mask = (((1 << (fieldLen + fieldOffset))) - (1 << fieldOffset))
-
-
 MV_STATUS mv_switch_mii_write_RegField( 
         IN MV_U8  	port, 
         IN MV_U8  	reg, 
@@ -233,24 +1170,34 @@ MV_STATUS mv_switch_mii_write_RegField(
         IN MV_U8  	fieldLength, 
         IN MV_U16 	data)
 {
-	MV_U32		flags;
+	MV_SWITCH_BATCH	*batch = mv_switch_batch_get();
 	MV_U16 		tmp;
 	MV_U16  	mask;
 	MV_STATUS 	status;
 
-	spin_lock_irqsave(&switch_lock, flags);
-	
-	status = mvEthPhyRegRead( port, reg, &tmp);
-	
 	CALC_MASK(fieldOffset,fieldLength,mask);
 
+	if (batch)
+		return mv_switch_batch_add(batch, HW_REG_RMW, port, reg,
+					   ((MV_U32)mask << 16) | ((data << fieldOffset) & mask));
+
+	mutex_lock(&switch_lock);
+	mvSwitchSmiStats(port)->rmws++;
+
+	status = mvSwitchRegRead( port, reg, &tmp);
+	if (status != MV_OK) {
+		/* nothing known to write back */
+		mutex_unlock(&switch_lock);
+		return status;
+	}
+
         /* Set the desired bits to 0.                       */
         tmp &= ~mask;
         /* Set the given data into the above reset bits.    */
         tmp |= ((data << fieldOffset) & mask);
         
-	status |= mvEthPhyRegWrite( port, reg, tmp);
-	spin_unlock_irqrestore( &switch_lock, flags);
+	status = mvSwitchRegWrite( port, reg, tmp);
+	mutex_unlock(&switch_lock);
 
 	return status;
 }
@@ -277,8 +1224,20 @@ int mv_switch_reg_write( int port, int reg, int type, unsigned int value)
 		break;
 
 	case MV_SWITCH_SMI_ACCESS:
-		/* port means phyAddr */
-		MV_REG_WRITE( ETH_SMI_REG(MV_ETH_SMI_PORT), value);
+		/* raw SMI access is meaningless with a register backend */
+		if (qddev.fgtWriteMii != NULL)
+			return MV_NOT_SUPPORTED;
+		/* port means phyAddr; serialized with the other SMI users */
+		mutex_lock(&switch_lock);
+		status = mvEthSmiIssue(value);
+		switch_smi_stats[MV_SWITCH_SMI_ACCESS].writes++;
+		if (status != MV_OK)
+			switch_smi_stats[MV_SWITCH_SMI_ACCESS].busyTimeouts++;
+		mutex_unlock(&switch_lock);
+		if (status != MV_OK)
+			return status;
+		/* the raw command may have written any switch register */
+		mv_switch_shadow_invalidate();
 		status = MV_OK;
 		break;
 
@@ -312,8 +1271,13 @@ int mv_switch_reg_read( int port, int reg, int type, unsigned int *value)
 		break;
 
 	case MV_SWITCH_SMI_ACCESS:
+		if (qddev.fgtReadMii != NULL)
+			return MV_NOT_SUPPORTED;
 		/* port means phyAddr */
 		*value = MV_REG_READ( ETH_SMI_REG(MV_ETH_SMI_PORT)); 
+		mutex_lock(&switch_lock);
+		switch_smi_stats[MV_SWITCH_SMI_ACCESS].reads++;
+		mutex_unlock(&switch_lock);
 		status = MV_OK;
 		break;
 
@@ -325,6 +1289,70 @@ int mv_switch_reg_read( int port, int reg, int type, unsigned int *value)
 	return status;
 }
 
+/*******************************************************************************
+* mv_switch_phy_bench - Compare direct and indirect PHY register read latency.
+*
+* DESCRIPTION:
+*       Reads a PHY register 'count' times directly over MDIO (SMI address =
+*       port) and through the Global2 SMI PHY command/data registers, and
+*       reports the average latency of each path; read the report with
+*       mv_switch_phy_bench_show().
+*
+*******************************************************************************/
+static DEFINE_MUTEX(switch_phy_bench_lock);
+static char	switch_phy_bench_report[MV_SWITCH_BENCH_REPORT_SIZE];
+static int	switch_phy_bench_len;
+
+int mv_switch_phy_bench(int port, int reg, int count)
+{
+	unsigned int	value;
+	MV_U16		data;
+	ktime_t		start;
+	s64		direct_ns, indirect_ns;
+	int		i, err = 0;
+
+	if (count <= 0)
+		return -EINVAL;
+
+	mutex_lock(&switch_phy_bench_lock);
+	start = ktime_get();
+	for (i = 0; i < count && !err; i++)
+		if (mv_switch_mii_read(port, reg, &value) != MV_OK)
+			err = -EIO;
+	direct_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < count && !err; i++)
+		if (gprtGetPhyReg(&qddev, port, reg, &data) != MV_OK)
+			err = -EIO;
+	indirect_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (err)
+		switch_phy_bench_len = sprintf(switch_phy_bench_report,
+					       "phy bench: phy %d reg %d read failed\n", port, reg);
+	else
+		switch_phy_bench_len = sprintf(switch_phy_bench_report,
+					       "phy bench: phy %d reg %d, %d reads: direct %lld ns/read, indirect %lld ns/read\n",
+					       port, reg, count, div_s64(direct_ns, count),
+					       div_s64(indirect_ns, count));
+	mutex_unlock(&switch_phy_bench_lock);
+
+	return err;
+}
+
+/* Report of the last mv_switch_phy_bench() run */
+int mv_switch_phy_bench_show(char *buf)
+{
+	int len;
+
+	mutex_lock(&switch_phy_bench_lock);
+	len = switch_phy_bench_len;
+	memcpy(buf, switch_phy_bench_report, len);
+	mutex_unlock(&switch_phy_bench_lock);
+
+	return len;
+}
+
 int mv_switch_jumbo_mode_set( GT_QD_DEV *qd_dev, int max_size)
 {
 	int i;
@@ -347,11 +1375,366 @@ int mv_switch_jumbo_mode_set( GT_QD_DEV *qd_dev, int max_size)
 	return 0;
 }
 
+int mv_switch_atu_db_flush(int db_num)
+{
+	if (gfdbFlushInDB(&qddev, GT_FLUSH_ALL, db_num) != MV_OK) {
+		printk(KERN_ERR "gfdbFlushInDB %d failed\n", db_num);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Forget the dynamic entries of a port that stopped forwarding, so that
+ * only its stations are relearned instead of the whole table.
+ */
+static int mv_switch_port_fdb_flush(int port)
+{
+	if (gfdbRemovePort(&qddev, GT_MOVE_ALL_UNLOCKED, port) != MV_OK) {
+		printk(KERN_ERR "gfdbRemovePort %d failed\n", port);
+		return -1;
+	}
+	SWITCH_DBG(SWITCH_DBG_LOAD, ("port %d: dynamic ATU entries removed\n", port));
+	return 0;
+}
+
+/*
+ * Link events and port flushes are handled by the register queue worker:
+ * link events come from the NETA link path in atomic context, and both the
+ * link state read and the ATU flush sleep. The pending bits are set with
+ * atomic bit operations and taken by the worker.
+ */
+static unsigned long switch_link_event_pending;	/* ports to check */
+static unsigned long switch_link_force_pending;	/* ports to flush even if seen down */
+static unsigned long switch_port_flush_pending;	/* ports to flush */
 
-static MV_STATUS qd_dev_init(GT_QD_DEV *qd_dev)
+/* Link state of the ports, bit per port, as last seen by the worker */
+static MV_U32 switch_link_up_mask;
+
+static void mv_switch_port_work(struct work_struct *work)
+{
+	unsigned long	events, force, flush;
+	MV_BOOL		link;
+	int		p;
+
+	events = xchg(&switch_link_event_pending, 0);
+	force = xchg(&switch_link_force_pending, 0);
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++) {
+		if (!MV_BIT_CHECK(events, p))
+			continue;
+		if (gprtGetLinkState(&qddev, p, &link) != MV_OK)
+			continue;
+
+		if (link) {
+			switch_link_up_mask |= (1 << p);
+			continue;
+		}
+		/* link down: the stations behind the port moved or left */
+		if (MV_BIT_CHECK(switch_link_up_mask, p) || MV_BIT_CHECK(force, p))
+			set_bit(p, &switch_port_flush_pending);
+		switch_link_up_mask &= ~(1 << p);
+	}
+
+	flush = xchg(&switch_port_flush_pending, 0);
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		if (MV_BIT_CHECK(flush, p))
+			mv_switch_port_fdb_flush(p);
+}
+
+static DECLARE_WORK(switch_port_work, mv_switch_port_work);
+
+static void mv_switch_port_work_queue(void)
+{
+	/* the register queue keeps it in order with queued writes */
+	if (mv_switch_queue_call(&switch_port_work) != MV_OK)
+		schedule_work(&switch_port_work);
+}
+
+/* May be called from any context */
+void mv_switch_link_update_event(MV_U32 port_mask, int force_link_check)
+{
+	int p;
+
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++) {
+		if (!MV_BIT_CHECK(port_mask, p))
+			continue;
+		if (force_link_check)
+			set_bit(p, &switch_link_force_pending);
+		set_bit(p, &switch_link_event_pending);
+	}
+	mv_switch_port_work_queue();
+}
+
+/*
+ * STP port state. A port leaving forwarding or learning loses its dynamic
+ * entries (topology change); learning -> forwarding keeps what it learned,
+ * as in mv_switch_mstp_state_set().
+ */
+int mv_switch_stp_state_set(int port, GT_PORT_STP_STATE state)
+{
+	GT_PORT_STP_STATE old;
+
+	if (gstpGetPortState(&qddev, port, &old) != MV_OK) {
+		printk(KERN_ERR "gstpGetPortState failed (port %d)\n", port);
+		return -1;
+	}
+	if (old == state)
+		return 0;
+	if (gstpSetPortState(&qddev, port, state) != MV_OK) {
+		printk(KERN_ERR "gstpSetPortState failed (port %d)\n", port);
+		return -1;
+	}
+	if (old == GT_PORT_FORWARDING || (old == GT_PORT_LEARNING && state != GT_PORT_FORWARDING)) {
+		set_bit(port, &switch_port_flush_pending);
+		mv_switch_port_work_queue();
+	}
+
+	return 0;
+}
+
+/* VTU entry for vlan_id whose members egress unmodified; unchanged entries cost no access */
+int mv_switch_vlan_in_vtu_set(unsigned short vlan_id, unsigned short db_num, unsigned int ports_mask)
+{
+	GT_VTU_ENTRY vtu_entry;
+
+	mv_switch_vtu_entry_init(&vtu_entry, vlan_id, db_num, ports_mask);
+	if (mv_switch_vtu_set(&vtu_entry, 1) < 0) {
+		printk(KERN_ERR "VTU entry %d set failed\n", vlan_id);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * 802.1Q VLAN group: the group VID holds all the member ports, and every
+ * member port other than the CPU port gets its own default VID holding the
+ * other members, so the CPU can tell on which port a frame arrived. The
+ * group's VID range is replaced through the VTU mirror in one update, so
+ * the default VIDs of ports that left the group are purged, and the group
+ * database (vlan_grp_id + 1) joins the ATU mirror resync.
+ */
+int mv_eth_switch_vlan_set(MV_U16 vlan_grp_id, MV_U16 port_map, MV_U16 cpu_port)
+{
+	GT_VTU_ENTRY	vtu_entries[MAX_SWITCH_PORT_NUM + 1];
+	MV_U16		vlan_id = MV_SWITCH_GROUP_VLAN_ID(vlan_grp_id);
+	MV_U16		db_num = vlan_grp_id + 1;
+	MV_U32		members = port_map | (1 << cpu_port);
+	MV_U32		n = 0;
+	int		p;
+
+	mv_switch_vtu_entry_init(&vtu_entries[n++], vlan_id, db_num, members);
+
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++) {
+		if (!MV_BIT_CHECK(port_map, p) || (p == cpu_port))
+			continue;
+
+		if ((gvlnSetPortVid(&qddev, p, MV_SWITCH_PORT_VLAN_ID(vlan_id, p)) != MV_OK) ||
+		    (gvlnSetPortVlanDBNum(&qddev, p, db_num) != MV_OK) ||
+		    (gvlnSetPortVlanDot1qMode(&qddev, p, GT_FALLBACK) != MV_OK)) {
+			printk(KERN_ERR "VLAN setup failed (port %d)\n", p);
+			return -1;
+		}
+		mv_switch_vtu_entry_init(&vtu_entries[n++], MV_SWITCH_PORT_VLAN_ID(vlan_id, p),
+					 db_num, members & ~(1 << p));
+	}
+
+	if (mv_switch_vtu_range_set(vlan_id, vlan_id + MAX_SWITCH_PORT_NUM, vtu_entries, n) < 0) {
+		printk(KERN_ERR "VTU update of VLAN group %d failed\n", vlan_grp_id);
+		return -1;
+	}
+	/* the switch learns into the group database from now on */
+	mv_switch_atu_mirror_db_add(db_num);
+
+	return 0;
+}
+
+static int mv_switch_fdb_mac_set(const unsigned char *mac_addr, unsigned char db,
+				 unsigned int ports_mask, unsigned char op)
+{
+	GT_ATU_ENTRY mac_entry;
+
+	memset(&mac_entry, 0, sizeof(GT_ATU_ENTRY));
+	mac_entry.trunkMember = MV_FALSE;
+	mac_entry.DBNum = db;
+	mac_entry.portVec = ports_mask;
+	memcpy(mac_entry.macAddr, mac_addr, 6);
+
+	if (is_multicast_ether_addr(mac_addr))
+		mac_entry.entryState.mcEntryState = GT_MC_STATIC;
+	else
+		mac_entry.entryState.ucEntryState = GT_UC_NO_PRI_STATIC;
+
+	if ((op == 0) || (mac_entry.portVec == 0)) {
+		if (gfdbDelAtuEntry(&qddev, &mac_entry) != MV_OK) {
+			printk(KERN_ERR "gfdbDelAtuEntry failed\n");
+			return -1;
+		}
+	} else {
+		if (gfdbAddMacEntry(&qddev, &mac_entry) != MV_OK) {
+			printk(KERN_ERR "gfdbAddMacEntry failed\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Purge all multicast entries of a database, one ATU chunk at a time */
+static int mv_switch_fdb_mc_purge(int db_num)
+{
+	static const MV_U8	mc_start[6] = {0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	GT_ATU_ENTRY		*atu;
+	MV_U8			start[6];
+	MV_U32			i, count, purge;
+	MV_STATUS		status;
+	MV_BOOL			last;
+	int			err = 0;
+
+	atu = kmalloc(sizeof(GT_ATU_ENTRY) * MV_SWITCH_ATU_WALK_CHUNK, GFP_KERNEL);
+	if (atu == NULL)
+		return -ENOMEM;
+
+	/* the ATU is in MAC order: multicast entries follow 00:ff:ff:ff:ff:ff */
+	memcpy(start, mc_start, 6);
+	do {
+		status = mv_switch_atu_dump(&qddev, db_num, start, atu, MV_SWITCH_ATU_WALK_CHUNK, &count);
+		if (status != MV_OK) {
+			printk(KERN_ERR "%s: ATU read failed (%d)\n", __func__, status);
+			err = -EIO;
+			break;
+		}
+		if (count == 0)
+			break;
+		memcpy(start, atu[count - 1].macAddr, 6);
+		last = (count < MV_SWITCH_ATU_WALK_CHUNK) ? MV_TRUE : MV_FALSE;
+
+		/* unicast entries (CPU/router MACs) are skipped over, broadcast is kept and ends the table */
+		for (i = 0, purge = 0; i < count; i++) {
+			if (is_broadcast_ether_addr(atu[i].macAddr)) {
+				last = MV_TRUE;
+				break;
+			}
+			if (!(atu[i].macAddr[0] & 1))
+				continue;
+			if (purge != i)
+				memcpy(&atu[purge], &atu[i], sizeof(GT_ATU_ENTRY));
+			atu[purge++].entryState.ucEntryState = 0;
+		}
+		if (purge && gfdbLoadAtuEntries(&qddev, atu, purge, NULL) != MV_OK) {
+			printk(KERN_ERR "%s: ATU purge failed\n", __func__);
+			err = -EIO;
+			break;
+		}
+		for (i = 0; i < purge; i++)
+			SWITCH_DBG(SWITCH_DBG_MCAST, ("mcast %pM deleted from db %d\n", atu[i].macAddr, db_num));
+	} while (!last);
+
+	kfree(atu);
+
+	return err;
+}
+
+/*
+ * The NETA rx mode path (mv_eth_switch_set_multicast_list) updates the ATU
+ * with the netdev address lock held and bottom halves off, where the ATU
+ * engine cannot be waited for. Static entry updates are therefore always
+ * queued, whatever the caller's context, in a small ring applied in order
+ * by the register queue worker; a request never overtakes an earlier one.
+ * switch_fdb_work_lock keeps a single drainer should the work run on the
+ * system workqueue next to the register queue.
+ */
+#define MV_SWITCH_FDB_DEFER_SIZE	64
+
+typedef struct {
+	MV_U8	mac[6];		/* mac entry; unused for a purge */
+	MV_U8	op;		/* mac_addr_set op, or MV_SWITCH_FDB_MC_PURGE */
+	MV_U16	db;
+	MV_U32	portsMask;
+} MV_SWITCH_FDB_REQ;
+
+#define MV_SWITCH_FDB_MC_PURGE		0xFF
+
+static MV_SWITCH_FDB_REQ	switch_fdb_defer[MV_SWITCH_FDB_DEFER_SIZE];
+static MV_U32			switch_fdb_defer_head, switch_fdb_defer_tail;
+static DEFINE_SPINLOCK(switch_fdb_defer_lock);
+static DEFINE_MUTEX(switch_fdb_work_lock);
+
+static void mv_switch_fdb_work(struct work_struct *work)
+{
+	MV_SWITCH_FDB_REQ	req;
+	unsigned long		flags;
+
+	mutex_lock(&switch_fdb_work_lock);
+	spin_lock_irqsave(&switch_fdb_defer_lock, flags);
+	while (switch_fdb_defer_tail != switch_fdb_defer_head) {
+		req = switch_fdb_defer[switch_fdb_defer_tail % MV_SWITCH_FDB_DEFER_SIZE];
+		switch_fdb_defer_tail++;
+		spin_unlock_irqrestore(&switch_fdb_defer_lock, flags);
+
+		if (req.op == MV_SWITCH_FDB_MC_PURGE)
+			mv_switch_fdb_mc_purge(req.db);
+		else
+			mv_switch_fdb_mac_set(req.mac, req.db, req.portsMask, req.op);
+
+		spin_lock_irqsave(&switch_fdb_defer_lock, flags);
+	}
+	spin_unlock_irqrestore(&switch_fdb_defer_lock, flags);
+	mutex_unlock(&switch_fdb_work_lock);
+}
+
+static DECLARE_WORK(switch_fdb_work, mv_switch_fdb_work);
+
+static int mv_switch_fdb_defer(const unsigned char *mac_addr, MV_U16 db,
+			       unsigned int ports_mask, unsigned char op)
+{
+	MV_SWITCH_FDB_REQ	*req;
+	unsigned long		flags;
+
+	spin_lock_irqsave(&switch_fdb_defer_lock, flags);
+	if (switch_fdb_defer_head - switch_fdb_defer_tail >= MV_SWITCH_FDB_DEFER_SIZE) {
+		spin_unlock_irqrestore(&switch_fdb_defer_lock, flags);
+		printk_ratelimited(KERN_ERR "mv_switch: deferred ATU request dropped\n");
+		return -1;
+	}
+	req = &switch_fdb_defer[switch_fdb_defer_head % MV_SWITCH_FDB_DEFER_SIZE];
+	if (mac_addr)
+		memcpy(req->mac, mac_addr, 6);
+	req->db = db;
+	req->portsMask = ports_mask;
+	req->op = op;
+	switch_fdb_defer_head++;
+	spin_unlock_irqrestore(&switch_fdb_defer_lock, flags);
+
+	/* the register queue keeps it in order with queued writes */
+	if (mv_switch_queue_call(&switch_fdb_work) != MV_OK)
+		schedule_work(&switch_fdb_work);
+
+	return 0;
+}
+
+/* Queue a static ATU entry for mac_addr, or its purge when ports_mask is 0 or op is 0. Any context */
+int mv_switch_mac_addr_set(unsigned char *mac_addr, unsigned char db,
+			   unsigned int ports_mask, unsigned char op)
+{
+	return mv_switch_fdb_defer(mac_addr, db, ports_mask, op ? 1 : 0);
+}
+
+/* Queue the purge of all multicast entries of a database. Any context */
+int mv_switch_all_multicasts_del(int db_num)
 {
-	spin_lock_init(&switch_lock);
+	return mv_switch_fdb_defer(NULL, db_num, 0, MV_SWITCH_FDB_MC_PURGE);
+}
+
+/* Wait until the queued static entry updates are in the ATU. Process context */
+void mv_switch_fdb_sync(void)
+{
+	/* a worker holding the lock finishes the request it took first */
+	mv_switch_fdb_work(NULL);
+}
 
+
+static MV_STATUS qd_dev_init(GT_QD_DEV *qd_dev)
+{
         /* Initialize dev fields.         */
         qd_dev->cpuPortNum = SWITCH_TO_CPU_LAN;
         qd_dev->maxPhyNum = 5;
@@ -365,6 +1748,34 @@ static MV_STATUS qd_dev_init(GT_QD_DEV *qd_dev)
         qd_dev->maxPhyNum = 7;
         qd_dev->validPortVec = (1 << qd_dev->numOfPorts) - 1;
         qd_dev->validPhyVec = 0x7F;
+        /* single switch on the MDIO bus, registers at their fixed     */
+        /* addresses; SMI_MULTI_ADDR_MODE accesses them through phyAddr */
+        qd_dev->accessMode = SMI_MANUAL_MODE;
+        qd_dev->baseRegAddr = 0;
+        qd_dev->phyAddr = 0;
+
+        /* fgtReadMii/fgtWriteMii left NULL select the SoC SMI unit */
+        if (switch_sim)
+                mv_switch_sim_attach(qd_dev, MV_SWITCH_SIM_BUSY_POLLS);
+
+        qd_dev->semCreate = mvSwitchSemCreate;
+        qd_dev->semDelete = mvSwitchSemDelete;
+        qd_dev->semTake = mvSwitchSemTake;
+        qd_dev->semGive = mvSwitchSemGive;
+
+        /* one semaphore per table engine, created once */
+        if (qd_dev->atuRegsSem == 0) {
+                qd_dev->multiAddrSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->atuRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->vtuRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->statsRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->pirlRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->ptpRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->tblRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->eepromRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->phyRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+                qd_dev->hwAccessRegsSem = qd_dev->semCreate(GT_SEM_FULL);
+        }
         qd_dev->devName = DEV_88E6171;
 
     	qd_dev->use_mad = MV_FALSE;
@@ -375,17 +1786,10 @@ static MV_STATUS qd_dev_init(GT_QD_DEV *qd_dev)
 	return MV_OK;
 }
 
-int mv_switch_init(int mtu, unsigned int switch_ports_mask)
+static int mv_switch_init_config(GT_QD_DEV *qd_dev, int mtu, unsigned int switch_ports_mask)
 {
 	MV_U16 		p;
 	MV_U8 		tmp;
-        GT_QD_DEV       *qd_dev = &qddev;
- 
-        // If the init had been done, skip all the content
-        if (initBridgeDone == MV_TRUE)  return 0;
-
-	/* general Switch initialization - relevant for all Switch devices */
-        qd_dev_init( qd_dev);
 
 	/* disable all ports */
 	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++) {
@@ -545,6 +1949,50 @@ int mv_switch_init(int mtu, unsigned int switch_ports_mask)
 			}
 	}
 
+	return 0;
+}
+
+int mv_switch_init(int mtu, unsigned int switch_ports_mask)
+{
+        GT_QD_DEV       *qd_dev = &qddev;
+	MV_SWITCH_BATCH	*batch;
+	int		err;
+
+        // If the init had been done, skip all the content
+        if (initBridgeDone == MV_TRUE)  return 0;
+
+	/* general Switch initialization - relevant for all Switch devices */
+        qd_dev_init( qd_dev);
+
+	/* worker of the asynchronous register queue; synchronous access */
+	/* keeps working without it                                       */
+	mv_switch_queue_init();
+
+	/* scale the SMI and register poll timeouts to the measured MDC speed */
+	mv_switch_smi_calibrate();
+
+	mv_switch_atu_init();
+	mv_switch_atu_event_init();
+	mv_switch_vtu_init();
+
+	/* queue the per-port register updates and issue them in a few batches */
+	batch = kmalloc(sizeof(MV_SWITCH_BATCH), GFP_KERNEL);
+	if (batch)
+		mv_switch_batch_begin(batch);
+
+	err = mv_switch_init_config(qd_dev, mtu, switch_ports_mask);
+
+	if (batch) {
+		if (mv_switch_batch_end() != MV_OK) {
+			printk(KERN_ERR "%s: switch register batch failed\n", __func__);
+			err = -1;
+		}
+		kfree(batch);
+	}
+
+	if (err)
+		return err;
+
 	initBridgeDone = MV_TRUE;
 	return 0;
 }
@@ -28,6 +28,11 @@ disclaimer.
 #ifndef __mv_switch_h__
 #define __mv_switch_h__
 
+#include <linux/list.h>
+#include <linux/ktime.h>
+#include <linux/bitops.h>
+#include <linux/workqueue.h>
+
 #include "dsdt/msApiDefs.h"
 
 #define MV_SWITCH_PHY_ACCESS			1
@@ -42,12 +47,356 @@ disclaimer.
 #define SWITCH_TO_CPU_LAN	5
 #define SWITCH_TO_CPU_WAN	6
 
+/* Register batch (see mv_switch_rw_reg_list). HW_REG_RMW extends the      */
+/* HW_DEV_RW_REG commands: data = (mask << 16) | value.                     */
+#define HW_REG_RMW				4
+#define MV_SWITCH_BATCH_MAX_OPS			64
+#define MV_SWITCH_BATCH_WAIT_POLLS		1000
+/* Bounds of the register bit poll timeout, MV_SWITCH_BATCH_WAIT_POLLS SMI */
+/* turnarounds as measured by mv_switch_smi_calibrate()                     */
+#define MV_SWITCH_REG_WAIT_MIN_US		10000
+#define MV_SWITCH_REG_WAIT_MAX_US		100000
+
+/* SMI transaction statistics of one MV_SWITCH_*_ACCESS type */
+#define MV_SWITCH_SMI_HIST_BUCKETS		16
+
+typedef struct {
+	MV_U32		reads;
+	MV_U32		writes;
+	MV_U32		rmws;
+	MV_U32		cached;		/* served or skipped thanks to the shadow */
+	MV_U32		busyTimeouts;	/* SMI unit stayed busy (MV_BUSY) */
+	MV_U32		readTimeouts;	/* read data never valid (MV_TIMEOUT) */
+	MV_U32		waitTimeouts;	/* register bit poll expired (MV_NOT_READY) */
+	MV_U32		errors;
+	MV_U32		hist[MV_SWITCH_SMI_HIST_BUCKETS];	/* log2(us) latency */
+} MV_SWITCH_SMI_STATS;
+
+/* Software register model (mv_switch_sim.c) counters */
+typedef struct {
+	MV_U32		reads;
+	MV_U32		writes;
+	MV_U32		busyReads;	/* command register reads returning busy */
+	MV_U32		atuOps;
+	MV_U32		atuFull;
+	MV_U32		vtuOps;
+	MV_U32		pvtOps;
+	MV_U32		statsOps;
+	MV_U32		phyOps;
+} MV_SWITCH_SIM_STATS;
+
+#define MV_SWITCH_SIM_BUSY_POLLS		2
+#define MV_SWITCH_SIM_LATENCY_MAX		100000	/* ns per transaction */
+
+/* Remote Management Unit client (mv_switch_rmu.c) counters */
+typedef struct {
+	MV_U32		requests;
+	MV_U32		responses;
+	MV_U32		timeouts;
+	MV_U32		errors;		/* error frames from the switch */
+	MV_U32		fallbacks;	/* dumps redone over SMI */
+	MV_U32		rwOps;		/* register operations done over RMU */
+} MV_SWITCH_RMU_STATS;
+
+/* Register lists shorter than this are not worth an RMU round trip */
+#define MV_SWITCH_RMU_MIN_OPS			4
+#define MV_SWITCH_MIB_COUNTERS			32
+
+/* Asynchronous register operation (mv_switch_queue.c) */
+#define MV_SWITCH_OP_MAX_REGS			8
+#define MV_SWITCH_QUEUE_MAX_DEPTH		256
+
+typedef struct mv_switch_op MV_SWITCH_OP;
+typedef void (*MV_SWITCH_OP_DONE)(MV_SWITCH_OP *op);
+
+struct mv_switch_op {
+	struct list_head	link;
+	MV_U32			entries;
+	HW_DEV_RW_REG		list[MV_SWITCH_OP_MAX_REGS];
+	MV_SWITCH_OP_DONE	done;		/* called by the queue worker */
+	void			*cookie;
+	MV_STATUS		status;
+	ktime_t			submitted;
+};
+
+typedef struct {
+	MV_U32		depth;
+	MV_U32		maxDepth;
+	MV_U32		submitted;
+	MV_U32		completed;
+	MV_U32		failed;
+	MV_U32		rejected;	/* queue full */
+	MV_U32		runs;		/* register lists executed */
+	MV_U32		hist[MV_SWITCH_SMI_HIST_BUCKETS];	/* log2(us) submit to done */
+} MV_SWITCH_QUEUE_STATS;
+
+/* Resumable ATU walk (mv_switch_atu.c) */
+#define MV_SWITCH_ATU_WALK_CHUNK		16
+#define MV_SWITCH_ATU_DB_MAX			4095
+
+typedef struct {
+	MV_U16		dbNum;		/* database being walked */
+	MV_U16		dbLast;
+	MV_BOOL		dbDone;		/* dbNum has no entries after lastMac */
+	MV_U8		lastMac[6];	/* cursor, broadcast = start of dbNum */
+	MV_U32		chunkIdx;
+	MV_U32		chunkCount;
+	GT_ATU_ENTRY	chunk[MV_SWITCH_ATU_WALK_CHUNK];
+	MV_STATUS	status;		/* MV_NO_SUCH once the walk is over */
+	MV_U32		entries;	/* returned so far */
+	ktime_t		start;
+	s64		elapsedNs;	/* set at the end of the walk */
+} MV_SWITCH_ATU_WALK;
+
+/* Bulk ATU load (gfdbLoadAtuEntries): entries per register list, and   */
+/* register operations per entry (busy poll, data, 3 MAC words, FID, op) */
+#define MV_SWITCH_ATU_LOAD_CHUNK		16
+#define MV_SWITCH_ATU_LOAD_OPS			7
+
+/* Bulk VTU load (gvtuLoadEntries): entries per register list, and      */
+/* register operations per entry (busy poll, 3 data, FID, SID, VID, op) */
+#define MV_SWITCH_VTU_LOAD_CHUNK		16
+#define MV_SWITCH_VTU_LOAD_OPS			8
+#define MV_SWITCH_VTU_VIDS			4096
+#define MV_SWITCH_VTU_SHOW_MAX			64	/* entries listed by sysfs */
+
+/* Cross chip port VLAN table: 512 entries indexed by source device and */
+/* source port (5 Bit Port clear); bulk loads (gpvtLoadPVTMatrix) go    */
+/* out in register lists of data, busy poll and operation per entry     */
+#define MV_SWITCH_PVT_SIZE			512
+#define MV_SWITCH_PVT_DEVS			32
+#define MV_SWITCH_PVT_PORTS			16
+#define MV_SWITCH_PVT_POINTER(dev, port)	(((dev) << 4) | (port))
+#define MV_SWITCH_PVT_LOAD_CHUNK		32
+#define MV_SWITCH_PVT_LOAD_OPS			3
+
+/* VTU mirror (mv_switch_vtu.c) counters */
+typedef struct {
+	MV_U32		entries;	/* valid VIDs */
+	MV_U32		requests;	/* VIDs passed to mv_switch_vtu_set/_del/_push */
+	MV_U32		unchanged;	/* the VTU already held them */
+	MV_U32		loads;
+	MV_U32		purges;
+	MV_U32		joins;		/* ports that became members of a VID */
+	MV_U32		leaves;		/* ports that stopped being members */
+	MV_U32		retags;		/* members whose egress mode changed */
+	MV_U32		errors;
+	MV_U32		syncs;		/* reads of the whole VTU */
+	MV_U32		pushes;		/* whole table updates */
+	MV_U32		lastUs;		/* duration of the last update */
+} MV_SWITCH_VTU_STATS;
+
+/*
+ * VLAN membership of a VID in 8 bytes, so that two entries are compared
+ * as one word; members is the port bitmap, egress the 2-bit
+ * MEMBER_EGRESS_* mode of each member port (0 for the other ports).
+ */
+#define MV_SWITCH_VLAN_POLICY			0x8000	/* in fid */
+#define MV_SWITCH_VLAN_PRI_OVERRIDE		0x80	/* in prio */
+
+typedef struct {
+	MV_U16		fid;		/* DBNum | MV_SWITCH_VLAN_POLICY */
+	MV_U16		egress;
+	MV_U8		members;
+	MV_U8		sid;
+	MV_U8		prio;		/* MV_SWITCH_VLAN_PRI_OVERRIDE | priority */
+	MV_U8		reserved;
+} MV_SWITCH_VLAN;
+
+/* VLAN table: bitmap of the VIDs in use and their membership */
+typedef struct {
+	unsigned long	vids[BITS_TO_LONGS(MV_SWITCH_VTU_VIDS)];
+	MV_SWITCH_VLAN	vlan[MV_SWITCH_VTU_VIDS];
+} MV_SWITCH_VLAN_MAP;
+
+/* VLAN IDs of a VLAN group, see mv_eth_switch_vlan_set() */
+#define MV_SWITCH_GROUP_VLAN_ID(grp)		(((grp) + 1) << 8)
+#define MV_SWITCH_VLAN_TO_GROUP(vid)		((((vid) & 0xF00) >> 8) - 1)
+#define MV_SWITCH_PORT_VLAN_ID(vid, port)	((vid) + (port) + 1)
+
+/* MSTP instances (mv_switch_vtu.c): STU entries, SID 0 is the CIST.   */
+/* SIDs are 6 bits but 0x3F marks the start and end of the GetNext walk */
+#define MV_SWITCH_STU_SIDS			63
+
+typedef struct {
+	MV_U32		instances;	/* valid STU entries */
+	MV_U32		changes;	/* port state changes loaded */
+	MV_U32		unchanged;	/* requests that changed nothing */
+	MV_U32		vlans;		/* VIDs moved to another instance */
+	MV_U32		flushes;	/* per database port flushes */
+	MV_U32		errors;
+} MV_SWITCH_STU_STATS;
+
+/* PVT command path (mv_switch_pvt.c) counters */
+typedef struct {
+	MV_U32		ops;
+	MV_U32		retries;	/* operations that found the PVT busy and waited */
+	MV_U32		timeouts;	/* busy past the deadline */
+	MV_U32		errors;		/* SMI failures */
+	MV_U32		lists;		/* bulk register lists */
+	MV_U32		waitUs;		/* total time waited for the busy bit */
+	MV_U32		maxWaitUs;
+	MV_U32		maxListUs;
+} MV_SWITCH_PVT_STATS;
+
+/* ATU command engine (mv_switch_atu.c) counters */
+#define MV_SWITCH_ATU_WEDGED_RESET_MS		1000
+
+typedef struct {
+	MV_U32		ops;
+	MV_U32		timeouts;	/* busy past the deadline */
+	MV_U32		errors;		/* SMI failures */
+	MV_U32		rejected;	/* refused while wedged */
+	MV_U32		recoveries;	/* wedged ATU found idle */
+	MV_U32		resets;		/* switch software resets */
+	MV_U32		maxWaitUs;
+} MV_SWITCH_ATU_CMD_STATS;
+
+/* ATU mirror (mv_switch_atu.c) */
+#define MV_SWITCH_ATU_MIRROR_BUCKETS		1024	/* power of 2 */
+#define MV_SWITCH_ATU_MIRROR_MAX		8192
+#define MV_SWITCH_ATU_RESYNC_MS			100
+#define MV_SWITCH_ATU_RESYNC_BUDGET		64	/* entries read back per resync step */
+
+typedef struct {
+	MV_U32		entries;
+	MV_U32		hits;
+	MV_U32		misses;
+	MV_U32		probes;		/* misses looked up in the hardware */
+	MV_U32		dropped;	/* not mirrored, table full */
+	MV_U32		resyncPasses;	/* over all databases in use */
+	MV_U32		resyncEntries;
+	MV_U32		resyncStale;	/* removed, not in the hardware any more */
+	MV_U32		resyncErrors;
+} MV_SWITCH_ATU_MIRROR_STATS;
+
+/* ATU occupancy sampling (mv_switch_atu.c), from the ATU Stats counters */
+#define MV_SWITCH_ATU_SIZE			8192
+#define MV_SWITCH_ATU_STATS_MS			1000
+#define MV_SWITCH_ATU_STATS_POINTS		64	/* power of 2 */
+#define MV_SWITCH_ATU_NEAR_FULL_PCT		90
+#define MV_SWITCH_ATU_STATS_DBS			8	/* databases counted by atu_stats */
+
+typedef struct {
+	s64		timeNs;
+	MV_U32		all;		/* valid entries */
+	MV_U32		dynamic;	/* non-static entries */
+	MV_U16		learnCnt[MAX_SWITCH_PORT_NUM];
+} MV_SWITCH_ATU_SAMPLE;
+
+/* Adaptive ATU aging (mv_switch_atu.c): every period the timeout is     */
+/* halved above the high occupancy mark and doubled below the low mark  */
+/* when entries aged out, within [min, max] seconds                     */
+#define MV_SWITCH_ATU_AGING_DEFAULT		300
+#define MV_SWITCH_ATU_AGING_MIN			60
+#define MV_SWITCH_ATU_AGING_MAX			1200
+#define MV_SWITCH_ATU_AGING_PERIOD_MS		10000
+#define MV_SWITCH_ATU_AGING_HIGH_PCT		75
+#define MV_SWITCH_ATU_AGING_LOW_PCT		50
+#define MV_SWITCH_ATU_AGING_HOLD		3	/* periods between two increases */
+
+typedef struct {
+	MV_U32		timeout;	/* seconds, as programmed */
+	MV_U32		min;
+	MV_U32		max;
+	MV_BOOL		enabled;
+	MV_U32		runs;
+	MV_U32		shortened;	/* table pressure */
+	MV_U32		lengthened;	/* age-outs under low occupancy */
+	MV_U32		held;		/* at a bound or within the hold time */
+	MV_U32		idle;		/* between the marks */
+	MV_U32		errors;
+	MV_U32		lastAll;	/* inputs of the last decision */
+	MV_U32		lastAgeOuts;
+} MV_SWITCH_ATU_AGING_STATS;
+
+/* Benchmarks keep the report of their last run for 'cat <bench>' */
+#define MV_SWITCH_BENCH_REPORT_SIZE		1024
+
+/* ATU microbenchmark over the register model (mv_switch_atu.c) */
+#define MV_SWITCH_ATU_BENCH_DB			4095	/* database of the test entries */
+#define MV_SWITCH_ATU_BENCH_ENTRIES		512
+#define MV_SWITCH_ATU_BENCH_ROUNDS		64
+
+/* ATU violation events (mv_switch_event.c), read as records from */
+/* /dev/mv_switch_atu_events                                        */
+#define MV_SWITCH_ATU_EVENT_RING		256	/* power of 2 */
+#define MV_SWITCH_ATU_EVENT_POLL_MS		20	/* without interrupt line */
+#define MV_SWITCH_ATU_EVENT_BUDGET		32	/* violations per service run */
+#define MV_SWITCH_ATU_STORM_WINDOW_MS		1000
+#define MV_SWITCH_ATU_STORM_FULL		64	/* full violations per window */
+
+/* Global 1 status / control ATU problem bit */
+#define MV_SWITCH_G1_ATU_PROB_BIT		3
+
+#define MV_SWITCH_ATU_EVENT_MOVE		0x1	/* address seen on a new port */
+#define MV_SWITCH_ATU_EVENT_STORM		0x2	/* full violation storm started */
+#define MV_SWITCH_ATU_EVENT_OVER_LIMIT		0x4	/* miss violation of a port at its learn limit */
+
+typedef struct {
+	s64		timeNs;		/* ktime_get() */
+	MV_U8		macAddr[6];
+	MV_U16		DBNum;
+	MV_U8		port;		/* source port, 0xF for none */
+	MV_U8		cause;		/* GT_AGE/MEMBER/MISS/FULL/AGE_OUT_VIOLATION */
+	MV_U8		flags;
+	MV_U8		oldPort;	/* mirrored port of a move */
+} MV_SWITCH_ATU_EVENT;
+
+typedef struct {
+	MV_U32		interrupts;
+	MV_U32		polls;
+	MV_U32		age;
+	MV_U32		ageOut;		/* found by the mirror resync */
+	MV_U32		member;
+	MV_U32		miss;
+	MV_U32		full;
+	MV_U32		moves;
+	MV_U32		storms;
+	MV_U32		dropped;	/* ring full */
+	MV_U32		errors;
+	MV_U32		overLimit[MAX_SWITCH_PORT_NUM];
+} MV_SWITCH_ATU_EVENT_STATS;
+
+/* semTake timeout value meaning no timeout */
+#define OS_WAIT_FOREVER				0
+
+typedef struct {
+	MV_U32		entries;
+	MV_STATUS	failed;		/* first failure since batch begin */
+	HW_DEV_RW_REG	list[MV_SWITCH_BATCH_MAX_OPS];
+} MV_SWITCH_BATCH;
+
 /* value (of 1 bit) to a boolean one.       */
 /* 0 --> MV_FALSE                           */
 /* 1 --> MV_TRUE                            */
 #define BIT_2_BOOL(binVal,boolVal)                                  \
             (boolVal) = (((binVal) == 0) ? MV_FALSE : MV_TRUE)
 
+/* This macro calculates the mask for partial read /    */
+/* write of register's data.                            */
+#define CALC_MASK(fieldOffset,fieldLen,mask)        \
+            if((fieldLen + fieldOffset) >= 16)      \
+                mask = (0 - (1 << fieldOffset));    \
+            else                                    \
+                mask = (((1 << (fieldLen + fieldOffset))) - (1 << fieldOffset))
+
+/*
+ * Calling context. The register access API (mv_switch_mii_*, mv_switch_*reg*,
+ * the register lists and batches) and every DSDT call built on it sleep: the
+ * bus lock is a mutex, the table engines are guarded by GT_SEM semaphores and
+ * SMI waits back off with usleep_range. They are for process context only.
+ * The calls the NETA driver makes from atomic context are always deferred
+ * to the register queue worker instead, whatever the caller's context:
+ *   mv_switch_link_update_event()	link interrupt path
+ *   mv_switch_mac_addr_set(),
+ *   mv_switch_all_multicasts_del()	rx mode path, applied in call order;
+ *					mv_switch_fdb_sync() waits for them
+ *   mv_switch_op_submit(),
+ *   mv_switch_reg_write_async()	queued register writes
+ * The ATU mirror lookups (mv_switch_atu_mirror_find, mv_switch_atu_mac_port)
+ * never access the switch and are safe in any context.
+ */
 int     mv_switch_load(GT_QD_DEV *qd_dev, unsigned int switch_ports_mask);
 int     mv_switch_unload(unsigned int switch_ports_mask);
 int     mv_switch_init(int mtu, unsigned int switch_ports_mask);
@@ -60,6 +409,7 @@ int     mv_switch_vlan_in_vtu_set(unsigned short vlan_id, unsigned short db_num,
 int     mv_switch_mac_addr_set(unsigned char *mac_addr, unsigned char db,
 			       unsigned int ports_mask, unsigned char op);
 int     mv_switch_atu_db_flush(int db_num);
+int     mv_switch_stp_state_set(int port, GT_PORT_STP_STATE state);
 int     mv_eth_switch_vlan_set(MV_U16 vlan_grp_id, MV_U16 port_map, MV_U16 cpu_port);
 int     mv_switch_promisc_set(MV_U16 vlan_grp_id, MV_U16 port_map, MV_U16 cpu_port, MV_U8 promisc_on);
 unsigned int    mv_switch_link_detection_init(void);
@@ -70,6 +420,7 @@ void    mv_switch_stats_print(void);
 void    mv_switch_status_print(void);
 
 int     mv_switch_all_multicasts_del(int db_num);
+void    mv_switch_fdb_sync(void);
 
 int     mv_switch_port_add(int switch_port, MV_U16 vlan_grp_id, MV_U16 port_map);
 int     mv_switch_port_del(int switch_port, MV_U16 vlan_grp_id, MV_U16 port_map);
@@ -77,4 +428,113 @@ int     mv_switch_port_del(int switch_port, MV_U16 vlan_grp_id, MV_U16 port_map)
 MV_STATUS mv_switch_mii_read( unsigned int phy, unsigned int reg, unsigned int *data);
 MV_STATUS mv_switch_mii_write( unsigned int phy, unsigned int reg, unsigned int data);
 MV_STATUS mv_switch_mii_write_RegField( MV_U8 port, MV_U8 reg, MV_U8 offset, MV_U8 length, MV_U16 data);
+
+MV_STATUS mv_switch_rw_reg_list(HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed);
+MV_STATUS mv_switch_dev_rw_reg_list(GT_QD_DEV *dev, HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed);
+MV_STATUS mv_switch_smi_rw_reg_list(HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed);
+MV_BOOL   mv_switch_hw_access(GT_QD_DEV *dev, HW_DEV_REG_ACCESS *regList);
+MV_STATUS mv_switch_batch_add(MV_SWITCH_BATCH *batch, MV_U32 cmd, MV_U32 phyAddr, MV_U32 regOffs, MV_U32 data);
+MV_STATUS mv_switch_batch_exec(MV_SWITCH_BATCH *batch);
+void      mv_switch_batch_begin(MV_SWITCH_BATCH *batch);
+MV_STATUS mv_switch_batch_end(void);
+void      mv_switch_shadow_invalidate(void);
+MV_STATUS gtSemTake(GT_QD_DEV *dev, GT_SEM sem, MV_U32 timOut);
+MV_STATUS gtSemGive(GT_QD_DEV *dev, GT_SEM sem);
+int       mv_switch_phy_bench(int port, int reg, int count);
+int       mv_switch_phy_bench_show(char *buf);
+int       mv_switch_smi_stats_show(char *buf);
+void      mv_switch_smi_stats_clear(void);
+MV_STATUS mv_switch_smi_calibrate(void);
+
+MV_BOOL   mv_switch_sim_read_mii(GT_QD_DEV *dev, unsigned int phyAddr, unsigned int miiReg, unsigned int *value);
+MV_BOOL   mv_switch_sim_write_mii(GT_QD_DEV *dev, unsigned int phyAddr, unsigned int miiReg, unsigned int value);
+void      mv_switch_sim_reset(MV_U32 busyPolls);
+void      mv_switch_sim_attach(GT_QD_DEV *dev, MV_U32 busyPolls);
+void      mv_switch_sim_stats_get(MV_SWITCH_SIM_STATS *stats);
+int       mv_switch_sim_latency_set(MV_U32 ns);
+int       mv_switch_sim_show(char *buf);
+
+MV_STATUS mv_switch_queue_init(void);
+MV_STATUS mv_switch_op_submit(MV_SWITCH_OP *op);
+MV_STATUS mv_switch_op_reg_add(MV_SWITCH_OP *op, MV_U32 cmd, int port, int reg, int type, unsigned int value);
+int       mv_switch_reg_write_async(int port, int reg, int type, unsigned int value);
+void      mv_switch_queue_flush(void);
+MV_STATUS mv_switch_queue_call(struct work_struct *work);
+void      mv_switch_queue_stats_get(MV_SWITCH_QUEUE_STATS *stats);
+int       mv_switch_queue_show(char *buf);
+int       mv_switch_queue_bench(int count);
+int       mv_switch_queue_bench_show(char *buf);
+
+int       mv_switch_atu_init(void);
+void      mv_switch_atu_walk_start(MV_SWITCH_ATU_WALK *walk, MV_U16 dbFirst, MV_U16 dbLast);
+MV_STATUS mv_switch_atu_walk_next(GT_QD_DEV *dev, MV_SWITCH_ATU_WALK *walk, GT_ATU_ENTRY *entry);
+void      mv_switch_atu_mirror_update(GT_ATU_ENTRY *entry);
+void      mv_switch_atu_mirror_remove(MV_U16 dbNum, const MV_U8 *mac);
+void      mv_switch_atu_mirror_db_add(MV_U16 dbNum);
+void      mv_switch_atu_mirror_op(GT_ATU_OPERATION atuOp, GT_EXTRA_OP_DATA *opData, GT_ATU_ENTRY *entry);
+MV_BOOL   mv_switch_atu_mirror_find(GT_ATU_ENTRY *entry);
+void      mv_switch_atu_mirror_probe_count(void);
+int       mv_switch_atu_mirror_show(char *buf);
+int       mv_switch_atu_mac_port(MV_U16 dbNum, const MV_U8 *mac);
+MV_U32    mv_switch_atu_samples_get(MV_SWITCH_ATU_SAMPLE *samples, MV_U32 max);
+int       mv_switch_atu_stats_show(char *buf);
+int       mv_switch_atu_aging_set(MV_U32 min, MV_U32 max);
+MV_STATUS mv_switch_atu_cmd_ready(GT_QD_DEV *dev, MV_U32 ops);
+MV_STATUS mv_switch_atu_cmd_wait(GT_QD_DEV *dev);
+void      mv_switch_atu_cmd_failed(MV_STATUS status);
+int       mv_switch_atu_cmd_show(char *buf);
+int       mv_switch_atu_aging_show(char *buf);
+int       mv_switch_atu_bench(int entries, int rounds, int latencyNs);
+int       mv_switch_atu_bench_show(char *buf);
+MV_STATUS gfdbLoadAtuEntries(GT_QD_DEV *dev, GT_ATU_ENTRY *atuEntry, MV_U32 count, MV_STATUS *status);
+MV_STATUS gatuGetViolation(GT_QD_DEV *dev, MV_U32 *intCause, GT_ATU_ENTRY *entry);
+MV_STATUS gvtuLoadEntries(GT_QD_DEV *dev, GT_VTU_ENTRY *vtuEntry, MV_U32 count, MV_BOOL purge,
+			  MV_STATUS *status);
+MV_STATUS gpvtLoadPVTMatrix(GT_QD_DEV *dev, MV_U32 srcDevs, MV_U32 srcPorts, MV_U32 *pvtData);
+MV_STATUS mv_switch_pvt_cmd_wait(GT_QD_DEV *dev);
+void      mv_switch_pvt_cmd_done(MV_U32 ops, MV_STATUS status);
+void      mv_switch_pvt_list_done(MV_U32 ops, MV_STATUS status, MV_U32 us);
+int       mv_switch_pvt_show(char *buf);
+void      mv_switch_stu_mirror_op(GT_STU_ENTRY *entry, MV_BOOL purge);
+int       mv_switch_stu_sync(void);
+int       mv_switch_mstp_state_set(MV_U8 sid, int port, GT_PORT_STP_STATE state);
+int       mv_switch_mstp_vlan_set(MV_U8 sid, MV_U16 *vids, MV_U32 count);
+int       mv_switch_mstp_vlan_grp_set(MV_U16 vlan_grp_id, MV_U8 sid);
+int       mv_switch_stu_show(char *buf);
+
+int       mv_switch_vtu_init(void);
+void      mv_switch_vtu_mirror_op(GT_VTU_ENTRY *entry, MV_BOOL purge);
+void      mv_switch_vtu_mirror_flush(void);
+int       mv_switch_vtu_sync(void);
+int       mv_switch_vtu_set(GT_VTU_ENTRY *entries, MV_U32 count);
+int       mv_switch_vtu_del(MV_U16 *vids, MV_U32 count);
+MV_BOOL   mv_switch_vtu_get(MV_U16 vid, GT_VTU_ENTRY *entry);
+void      mv_switch_vtu_map_get(MV_SWITCH_VLAN_MAP *map);
+int       mv_switch_vtu_push(const MV_SWITCH_VLAN_MAP *map);
+int       mv_switch_vtu_range_set(MV_U16 first, MV_U16 last, GT_VTU_ENTRY *entries, MV_U32 count);
+void      mv_switch_vlan_map_clear(MV_SWITCH_VLAN_MAP *map);
+int       mv_switch_vlan_map_add(MV_SWITCH_VLAN_MAP *map, GT_VTU_ENTRY *entry);
+void      mv_switch_vlan_map_del(MV_SWITCH_VLAN_MAP *map, MV_U16 vid);
+MV_BOOL   mv_switch_vlan_map_entry(MV_SWITCH_VLAN_MAP *map, MV_U16 vid, GT_VTU_ENTRY *entry);
+void      mv_switch_vtu_entry_init(GT_VTU_ENTRY *entry, MV_U16 vid, MV_U16 dbNum, MV_U32 portsMask);
+int       mv_switch_vtu_show(char *buf);
+
+int       mv_switch_atu_event_init(void);
+int       mv_switch_atu_irq_init(int irq);
+int       mv_switch_atu_event_show(char *buf);
+void      mv_switch_atu_event_stats_get(MV_SWITCH_ATU_EVENT_STATS *stats);
+void      mv_switch_atu_event_age_out(MV_U16 dbNum, const MV_U8 *mac, MV_U32 portVec);
+int       mv_switch_port_learn_limit_set(int port, MV_U32 limit);
+int       mv_switch_port_learn_limit_show(int port, char *buf);
+
+struct net_device;
+MV_BOOL   mv_switch_rmu_rx(const MV_U8 *frame, int len);
+MV_STATUS mv_switch_rmu_rw_reg_list(HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed);
+MV_STATUS mv_switch_rmu_netdev_start(GT_QD_DEV *dev, struct net_device *netdev);
+MV_STATUS mv_switch_rmu_loopback_start(void);
+void      mv_switch_rmu_stop(void);
+int       mv_switch_rmu_show(char *buf);
+MV_STATUS mv_switch_mib_dump(GT_QD_DEV *dev, GT_LPORT port, MV_U32 *counters);
+MV_STATUS mv_switch_atu_dump(GT_QD_DEV *dev, MV_U16 dbNum, const MV_U8 *startMac,
+			     GT_ATU_ENTRY *entries, MV_U32 max, MV_U32 *count);
 #endif /* __mv_switch_h__ */
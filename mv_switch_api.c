@@ -128,6 +128,45 @@ MV_STATUS gstpSetPortState
     return retVal;
 }
 
+/*******************************************************************************
+* gstpGetPortState
+*
+* DESCRIPTION:
+*       This routine returns the port state.
+*
+* INPUTS:
+*       port  - the logical port number.
+*
+* OUTPUTS:
+*       state - the current port state.
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*       Port Control is shadowed, the read costs no SMI access once known.
+*
+*******************************************************************************/
+MV_STATUS gstpGetPortState
+(
+    IN  GT_QD_DEV          *dev,
+    IN  GT_LPORT           port,
+    OUT GT_PORT_STP_STATE  *state
+)
+{
+    unsigned int    data;
+    MV_STATUS       retVal;
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+    retVal = mv_switch_mii_read( port, QD_REG_PORT_CONTROL, &data);
+    if(retVal != MV_OK)
+        return retVal;
+
+    *state = (GT_PORT_STP_STATE)(data & 0x3);
+    return MV_OK;
+}
+
 /*******************************************************************************
 * gprtSetEgressMode
 *
@@ -244,26 +283,202 @@ MV_STATUS gpvtInitialize
 
 }
 
-/*******************************************************************************
-* pvtOperationPerform
-*
-* DESCRIPTION:
-*       This function accesses PVT Table
-*
-* INPUTS:
-*       pvtOp   - The pvt operation
-*       pvtData - address and data to be written into PVT
-*
-* OUTPUTS:
-*       pvtData - data read from PVT pointed by address
-*
-* RETURNS:
-*       MV_OK on success,
-*       MV_FAIL otherwise.
-*
-* COMMENTS:
-*
-*******************************************************************************/
+/*******************************************************************************
+* gpvtWritePVTData
+*
+* DESCRIPTION:
+*       This routine writes Cross Chip Port Vlan Data, the mask of the ports
+*       frames from the given source device and port may egress.
+*
+* INPUTS:
+*       pvtPointer - pointer to the desired entry of PVT (0 ~ 511)
+*       pvtData    - Cross Chip Port Vlan Data
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*       MV_BAD_PARAM - if invalid parameter is given
+*
+* COMMENTS:
+*       None
+*
+*******************************************************************************/
+MV_STATUS gpvtWritePVTData
+(
+    IN  GT_QD_DEV     *dev,
+    IN  MV_U32        pvtPointer,
+    IN  MV_U32        pvtData
+)
+{
+    MV_STATUS           retVal;
+    GT_PVT_OP_DATA      opData;
+
+    DBG_INFO(("gpvtWritePVTData Called.\n"));
+
+    if(pvtPointer >= MV_SWITCH_PVT_SIZE)
+    {
+        DBG_INFO(("Failed (bad pointer %d).\n", pvtPointer));
+        return MV_BAD_PARAM;
+    }
+
+    opData.pvtAddr = pvtPointer;
+    opData.pvtData = pvtData;
+    retVal = pvtOperationPerform(dev, PVT_WRITE, &opData);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed (pvtOperationPerform returned %d).\n", retVal));
+        return retVal;
+    }
+
+    DBG_INFO(("OK.\n"));
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gpvtReadPVTData
+*
+* DESCRIPTION:
+*       This routine reads Cross Chip Port Vlan Data.
+*
+* INPUTS:
+*       pvtPointer - pointer to the desired entry of PVT (0 ~ 511)
+*
+* OUTPUTS:
+*       pvtData    - Cross Chip Port Vlan Data
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*       MV_BAD_PARAM - if invalid parameter is given
+*
+* COMMENTS:
+*       None
+*
+*******************************************************************************/
+MV_STATUS gpvtReadPVTData
+(
+    IN  GT_QD_DEV     *dev,
+    IN  MV_U32        pvtPointer,
+    OUT MV_U32        *pvtData
+)
+{
+    MV_STATUS           retVal;
+    GT_PVT_OP_DATA      opData;
+
+    DBG_INFO(("gpvtReadPVTData Called.\n"));
+
+    if(pvtPointer >= MV_SWITCH_PVT_SIZE)
+    {
+        DBG_INFO(("Failed (bad pointer %d).\n", pvtPointer));
+        return MV_BAD_PARAM;
+    }
+
+    opData.pvtAddr = pvtPointer;
+    retVal = pvtOperationPerform(dev, PVT_READ, &opData);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed (pvtOperationPerform returned %d).\n", retVal));
+        return retVal;
+    }
+
+    *pvtData = opData.pvtData;
+
+    DBG_INFO(("OK.\n"));
+    return MV_OK;
+}
+
+static void pvtListAdd(HW_DEV_RW_REG *list, MV_U32 *n, MV_U32 cmd, MV_U32 reg, MV_U32 data)
+{
+    list[*n].cmd = cmd;
+    list[*n].addr = 0x1c;
+    list[*n].reg = reg;
+    list[*n].data = data;
+    (*n)++;
+}
+
+/*******************************************************************************
+* pvtOperationRun
+*
+* DESCRIPTION:
+*       This function accesses PVT Table
+*
+* INPUTS:
+*       pvtOp   - The pvt operation
+*       pvtData - address and data to be written into PVT
+*
+* OUTPUTS:
+*       pvtData - data read from PVT pointed by address
+*
+* RETURNS:
+*       MV_OK on success,
+*       MV_NOT_READY if the PVT stayed busy past the register poll deadline,
+*       MV_FAIL otherwise.
+*
+* COMMENTS:
+*       The busy bit is sampled by a read that goes out in the same register
+*       list as the access before it, and only when it is found set is the
+*       bounded wait (mv_switch_pvt_cmd_wait) entered. The data of a write is
+*       staged before that read, while the previous write may still be in
+*       flight: a write samples the data register when it starts and reads
+*       always complete here, so nothing else changes it in the meantime.
+*
+*******************************************************************************/
+static MV_STATUS pvtOperationRun
+(
+    IN    GT_QD_DEV           *dev,
+    IN    GT_PVT_OPERATION   pvtOp,
+    INOUT GT_PVT_OP_DATA     *opData
+)
+{
+    HW_DEV_RW_REG   list[3];
+    MV_STATUS       retVal;
+    MV_U32          n = 0, pointer;
+
+    if(pvtOp != PVT_INITIALIZE && pvtOp != PVT_WRITE && pvtOp != PVT_READ)
+        return MV_FAIL;
+    pointer = (pvtOp == PVT_INITIALIZE) ? 0 : (opData->pvtAddr & (MV_SWITCH_PVT_SIZE - 1));
+
+    /* stage the data and check that the previous operation is over */
+    if(pvtOp == PVT_WRITE)
+        pvtListAdd(list, &n, HW_REG_WRITE, QD_REG_PVT_DATA, (MV_U16)opData->pvtData);
+    pvtListAdd(list, &n, HW_REG_READ, QD_REG_PVT_ADDR, 0);
+    retVal = mv_switch_dev_rw_reg_list(dev, list, n, NULL);
+    if(retVal == MV_OK && (list[n - 1].data & 0x8000))
+        retVal = mv_switch_pvt_cmd_wait(dev);
+    if(retVal != MV_OK)
+    {
+        mv_switch_pvt_cmd_done(0, retVal);
+        return retVal;
+    }
+
+    /* start the operation; a read returns its data once the PVT is idle */
+    n = 0;
+    pvtListAdd(list, &n, HW_REG_WRITE, QD_REG_PVT_ADDR, (1 << 15) | (pvtOp << 12) | pointer);
+    if(pvtOp == PVT_READ)
+    {
+        pvtListAdd(list, &n, HW_REG_READ, QD_REG_PVT_ADDR, 0);
+        pvtListAdd(list, &n, HW_REG_READ, QD_REG_PVT_DATA, 0);
+    }
+    retVal = mv_switch_dev_rw_reg_list(dev, list, n, NULL);
+
+    if(retVal == MV_OK && pvtOp == PVT_READ && (list[1].data & 0x8000))
+    {
+        /* the data was read before the PVT was done, read it again */
+        retVal = mv_switch_pvt_cmd_wait(dev);
+        if(retVal == MV_OK)
+            retVal = mv_switch_dev_rw_reg_list(dev, &list[2], 1, NULL);
+    }
+    if(retVal == MV_OK && pvtOp == PVT_READ)
+        opData->pvtData = list[2].data;
+
+    mv_switch_pvt_cmd_done(1, retVal);
+    return retVal;
+}
+
+/* PVT operation under the table semaphore (PVT shares it with other tables) */
 static MV_STATUS pvtOperationPerform
 (
     IN    GT_QD_DEV           *dev,
@@ -271,87 +486,107 @@ static MV_STATUS pvtOperationPerform
     INOUT GT_PVT_OP_DATA     *opData
 )
 {
-    MV_STATUS       retVal;    /* Functions return value */
-    MV_U16          data;     /* temporary Data storage */
-
-    /* Wait until the pvt in ready. */
-
-    data = 0x8000;  // BIT15
-    while(data & 0x8000)
-    {
-        retVal = mv_switch_mii_read( 0x1c, QD_REG_PVT_ADDR, (MV_U16 *) &data);
-        if(retVal != MV_OK)
-        {
-            return retVal;
-        }
-    }
-
-    /* Set the PVT Operation register */
-    switch (pvtOp)
-    {
-        case PVT_INITIALIZE:
-            data = (1 << 15) | (pvtOp << 12);
-            retVal = mv_switch_mii_write( 0x1c, QD_REG_PVT_ADDR, data);
-            if(retVal != MV_OK)
-            {
-                 return retVal;
-            }
-            break;
-
-        case PVT_WRITE:
-            data = (MV_U16)opData->pvtData;
-            retVal = mv_switch_mii_write( 0x1c, QD_REG_PVT_ADDR, data);
-            
-            if(retVal != MV_OK)
-            {
-                return retVal;
-            }
-
-            data = (MV_U16)((1 << 15) | (pvtOp << 12) | opData->pvtAddr);
-            retVal = mv_switch_mii_write( 0x1c, QD_REG_PVT_ADDR, data);
-
-            if(retVal != MV_OK)
-            {
-                return retVal;
-            }
-            break;
+    MV_STATUS       retVal;
 
-        case PVT_READ:
-            data = (MV_U16)((1 << 15) | (pvtOp << 12) | opData->pvtAddr);
-            retVal = mv_switch_mii_write( 0x1c, QD_REG_PVT_ADDR, data);
-            
-            if(retVal != MV_OK)
-            {
-                return retVal;
-            }
-            
-            data = 0x8000;  // BIT15
-            
-            while(data & 0x8000)
-            {
-                retVal = mv_switch_mii_read( 0x1c, QD_REG_PVT_ADDR, &data);
-                if(retVal != MV_OK)
-                {
-                    return retVal;
-                }
-            }
-
-            retVal = mv_switch_mii_read( 0x1c, QD_REG_PVT_DATA, &data);
-            opData->pvtData = (MV_U32)data;
-            if(retVal != MV_OK)
-            {
-                return retVal;
-            }
-
-            break;
-
-        default:
-
-            return MV_FAIL;
-    }
+    gtSemTake(dev, dev->tblRegsSem, OS_WAIT_FOREVER);
+    retVal = pvtOperationRun(dev, pvtOp, opData);
+    gtSemGive(dev, dev->tblRegsSem);
 
     return retVal;
 }
+
+/* Register list of one gpvtLoadPVTMatrix chunk, used under tblRegsSem */
+static HW_DEV_RW_REG pvtLoadList[MV_SWITCH_PVT_LOAD_CHUNK * MV_SWITCH_PVT_LOAD_OPS + 1];
+
+/*******************************************************************************
+* gpvtLoadPVTMatrix
+*
+* DESCRIPTION:
+*       Writes the Cross Chip Port Vlan Data of srcDevs source devices by
+*       srcPorts source ports, entry MV_SWITCH_PVT_POINTER(dev, port).
+*
+* INPUTS:
+*       srcDevs  - number of source devices (1 ~ 32).
+*       srcPorts - number of source ports per device (1 ~ 16).
+*       pvtData  - the port masks, pvtData[dev * srcPorts + port].
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK          - all entries were written.
+*       MV_BAD_PARAM   - the matrix does not fit the table.
+*       MV_NOT_READY   - the PVT stayed busy.
+*       other          - the error of the register access.
+*
+* COMMENTS:
+*       MV_SWITCH_PVT_LOAD_CHUNK entries go to the switch in one register
+*       list, each with a single busy poll before its operation. The data
+*       of an entry is staged before that poll, while the previous write is
+*       still in flight, and only when it differs from the previous entry,
+*       so rows of the same mask cost the poll and the operation write.
+*
+*******************************************************************************/
+MV_STATUS gpvtLoadPVTMatrix
+(
+    IN  GT_QD_DEV     *dev,
+    IN  MV_U32        srcDevs,
+    IN  MV_U32        srcPorts,
+    IN  MV_U32        *pvtData
+)
+{
+    MV_STATUS       retVal = MV_OK;
+    MV_U32          count, i, j, n, chunk, pointer;
+    MV_U16          cur = 0, data;
+    MV_BOOL         curValid = MV_FALSE;
+    ktime_t         start;
+
+    DBG_INFO(("gpvtLoadPVTMatrix Called.\n"));
+
+    if(srcDevs == 0 || srcDevs > MV_SWITCH_PVT_DEVS || srcPorts == 0 || srcPorts > MV_SWITCH_PVT_PORTS)
+    {
+        DBG_INFO(("Failed (bad matrix %dx%d).\n", srcDevs, srcPorts));
+        return MV_BAD_PARAM;
+    }
+    count = srcDevs * srcPorts;
+
+    gtSemTake(dev, dev->tblRegsSem, OS_WAIT_FOREVER);
+
+    for(i = 0; i < count; i += chunk)
+    {
+        chunk = min_t(MV_U32, count - i, MV_SWITCH_PVT_LOAD_CHUNK);
+
+        n = 0;
+        for(j = i; j < i + chunk; j++)
+        {
+            pointer = MV_SWITCH_PVT_POINTER(j / srcPorts, j % srcPorts);
+            data = (MV_U16)pvtData[j];
+
+            if(!curValid || cur != data)
+                pvtListAdd(pvtLoadList, &n, HW_REG_WRITE, QD_REG_PVT_DATA, data);
+            cur = data;
+            curValid = MV_TRUE;
+            pvtListAdd(pvtLoadList, &n, HW_REG_WAIT_TILL_0, QD_REG_PVT_ADDR, 15);
+            pvtListAdd(pvtLoadList, &n, HW_REG_WRITE, QD_REG_PVT_ADDR,
+                       (1 << 15) | (PVT_WRITE << 12) | pointer);
+        }
+        /* the last write is over when the list returns */
+        pvtListAdd(pvtLoadList, &n, HW_REG_WAIT_TILL_0, QD_REG_PVT_ADDR, 15);
+
+        start = ktime_get();
+        retVal = mv_switch_dev_rw_reg_list(dev, pvtLoadList, n, NULL);
+        mv_switch_pvt_list_done(chunk, retVal, (MV_U32)ktime_us_delta(ktime_get(), start));
+        if(retVal != MV_OK)
+        {
+            DBG_INFO(("Failed (entries %d..%d).\n", i, i + chunk - 1));
+            break;
+        }
+    }
+
+    gtSemGive(dev, dev->tblRegsSem);
+
+    return retVal;
+}
 
 /*******************************************************************************
 * gprtSetFrameMode
@@ -787,84 +1022,167 @@ MV_STATUS gvlnSetPortVlanDot1qMode
 }
 
 /*******************************************************************************
-* gpcsSetForceSpeed
+* gvlnSetPortVid
 *
 * DESCRIPTION:
-*		This routine forces Speed.
+*       This routine Set the port default vlan id.
 *
 * INPUTS:
-*		port - the logical port number.
-*		mode - GT_PORT_FORCED_SPEED_MODE (10, 100, 1000, or no force speed)
+*       port - logical port number to set.
+*       vid  - the port vlan id.
 *
 * OUTPUTS:
-*		None
+*       None.
 *
 * RETURNS:
-*		MV_OK   - on success
-*		MV_FAIL - on error
-*		MV_NOT_SUPPORTED - if current device does not support this feature.
+*       MV_OK               - on success
+*       MV_FAIL             - on error
+*       MV_BAD_PARAM        - on bad parameters
 *
 * COMMENTS:
-*
-* GalTis:
+*       Port Default VLAN ID & Priority register, bits 11:0.
 *
 *******************************************************************************/
-MV_STATUS gpcsSetForceSpeed
+MV_STATUS gvlnSetPortVid
 (
-	IN GT_QD_DEV	*dev,
-	IN GT_LPORT 	port,
-	IN GT_PORT_FORCED_SPEED_MODE  mode
+    IN GT_QD_DEV *dev,
+    IN GT_LPORT port,
+    IN MV_U16   vid
 )
 {
-    DBG_INFO(("gpcsSetForceSpeed Called.\n"));
+    DBG_INFO(("gvlnSetPortVid Called.\n"));
 
-    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+    if(vid > 0xFFF)
+        return MV_BAD_PARAM;
 
-    /* Set the Force Speed bits.  */
-    return mv_switch_mii_write_RegField( port, QD_REG_PCS_CONTROL,0,2, (MV_U16)mode);
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+    return mv_switch_mii_write_RegField( port, QD_REG_PVID, 0, 12, vid);
 }
-
+
 /*******************************************************************************
-* gpcsSetDpxValue
+* gvlnSetPortVlanDBNum
 *
 * DESCRIPTION:
-*		This routine sets Duplex's Forced value. This function needs to be
-*		called prior to gpcsSetForcedDpx.
+*       This routine sets the port VLAN database number (DBNum).
 *
 * INPUTS:
-*		port - the logical port number.
-*		state - MV_TRUE to force full duplex, MV_FALSE otherwise
+*       port    - logical port number to set.
+*       DBNum   - database number for this port
 *
 * OUTPUTS:
-*		None
+*       None.
 *
 * RETURNS:
-*		MV_OK   - on success
-*		MV_FAIL - on error
-*		MV_NOT_SUPPORTED - if current device does not support this feature.
+*       MV_OK               - on success
+*       MV_FAIL             - on error
+*       MV_BAD_PARAM        - on bad parameters
 *
 * COMMENTS:
-*
-* GalTis:
+*       The default FID is split: bits 3:0 in Port Based VLAN Map bits
+*       15:12, bits 11:4 in Port Control 1 bits 7:0.
 *
 *******************************************************************************/
-MV_STATUS gpcsSetDpxValue
+MV_STATUS gvlnSetPortVlanDBNum
 (
-	IN GT_QD_DEV	*dev,
-	IN GT_LPORT 	port,
-	IN MV_BOOL	state
+    IN GT_QD_DEV *dev,
+    IN GT_LPORT port,
+    IN MV_U32   DBNum
 )
 {
-    MV_U16          data;           /* Used to poll the SWReset bit */
+    MV_STATUS       retVal;
 
-    DBG_INFO(("gpcsSetDpxValue Called.\n"));
+    DBG_INFO(("gvlnSetPortVlanDBNum Called.\n"));
+
+    if(DBNum > 0xFFF)
+        return MV_BAD_PARAM;
 
-    BOOL_2_BIT(state, data);
     port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+    retVal = mv_switch_mii_write_RegField( port, QD_REG_PORT_VLAN_MAP, 12, 4, (MV_U16)(DBNum & 0xF));
+    if(retVal != MV_OK)
+        return retVal;
 
-    /* Get the DpxValue bit.  */
-    return mv_switch_mii_write_RegField( port, QD_REG_PCS_CONTROL,3,1,data);
-}
+    return mv_switch_mii_write_RegField( port, QD_REG_PORT_CONTROL1, 0, 8, (MV_U16)(DBNum >> 4));
+}
+
+/*******************************************************************************
+* gpcsSetForceSpeed
+*
+* DESCRIPTION:
+*		This routine forces Speed.
+*
+* INPUTS:
+*		port - the logical port number.
+*		mode - GT_PORT_FORCED_SPEED_MODE (10, 100, 1000, or no force speed)
+*
+* OUTPUTS:
+*		None
+*
+* RETURNS:
+*		MV_OK   - on success
+*		MV_FAIL - on error
+*		MV_NOT_SUPPORTED - if current device does not support this feature.
+*
+* COMMENTS:
+*
+* GalTis:
+*
+*******************************************************************************/
+MV_STATUS gpcsSetForceSpeed
+(
+	IN GT_QD_DEV	*dev,
+	IN GT_LPORT 	port,
+	IN GT_PORT_FORCED_SPEED_MODE  mode
+)
+{
+    DBG_INFO(("gpcsSetForceSpeed Called.\n"));
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    /* Set the Force Speed bits.  */
+    return mv_switch_mii_write_RegField( port, QD_REG_PCS_CONTROL,0,2, (MV_U16)mode);
+}
+
+/*******************************************************************************
+* gpcsSetDpxValue
+*
+* DESCRIPTION:
+*		This routine sets Duplex's Forced value. This function needs to be
+*		called prior to gpcsSetForcedDpx.
+*
+* INPUTS:
+*		port - the logical port number.
+*		state - MV_TRUE to force full duplex, MV_FALSE otherwise
+*
+* OUTPUTS:
+*		None
+*
+* RETURNS:
+*		MV_OK   - on success
+*		MV_FAIL - on error
+*		MV_NOT_SUPPORTED - if current device does not support this feature.
+*
+* COMMENTS:
+*
+* GalTis:
+*
+*******************************************************************************/
+MV_STATUS gpcsSetDpxValue
+(
+	IN GT_QD_DEV	*dev,
+	IN GT_LPORT 	port,
+	IN MV_BOOL	state
+)
+{
+    MV_U16          data;           /* Used to poll the SWReset bit */
+
+    DBG_INFO(("gpcsSetDpxValue Called.\n"));
+
+    BOOL_2_BIT(state, data);
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    /* Get the DpxValue bit.  */
+    return mv_switch_mii_write_RegField( port, QD_REG_PCS_CONTROL,3,1,data);
+}
 
 /*******************************************************************************
 * gpcsSetForcedDpx
@@ -1076,7 +1394,7 @@ MV_STATUS gpcsSetForcedLink
 }
 
 /*******************************************************************************
-* atuOperationPerform
+* atuOperationRun
 *
 * DESCRIPTION:
 *       This function is used by all ATU control functions, and is responsible
@@ -1105,7 +1423,7 @@ MV_STATUS gpcsSetForcedLink
 *       1.  if atuMac == NULL, nothing needs to be written to ATU Mac registers.
 *
 *******************************************************************************/
-static MV_STATUS atuOperationPerform
+static MV_STATUS atuOperationRun
 (
     IN      GT_QD_DEV           *dev,
     IN      GT_ATU_OPERATION    atuOp,
@@ -1114,7 +1432,7 @@ static MV_STATUS atuOperationPerform
 )
 {
     MV_STATUS       retVal;         /* Functions return value.      */
-    MV_U16          data;           /* Data to be set into the      */
+    unsigned int    data;           /* Data to be set into the      */
                                     /* register.                    */
     MV_U16          opcodeData;           /* Data to be set into the      */
                                     /* register.                    */
@@ -1123,14 +1441,16 @@ static MV_STATUS atuOperationPerform
 
     portMask = (1 << dev->maxPorts) - 1;
 
-    data = 0x8000;
-    while(data == 0x8000)
+    /* a wedged ATU fails at once, an idle one after a bounded wait */
+    retVal = mv_switch_atu_cmd_ready(dev, 1);
+    if(retVal != MV_OK)
     {
-        retVal = mv_switch_mii_read( 0x1b, QD_REG_ATU_OPERATION, &data);
-        if(retVal != MV_OK)
-        {
-            return retVal;
-        }
+        return retVal;
+    }
+    retVal = mv_switch_atu_cmd_wait(dev);
+    if(retVal != MV_OK)
+    {
+        return retVal;
     }
 
     opcodeData = 0;
@@ -1207,15 +1527,11 @@ static MV_STATUS atuOperationPerform
     /* If the operation is to service violation operation wait for the response   */
     if(atuOp == SERVICE_VIOLATIONS)
     {
-        /* Wait until the VTU in ready. */
-        data = 0x8000;
-        while(data == 0x8000)
+        /* Wait until the ATU is ready. */
+        retVal = mv_switch_atu_cmd_wait(dev);
+        if(retVal != MV_OK)
         {
-            retVal = mv_switch_mii_read( 0x1b, QD_REG_ATU_OPERATION, &data);
-            if(retVal != MV_OK)
-            {
-                return retVal;
-            }
+            return retVal;
         }
 
         /* get the Interrupt Cause */
@@ -1289,15 +1605,11 @@ static MV_STATUS atuOperationPerform
         entry->exPrio.macFPri = 0;
         entry->exPrio.macQPri = 0;
 
-        /* Wait until the ATU in ready. */
-        data = 0x8000;
-        while(data == 0x8000)
+        /* Wait until the ATU is ready. */
+        retVal = mv_switch_atu_cmd_wait(dev);
+        if(retVal != MV_OK)
         {
-            retVal = mv_switch_mii_read( 0x1b, QD_REG_ATU_OPERATION, &data);
-            if(retVal != MV_OK)
-            {
-                return retVal;
-            }
+            return retVal;
         }
 
         /* Get the Mac address  */
@@ -1326,6 +1638,27 @@ static MV_STATUS atuOperationPerform
     return MV_OK;
 }
 
+/* ATU operation under the ATU semaphore, see atuOperationRun */
+static MV_STATUS atuOperationPerform
+(
+    IN      GT_QD_DEV           *dev,
+    IN      GT_ATU_OPERATION    atuOp,
+    INOUT   GT_EXTRA_OP_DATA    *opData,
+    INOUT   GT_ATU_ENTRY        *entry
+)
+{
+    MV_STATUS       retVal;
+
+    gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+    retVal = atuOperationRun(dev, atuOp, opData, entry);
+    /* keep the ATU mirror coherent, in ATU order */
+    if(retVal == MV_OK)
+        mv_switch_atu_mirror_op(atuOp, opData, entry);
+    gtSemGive(dev, dev->atuRegsSem);
+
+    return retVal;
+}
+
 /*******************************************************************************
 * gfdbFlush
 *
@@ -1376,104 +1709,2773 @@ MV_STATUS gfdbFlush
     return retVal;
 }
 
-MV_STATUS gprtPortPowerGet( IN GT_QD_DEV  *dev, IN GT_LPORT port)
+/*******************************************************************************
+* gfdbFlushInDB
+*
+* DESCRIPTION:
+*       This routine flush all or unblocked addresses from the particular
+*       ATU Database (DBNum). If multiple address databases are being used, this
+*        API can be used to flush entries in a particular DBNum database.
+*
+* INPUTS:
+*       flushCmd - the flush operation type.
+*        DBNum     - ATU MAC Address Database Number.
+*
+* OUTPUTS:
+*       None
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*       MV_BAD_PARAM    - DBNum out of range
+*
+* COMMENTS:
+*
+*******************************************************************************/
+MV_STATUS gfdbFlushInDB
+(
+    IN GT_QD_DEV *dev,
+    IN GT_FLUSH_CMD flushCmd,
+    IN MV_U32 DBNum
+)
+{
+    MV_STATUS       retVal;
+    GT_ATU_ENTRY    entry;
+
+    DBG_INFO(("gfdbFlushInDB Called.\n"));
+
+    if(DBNum > MV_SWITCH_ATU_DB_MAX)
+        return MV_BAD_PARAM;
+
+    entry.DBNum = (MV_U16)DBNum;
+    entry.entryState.ucEntryState = 0;
+
+    if(flushCmd == GT_FLUSH_ALL)
+        retVal = atuOperationPerform(dev,FLUSH_ALL_IN_DB,NULL,&entry);
+    else
+        retVal = atuOperationPerform(dev,FLUSH_UNLOCKED_IN_DB,NULL,&entry);
+
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+    }
+
+    return retVal;
+}
+
+/*
+ * Move (moveTo < 0xF) or remove (moveTo == 0xF) the entries of port
+ * moveFrom: a flush operation with entry state 0xF and the ports in the
+ * ATU data register. allDb selects all databases or DBNum only.
+ */
+static MV_STATUS atuMovePerform
+(
+    IN GT_QD_DEV    *dev,
+    IN GT_MOVE_CMD  moveCmd,
+    IN MV_BOOL      allDb,
+    IN MV_U32       DBNum,
+    IN MV_U32       moveFrom,
+    IN MV_U32       moveTo
+)
 {
-    MV_U16          data;
-
-    mv_switch_mii_read( port, QD_PHY_CONTROL_REG, &data);
-     
-    data = (data >> 11) & 1;   
-    return !data;
+    MV_STATUS           retVal;
+    GT_ATU_ENTRY        entry;
+    GT_EXTRA_OP_DATA    opData;
+    GT_ATU_OPERATION    atuOp;
+
+    if((moveFrom >= dev->numOfPorts) || ((moveTo >= dev->numOfPorts) && (moveTo != 0xF)) ||
+       (moveFrom == moveTo) || (DBNum > MV_SWITCH_ATU_DB_MAX))
+        return MV_BAD_PARAM;
+
+    entry.DBNum = (MV_U16)DBNum;
+    entry.entryState.ucEntryState = 0xF;
+    opData.moveFrom = moveFrom;
+    opData.moveTo = moveTo;
+
+    if(allDb == MV_TRUE)
+        atuOp = (moveCmd == GT_MOVE_ALL) ? FLUSH_ALL : FLUSH_UNLOCKED;
+    else
+        atuOp = (moveCmd == GT_MOVE_ALL) ? FLUSH_ALL_IN_DB : FLUSH_UNLOCKED_IN_DB;
+
+    retVal = atuOperationPerform(dev, atuOp, &opData, &entry);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+    }
+
+    return retVal;
 }
 
 /*******************************************************************************
-* gprtPortPowerSet
+* gfdbMove
 *
 * DESCRIPTION:
-*       This routine resets port disables/enables port power
+*        This routine moves all or unblocked addresses from a port to another.
 *
 * INPUTS:
-*       port  - the logical port number.
-*       onoff - 0 port power down, otherwise port power up
+*        moveCmd  - the move operation type.
+*        moveFrom - port where moving from
+*        moveTo   - port where moving to
 *
 * OUTPUTS:
-*       None.
+*        None
 *
 * RETURNS:
-*       MV_OK   - on success
-*       MV_FAIL - on error
+*        MV_OK           - on success
+*        MV_FAIL         - on error
+*        MV_BAD_PARAM    - on bad port numbers
 *
 * COMMENTS:
 *
+*******************************************************************************/
+MV_STATUS gfdbMove
+(
+    IN GT_QD_DEV     *dev,
+    IN GT_MOVE_CMD    moveCmd,
+    IN MV_U32        moveFrom,
+    IN MV_U32        moveTo
+)
+{
+    DBG_INFO(("gfdbMove Called.\n"));
+
+    return atuMovePerform(dev, moveCmd, MV_TRUE, 0, moveFrom, moveTo);
+}
+
+/*******************************************************************************
+* gfdbMoveInDB
+*
+* DESCRIPTION:
+*         This routine move all or unblocked addresses which are in the particular
+*         ATU Database (DBNum) from a port to another.
 *
-* GalTis:
+* INPUTS:
+*         moveCmd  - the move operation type.
+*        DBNum         - ATU MAC Address Database Number.
+*        moveFrom - port where moving from
+*        moveTo   - port where moving to
+*
+* OUTPUTS:
+*     None
+*
+* RETURNS:
+*         MV_OK           - on success
+*         MV_FAIL         - on error
+*         MV_BAD_PARAM    - on bad port numbers or DBNum
+*
+* COMMENTS:
 *
 *******************************************************************************/
-MV_STATUS gprtPortPowerSet(IN GT_QD_DEV  *dev,
-			   IN GT_LPORT   port,
-			   IN MV_BOOL    onoff)
+MV_STATUS gfdbMoveInDB
+(
+    IN GT_QD_DEV   *dev,
+    IN GT_MOVE_CMD moveCmd,
+    IN MV_U32         DBNum,
+    IN MV_U32        moveFrom,
+    IN MV_U32        moveTo
+)
 {
-      
-        // Set Phy to page#2
-        mv_switch_mii_write_RegField( port, 22, 0, 8, 2);
-        
-	if (onoff != MV_TRUE) {
-		mv_switch_mii_write_RegField( port, QD_PHY_SPEC_CONTROL_REG, 3, 1, 0);
-        	
-        	// Set Phy to page#0
-        	mv_switch_mii_write_RegField( port, 22, 0, 8, 0);
-		
-		/* Page 0, register 16, bits 3,2. Copper Transmitter disable, Power down */
-		mv_switch_mii_write_RegField( port, QD_PHY_SPEC_CONTROL_REG, 2, 2, 3);
-		
-		/* Register 0, bit 11, Power Down */
-		mv_switch_mii_write_RegField( port, QD_PHY_CONTROL_REG, 11, 1, 1);
-	} else {
-		/* Page 2, register 16, bit 3 GMII intefrace power down */
-		mv_switch_mii_write_RegField( port, QD_PHY_SPEC_CONTROL_REG, 3, 1, 1);
-		
-        	// Set Phy to page#0
-        	mv_switch_mii_write_RegField( port, 22, 0, 8, 0);
-
-		/* Page 0, register 16, bits 3,2. Copper Transmitter disable, Power down */
-		mv_switch_mii_write_RegField( port, QD_PHY_SPEC_CONTROL_REG, 2, 2, 0);
-		
-		/* Register 0, bit 11, Power Down */
-		mv_switch_mii_write_RegField( port, QD_PHY_CONTROL_REG, 11, 1, 0);
-	}
-	return 0;
+    DBG_INFO(("gfdbMoveInDB Called.\n"));
+
+    return atuMovePerform(dev, moveCmd, MV_FALSE, DBNum, moveFrom, moveTo);
 }
-
+
 /*******************************************************************************
-* gprtGetLinkState
+* gfdbRemovePort
 *
 * DESCRIPTION:
-*       This routine retrives the link state.
+*       This routine deassociages all or unblocked addresses from a port.
 *
 * INPUTS:
+*       moveCmd - the move operation type.
 *       port - the logical port number.
 *
 * OUTPUTS:
-*       state - MV_TRUE for Up  or MV_FALSE otherwise
+*       None
 *
 * RETURNS:
-*       MV_OK   - on success
-*       MV_FAIL - on error
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*       MV_BAD_PARAM    - on bad port number
 *
 * COMMENTS:
+*       Entries left without a port are purged by the ATU.
+*
+*******************************************************************************/
+MV_STATUS gfdbRemovePort
+(
+    IN GT_QD_DEV    *dev,
+    IN GT_MOVE_CMD     moveCmd,
+    IN GT_LPORT        port
+)
+{
+    DBG_INFO(("gfdbRemovePort Called.\n"));
+
+    return atuMovePerform(dev, moveCmd, MV_TRUE, 0, port, 0xF);
+}
+
+/*******************************************************************************
+* gfdbRemovePortInDB
+*
+* DESCRIPTION:
+*       This routine deassociages all or unblocked addresses from a port in the
+*       particular ATU Database (DBNum).
 *
+* INPUTS:
+*       moveCmd  - the move operation type.
+*       port - the logical port number.
+*        DBNum     - ATU MAC Address Database Number.
 *
-* GalTis:
+* OUTPUTS:
+*       None
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*       MV_BAD_PARAM    - on bad port number or DBNum
+*
+* COMMENTS:
+*       Entries left without a port are purged by the ATU.
 *
 *******************************************************************************/
-MV_STATUS gprtGetLinkState
+MV_STATUS gfdbRemovePortInDB
 (
-    IN  GT_QD_DEV *dev,
-    IN  GT_LPORT  port,
-    OUT MV_BOOL   *state
+    IN GT_QD_DEV    *dev,
+    IN GT_MOVE_CMD     moveCmd,
+    IN GT_LPORT        port,
+    IN MV_U32         DBNum
 )
-{
-    MV_U16          data;           /* Used to poll the SWReset bit */
+{
+    DBG_INFO(("gfdbRemovePortInDB Called.\n"));
+
+    return atuMovePerform(dev, moveCmd, MV_FALSE, DBNum, port, 0xF);
+}
+
+/* ATU Control register AgeTime field (bits 11:4) unit, seconds */
+#define ATU_AGE_TIME_BASE           15
+
+/*******************************************************************************
+* gfdbGetAgingTimeRange
+*
+* DESCRIPTION:
+*       Gets the maximal and minimum age times that the hardware can support.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       maxTimeout - max aging time in secounds.
+*       minTimeout - min aging time in secounds.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_BAD_PARAM    - on bad parameter
+*
+* COMMENTS:
+*       None.
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAgingTimeRange
+(
+    IN GT_QD_DEV *dev,
+    OUT MV_U32 *maxTimeout,
+    OUT MV_U32 *minTimeout
+)
+{
+    DBG_INFO(("gfdbGetAgingTimeRange Called.\n"));
+
+    if((maxTimeout == NULL) || (minTimeout == NULL))
+        return MV_BAD_PARAM;
+
+    *minTimeout = ATU_AGE_TIME_BASE;
+    *maxTimeout = ATU_AGE_TIME_BASE * 0xFF;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gfdbGetAgingTimeout
+*
+* DESCRIPTION:
+*       Gets the timeout period in seconds for aging out dynamically learned
+*       forwarding information. The returned value may not be the same as the value
+*        programmed with <gfdbSetAgingTimeout>. Please refer to the description of
+*        <gfdbSetAgingTimeout>.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       timeout - aging time in seconds.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*
+* COMMENTS:
+*       None.
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAgingTimeout
+(
+    IN  GT_QD_DEV    *dev,
+    OUT MV_U32       *timeout
+)
+{
+    MV_STATUS       retVal;
+    unsigned int    data;
+
+    DBG_INFO(("gfdbGetAgingTimeout Called.\n"));
+
+    retVal = mv_switch_mii_read(0x1b, QD_REG_ATU_CONTROL, &data);
+    *timeout = ((data >> 4) & 0xFF) * ATU_AGE_TIME_BASE;
+
+    return retVal;
+}
+
+/*******************************************************************************
+* gfdbSetAgingTimeout
+*
+* DESCRIPTION:
+*       Sets the timeout period in seconds for aging out dynamically learned
+*       forwarding information. The standard recommends 300 sec.
+*        Supported aging timeout values are multiple of time-base, 15 seconds
+*        for this device, up to 3825. Other values are rounded down to a
+*        supported value; values below 15 become 15.
+*
+* INPUTS:
+*       timeout - aging time in seconds.
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*
+* COMMENTS:
+*       None.
+*
+*******************************************************************************/
+MV_STATUS gfdbSetAgingTimeout
+(
+    IN GT_QD_DEV *dev,
+    IN MV_U32 timeout
+)
+{
+    MV_U32          data;
+
+    DBG_INFO(("gfdbSetAgingTimeout Called.\n"));
+
+    data = timeout / ATU_AGE_TIME_BASE;
+    if(data == 0)
+        data = 1;
+    if(data > 0xFF)
+        data = 0xFF;
+
+    return mv_switch_mii_write_RegField(0x1b, QD_REG_ATU_CONTROL, 4, 8, (MV_U16)data);
+}
+
+/* ATU Stats register (Global 2): bin select 15:14, count mode 13:12, count 11:0 */
+#define ATU_STATS_ALL               0
+#define ATU_STATS_NON_STATIC        1
+#define ATU_STATS_ALL_FID           2
+#define ATU_STATS_NON_STATIC_FID    3
+
+/*
+ * Count ATU entries with the ATU Stats register: the counter is updated
+ * by a GetNext from the broadcast address, once per bin of the hash
+ * buckets.
+ */
+static MV_STATUS atuStatsGet
+(
+    IN  GT_QD_DEV   *dev,
+    IN  MV_U32      mode,
+    IN  MV_U32      dbNum,
+    OUT MV_U32      *count
+)
+{
+    MV_STATUS       retVal = MV_OK;
+    GT_ATU_ENTRY    entry;
+    unsigned int    data;
+    MV_U32          bin;
+
+    if(dbNum > MV_SWITCH_ATU_DB_MAX)
+        return MV_BAD_PARAM;
+
+    *count = 0;
+
+    gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+    for(bin = 0; bin < 4; bin++)
+    {
+        retVal = mv_switch_mii_write(0x1c, QD_REG_ATU_STATS, (bin << 14) | (mode << 12));
+        if(retVal != MV_OK)
+            break;
+
+        memset(&entry, 0, sizeof(entry));
+        memset(entry.macAddr, 0xFF, 6);
+        entry.DBNum = (MV_U16)dbNum;
+        retVal = atuOperationRun(dev, GET_NEXT_ENTRY, NULL, &entry);
+        if(retVal != MV_OK)
+            break;
+
+        retVal = mv_switch_mii_read(0x1c, QD_REG_ATU_STATS, &data);
+        if(retVal != MV_OK)
+            break;
+        *count += data & 0xFFF;
+    }
+    gtSemGive(dev, dev->atuRegsSem);
+
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+    }
+
+    return retVal;
+}
+
+/*******************************************************************************
+* gfdbGetAtuAllCount
+*
+* DESCRIPTION:
+*       Counts all entries in the Address Translation Unit.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       count - number of valid entries.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*
+* COMMENTS:
+*       None
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAtuAllCount
+(
+    IN  GT_QD_DEV     *dev,
+    OUT MV_U32         *count
+)
+{
+    DBG_INFO(("gfdbGetAtuAllCount Called.\n"));
+
+    return atuStatsGet(dev, ATU_STATS_ALL, 0, count);
+}
+
+/*******************************************************************************
+* gfdbGetAtuDynamicCount
+*
+* DESCRIPTION:
+*       Gets the current number of dynamic unicast entries in this
+*       Filtering Database.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       numDynEntries - number of dynamic entries.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*
+* COMMENTS:
+*       None
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAtuDynamicCount
+(
+    IN GT_QD_DEV *dev,
+    OUT MV_U32 *numDynEntries
+)
+{
+    DBG_INFO(("gfdbGetAtuDynamicCount Called.\n"));
+
+    return atuStatsGet(dev, ATU_STATS_NON_STATIC, 0, numDynEntries);
+}
+
+/*******************************************************************************
+* gfdbGetAtuAllCountInDBNum
+*
+* DESCRIPTION:
+*       Counts all entries in the defined FID (or DBNum).
+*
+* INPUTS:
+*       dbNum - DBNum of FID
+*
+* OUTPUTS:
+*       count - number of valid entries in FID (or DBNum).
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*
+* COMMENTS:
+*       None
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAtuAllCountInDBNum
+(
+    IN  GT_QD_DEV     *dev,
+    IN  MV_U32         dbNum,
+    OUT MV_U32         *count
+)
+{
+    DBG_INFO(("gfdbGetAtuAllCountInDBNum Called.\n"));
+
+    return atuStatsGet(dev, ATU_STATS_ALL_FID, dbNum, count);
+}
+
+/*******************************************************************************
+* gfdbGetAtuDynamicCountInDBNum
+*
+* DESCRIPTION:
+*       Counts all non-static entries in the defined FID (or DBNum).
+*
+* INPUTS:
+*       dbNum - DBNum or FID
+*
+* OUTPUTS:
+*       count - number of valid non-static entries in FID (or DBNum).
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*
+* COMMENTS:
+*       None
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAtuDynamicCountInDBNum
+(
+    IN  GT_QD_DEV     *dev,
+    IN  MV_U32         dbNum,
+    OUT MV_U32         *count
+)
+{
+    DBG_INFO(("gfdbGetAtuDynamicCountInDBNum Called.\n"));
+
+    return atuStatsGet(dev, ATU_STATS_NON_STATIC_FID, dbNum, count);
+}
+
+/*******************************************************************************
+* gfdbGetPortAtuLearnCnt
+*
+* DESCRIPTION:
+*       Read the current number of active unicast MAC addresses associated with
+*        the given port. This counter (LearnCnt) is held at zero if learn limit
+*        (gfdbSetPortAtuLearnLimit API) is set to zero.
+*
+* INPUTS:
+*       port  - logical port number
+*
+* OUTPUTS:
+*       count - current auto learning count
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*       Port ATU Control register: ReadLearnCnt (bit 15) switches bits 9:0
+*       from LearnLimit to LearnCnt. The register is read first, then the
+*       select, the counter read and the restore of the read value go out
+*       as one register list, so nothing else accesses the switch while
+*       the register reads LearnCnt. The register is never cached.
+*       The ATU semaphore is held from the read to the restore, as in
+*       gfdbSetPortAtuLearnLimit, so a limit set meanwhile is not undone.
+*
+*******************************************************************************/
+MV_STATUS gfdbGetPortAtuLearnCnt
+(
+    IN  GT_QD_DEV     *dev,
+    IN  GT_LPORT      port,
+    IN  MV_U32       *count
+)
+{
+    HW_DEV_RW_REG   list[3];
+    MV_STATUS       retVal;
+    unsigned int    data;
+    MV_U32          i;
+
+    DBG_INFO(("gfdbGetPortAtuLearnCnt Called.\n"));
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+    retVal = mv_switch_mii_read(port, QD_REG_PORT_ATU_CONTROL, &data);
+    if(retVal != MV_OK)
+    {
+        gtSemGive(dev, dev->atuRegsSem);
+        return retVal;
+    }
+    /* LimitReached is read only, ReadLearnCnt is found clear */
+    data &= ~0xC000;
+
+    for(i = 0; i < 3; i++)
+    {
+        list[i].addr = port;
+        list[i].reg = QD_REG_PORT_ATU_CONTROL;
+    }
+    list[0].cmd = HW_REG_WRITE;
+    list[0].data = data | 0x8000;
+    list[1].cmd = HW_REG_READ;
+    list[1].data = 0;
+    /* back to LearnLimit */
+    list[2].cmd = HW_REG_WRITE;
+    list[2].data = data;
+
+    retVal = mv_switch_dev_rw_reg_list(dev, list, 3, NULL);
+    gtSemGive(dev, dev->atuRegsSem);
+    if(retVal == MV_OK)
+        *count = list[1].data & 0x3FF;
+
+    return retVal;
+}
+
+/*******************************************************************************
+* gfdbSetPortAtuLearnLimit
+*
+* DESCRIPTION:
+*       Port's auto learning limit. When the limit is non-zero value, the number
+*        of MAC addresses that can be learned on this port are limited to the value
+*        specified in this API. When the learn limit has been reached any frame
+*        that ingresses this port with a source MAC address not already in the
+*        address database that is associated with this port will be discarded.
+*        Normal auto-learning will resume on the port as soon as the number of
+*        active unicast MAC addresses associated to this port is less than the
+*        learn limit.
+*        CPU directed ATU Load, Purge, or Move will not have any effect on the
+*        learn limit.
+*        This feature is disabled when the limit is zero.
+*        The following care is needed when enabling this feature:
+*            1) disable learning on the ports
+*            2) flush all non-static addresses in the ATU
+*            3) define the desired limit for the ports
+*            4) re-enable learing on the ports
+*
+* INPUTS:
+*       port  - logical port number
+*       limit - auto learning limit ( 0 ~ 255 )
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*       MV_BAD_PARAM - if limit > 0xFF
+*
+* COMMENTS:
+*       Port ATU Control register, LearnLimit bits 9:0. Its read-modify-write
+*       runs under the ATU semaphore, see gfdbGetPortAtuLearnCnt.
+*
+*******************************************************************************/
+MV_STATUS gfdbSetPortAtuLearnLimit
+(
+    IN  GT_QD_DEV     *dev,
+    IN  GT_LPORT      port,
+    IN  MV_U32       limit
+)
+{
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gfdbSetPortAtuLearnLimit Called.\n"));
+
+    if(limit > 0xFF)
+        return MV_BAD_PARAM;
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+    retVal = mv_switch_mii_write_RegField(port, QD_REG_PORT_ATU_CONTROL, 0, 10, (MV_U16)limit);
+    gtSemGive(dev, dev->atuRegsSem);
+
+    return retVal;
+}
+
+/*******************************************************************************
+* gfdbGetPortAtuLearnLimit
+*
+* DESCRIPTION:
+*      Port's auto learning limit, see gfdbSetPortAtuLearnLimit.
+*
+* INPUTS:
+*        port  - logical port number
+*
+* OUTPUTS:
+*        limit - auto learning limit ( 0 ~ 255 )
+*
+* RETURNS:
+*        MV_OK   - on success
+*        MV_FAIL - on error
+*
+* COMMENTS:
+*       None.
+*
+*******************************************************************************/
+MV_STATUS gfdbGetPortAtuLearnLimit
+(
+    IN  GT_QD_DEV     *dev,
+    IN  GT_LPORT      port,
+    OUT MV_U32       *limit
+)
+{
+    MV_STATUS       retVal;
+    unsigned int    data;
+
+    DBG_INFO(("gfdbGetPortAtuLearnLimit Called.\n"));
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    retVal = mv_switch_mii_read(port, QD_REG_PORT_ATU_CONTROL, &data);
+    *limit = data & 0x3FF;
+
+    return retVal;
+}
+
+/*******************************************************************************
+* geventSetOverLimitInt
+*
+* DESCRIPTION:
+*        This routine enables/disables Over Limit Interrupt for a port.
+*        If it's enabled, an ATU Miss violation will be generated when port auto
+*        learn reached the limit(refer to gfdbGetPortAtuLimitReached API).
+*
+* INPUTS:
+*        port - the logical port number
+*        mode - MV_TRUE to enable Over Limit Interrupt,
+*               MV_FALSE to disable
+*
+* OUTPUTS:
+*        None.
+*
+* RETURNS:
+*        MV_OK   - on success
+*        MV_FAIL - on error
+*
+* COMMENTS:
+*        Port ATU Control register, OverLimitIntEn bit 13, written under the
+*        ATU semaphore like LearnLimit.
+*
+*******************************************************************************/
+MV_STATUS geventSetOverLimitInt
+(
+    IN  GT_QD_DEV    *dev,
+    IN  GT_LPORT    port,
+    IN  MV_BOOL        mode
+)
+{
+    MV_STATUS       retVal;
+
+    DBG_INFO(("geventSetOverLimitInt Called.\n"));
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+    retVal = mv_switch_mii_write_RegField(port, QD_REG_PORT_ATU_CONTROL, 13, 1, (mode == MV_TRUE) ? 1 : 0);
+    gtSemGive(dev, dev->atuRegsSem);
+
+    return retVal;
+}
+
+/*******************************************************************************
+* geventGetOverLimitInt
+*
+* DESCRIPTION:
+*        This routine gets the Over Limit Interrupt setup of a port.
+*
+* INPUTS:
+*        port - the logical port number
+*
+* OUTPUTS:
+*        mode - MV_TRUE if Over Limit Interrupt is enabled,
+*               MV_FALSE otherwise
+*
+* RETURNS:
+*        MV_OK   - on success
+*        MV_FAIL - on error
+*
+* COMMENTS:
+*
+*******************************************************************************/
+MV_STATUS geventGetOverLimitInt
+(
+    IN  GT_QD_DEV    *dev,
+    IN  GT_LPORT    port,
+    OUT MV_BOOL        *mode
+)
+{
+    MV_STATUS       retVal;
+    unsigned int    data;
+
+    DBG_INFO(("geventGetOverLimitInt Called.\n"));
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    retVal = mv_switch_mii_read(port, QD_REG_PORT_ATU_CONTROL, &data);
+    BIT_2_BOOL((data >> 13) & 1, *mode);
+
+    return retVal;
+}
+
+/*******************************************************************************
+* geventGetPortAtuLimitReached
+*
+* DESCRIPTION:
+*       This routine checks if learn limit has been reached.
+*        When it reached, the port can no longer auto learn any more MAC addresses
+*        because the address learn limit set on this port has been reached.
+*
+* INPUTS:
+*       port  - logical port number
+*
+* OUTPUTS:
+*       limit - MV_TRUE, if limit has been reached
+*                MV_FALSE, otherwise
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*       Port ATU Control register, LimitReached bit 14. The bit is set by
+*       the hardware, so the register is kept out of the register shadow
+*       and every call reads it over SMI.
+*
+*******************************************************************************/
+MV_STATUS geventGetPortAtuLimitReached
+(
+    IN  GT_QD_DEV     *dev,
+    IN  GT_LPORT      port,
+    IN  MV_BOOL       *limit
+)
+{
+    MV_STATUS       retVal;
+    unsigned int    data;
+
+    DBG_INFO(("geventGetPortAtuLimitReached Called.\n"));
+
+    port = CALC_SMI_DEV_ADDR(dev, port, PORT_ACCESS);
+
+    retVal = mv_switch_mii_read(port, QD_REG_PORT_ATU_CONTROL, &data);
+    BIT_2_BOOL((data >> 14) & 1, *limit);
+
+    return retVal;
+}
+
+/*******************************************************************************
+* gfdbGetAtuEntryNext
+*
+* DESCRIPTION:
+*       Gets next lexicographic MAC address from the specified Mac Addr.
+*
+* INPUTS:
+*       atuEntry - the Mac Address to start the search.
+*
+* OUTPUTS:
+*       atuEntry - match Address translate unit entry.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error or entry does not exist.
+*       MV_NO_SUCH - no more entries.
+*
+* COMMENTS:
+*       Search starts from atu.macAddr[xx:xx:xx:xx:xx:xx] specified by the
+*       user; the broadcast address starts a new walk.
+*
+*        DBNum in atuEntry -
+*            ATU MAC Address Database number. If multiple address
+*            databases are not being used, DBNum should be zero.
+*            If multiple address databases are being used, this value
+*            should be set to the desired address database number.
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAtuEntryNext
+(
+    IN GT_QD_DEV *dev,
+    INOUT GT_ATU_ENTRY  *atuEntry
+)
+{
+    MV_STATUS       retVal;
+    GT_ATU_ENTRY    entry;
+    MV_U8           i;
+
+    DBG_INFO(("gfdbGetAtuEntryNext Called.\n"));
+
+    for(i = 0; i < 6; i++)
+        entry.macAddr[i] = atuEntry->macAddr[i];
+    entry.DBNum = atuEntry->DBNum;
+
+    retVal = atuOperationPerform(dev, GET_NEXT_ENTRY, NULL, &entry);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    /* the walk ends on the broadcast address with an invalid entry */
+    for(i = 0; i < 6; i++)
+        if(entry.macAddr[i] != 0xFF)
+            break;
+    if((i == 6) && (entry.entryState.ucEntryState == 0))
+    {
+        DBG_INFO(("Failed (no more entries).\n"));
+        return MV_NO_SUCH;
+    }
+
+    entry.DBNum = atuEntry->DBNum;
+    *atuEntry = entry;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gfdbGetAtuEntryFirst
+*
+* DESCRIPTION:
+*       Gets first lexicographic MAC address entry from the ATU.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       atuEntry - match Address translate unit entry.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*       MV_NO_SUCH - table is empty.
+*
+* COMMENTS:
+*       Search starts from the broadcast address, which the ATU treats as
+*       the start of the table (GetNext then returns the lowest MAC).
+*
+*        DBNum in atuEntry -
+*            ATU MAC Address Database number. If multiple address
+*            databases are not being used, DBNum should be zero.
+*            If multiple address databases are being used, this value
+*            should be set to the desired address database number.
+*
+*******************************************************************************/
+MV_STATUS gfdbGetAtuEntryFirst
+(
+    IN GT_QD_DEV *dev,
+    OUT GT_ATU_ENTRY    *atuEntry
+)
+{
+    MV_U8           i;
+
+    DBG_INFO(("gfdbGetAtuEntryFirst Called.\n"));
+
+    for(i = 0; i < 6; i++)
+        atuEntry->macAddr[i] = 0xFF;
+
+    return gfdbGetAtuEntryNext(dev, atuEntry);
+}
+
+/*******************************************************************************
+* gfdbFindAtuMacEntry
+*
+* DESCRIPTION:
+*       Find FDB entry for specific MAC address from the ATU.
+*
+* INPUTS:
+*       atuEntry - the Mac address to search.
+*
+* OUTPUTS:
+*       found    - MV_TRUE, if the appropriate entry exists.
+*       atuEntry - the entry parameters.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error or entry does not exist.
+*
+* COMMENTS:
+*       The ATU mirror is looked up first. On a miss the ATU is searched with
+*       GetNext from the preceding MAC address, and the entry found is added
+*       to the mirror.
+*
+*        DBNum in atuEntry -
+*            ATU MAC Address Database number. If multiple address
+*            databases are not being used, DBNum should be zero.
+*            If multiple address databases are being used, this value
+*            should be set to the desired address database number.
+*
+*******************************************************************************/
+MV_STATUS gfdbFindAtuMacEntry
+(
+    IN GT_QD_DEV *dev,
+    INOUT GT_ATU_ENTRY  *atuEntry,
+    OUT MV_BOOL         *found
+)
+{
+    MV_STATUS       retVal;
+    GT_ATU_ENTRY    entry;
+    int             i;
+
+    DBG_INFO(("gfdbFindAtuMacEntry Called.\n"));
+
+    *found = MV_FALSE;
+
+    if(mv_switch_atu_mirror_find(atuEntry) == MV_TRUE)
+    {
+        *found = MV_TRUE;
+        return MV_OK;
+    }
+    mv_switch_atu_mirror_probe_count();
+
+    /* GetNext from MAC - 1; 00:00:00:00:00:00 - 1 is the broadcast (start) */
+    entry = *atuEntry;
+    for(i = 5; i >= 0; i--)
+        if(entry.macAddr[i]-- != 0)
+            break;
+
+    retVal = atuOperationPerform(dev, GET_NEXT_ENTRY, NULL, &entry);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    if(entry.entryState.ucEntryState == 0)
+        return MV_OK;
+    for(i = 0; i < 6; i++)
+        if(entry.macAddr[i] != atuEntry->macAddr[i])
+            return MV_OK;
+
+    /* atuOperationPerform already added the entry to the mirror */
+    entry.DBNum = atuEntry->DBNum;
+    *atuEntry = entry;
+    *found = MV_TRUE;
+
+    return MV_OK;
+}
+
+/* Register list of one gfdbLoadAtuEntries chunk, used under atuRegsSem */
+static HW_DEV_RW_REG atuLoadList[MV_SWITCH_ATU_LOAD_CHUNK * MV_SWITCH_ATU_LOAD_OPS + 1];
+
+/* ATU registers as left by the previous entry of a bulk load */
+typedef struct
+{
+    MV_BOOL     valid;
+    MV_U16      data;
+    MV_U16      mac[3];
+    MV_U16      fid;
+} ATU_LOAD_REGS;
+
+static void atuLoadAdd(MV_U32 *n, MV_U32 cmd, MV_U32 reg, MV_U32 data)
+{
+    atuLoadList[*n].cmd = cmd;
+    atuLoadList[*n].addr = 0x1b;
+    atuLoadList[*n].reg = reg;
+    atuLoadList[*n].data = data;
+    (*n)++;
+}
+
+/* Stage one load/purge, skipping the registers already holding its values */
+static void atuLoadStage(GT_QD_DEV *dev, ATU_LOAD_REGS *regs, GT_ATU_ENTRY *entry, MV_U32 *n)
+{
+    MV_U16  portMask = (1 << dev->maxPorts) - 1;
+    MV_U16  data;
+    MV_U8   i;
+
+    /* the previous operation has to be over before its registers change */
+    atuLoadAdd(n, HW_REG_WAIT_TILL_0, QD_REG_ATU_OPERATION, 15);
+
+    data = (MV_U16)( (((entry->prio) & 0x3) << 14) |
+           (((entry->portVec) & portMask) << 4) |
+           (((entry->entryState.ucEntryState) & 0xF)) );
+    if(!regs->valid || regs->data != data)
+        atuLoadAdd(n, HW_REG_WRITE, QD_REG_ATU_DATA_REG, data);
+    regs->data = data;
+
+    for(i = 0; i < 3; i++)
+    {
+        data = (entry->macAddr[2*i] << 8) | (entry->macAddr[1 + 2*i]);
+        if(!regs->valid || regs->mac[i] != data)
+            atuLoadAdd(n, HW_REG_WRITE, QD_REG_ATU_MAC_BASE + i, data);
+        regs->mac[i] = data;
+    }
+
+    /* bits 15:12 of the FID register are reserved, no read-modify-write */
+    data = entry->DBNum & 0xFFF;
+    if(!regs->valid || regs->fid != data)
+        atuLoadAdd(n, HW_REG_WRITE, QD_REG_ATU_FID_REG, data);
+    regs->fid = data;
+    regs->valid = MV_TRUE;
+
+    atuLoadAdd(n, HW_REG_WRITE, QD_REG_ATU_OPERATION, (1 << 15) | (LOAD_PURGE_ENTRY << 12));
+}
+
+/*******************************************************************************
+* gfdbLoadAtuEntries
+*
+* DESCRIPTION:
+*       Loads or purges a list of ATU entries back-to-back.
+*
+* INPUTS:
+*       atuEntry - entries to load; an entry state of 0 purges the entry.
+*       count    - number of entries.
+*
+* OUTPUTS:
+*       status   - per entry MV_OK, or the error of its register access.
+*                  May be NULL.
+*
+* RETURNS:
+*       MV_OK          - all entries were loaded.
+*       MV_NOT_READY   - the ATU stayed busy; the entries from the one that
+*                        did not complete on are not loaded.
+*       other          - the error of the first failing entry.
+*
+* COMMENTS:
+*       Up to MV_SWITCH_ATU_LOAD_CHUNK entries go to the switch in one
+*       register list (one RMU frame when RMU is running). The ATU data,
+*       MAC and FID registers are only written when they differ from the
+*       previous entry, so a run of multicast groups in one database costs
+*       the busy poll, the low MAC words and the operation write per entry.
+*       The ATU semaphore is held for the whole load.
+*
+*******************************************************************************/
+MV_STATUS gfdbLoadAtuEntries
+(
+    IN  GT_QD_DEV       *dev,
+    IN  GT_ATU_ENTRY    *atuEntry,
+    IN  MV_U32          count,
+    OUT MV_STATUS       *status
+)
+{
+    MV_U32          start[MV_SWITCH_ATU_LOAD_CHUNK + 1];
+    ATU_LOAD_REGS   regs;
+    MV_STATUS       retVal, first = MV_OK;
+    MV_U32          i, j, n, chunk, failed;
+
+    DBG_INFO(("gfdbLoadAtuEntries Called.\n"));
+
+    regs.valid = MV_FALSE;
+
+    gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+
+    for(i = 0; i < count; i += chunk)
+    {
+        chunk = min_t(MV_U32, count - i, MV_SWITCH_ATU_LOAD_CHUNK);
+
+        /* the list polls the busy bit itself, only refuse a wedged ATU */
+        retVal = mv_switch_atu_cmd_ready(dev, chunk);
+        if(retVal != MV_OK)
+        {
+            for(j = i; j < count; j++)
+                if(status)
+                    status[j] = retVal;
+            if(first == MV_OK)
+                first = retVal;
+            break;
+        }
+
+        n = 0;
+        for(j = 0; j < chunk; j++)
+        {
+            start[j] = n;
+            atuLoadStage(dev, &regs, &atuEntry[i + j], &n);
+        }
+        /* the last operation is over when the list returns */
+        start[chunk] = n;
+        atuLoadAdd(&n, HW_REG_WAIT_TILL_0, QD_REG_ATU_OPERATION, 15);
+
+        retVal = mv_switch_dev_rw_reg_list(dev, atuLoadList, n, &failed);
+        if(retVal == MV_OK)
+            failed = n;
+
+        /* entry j is over once the poll that starts entry j + 1 passed */
+        for(j = 0; j < chunk && start[j + 1] < failed; j++)
+        {
+            if(status)
+                status[i + j] = MV_OK;
+            mv_switch_atu_mirror_op(LOAD_PURGE_ENTRY, NULL, &atuEntry[i + j]);
+        }
+        if(retVal == MV_OK)
+            continue;
+
+        DBG_INFO(("Failed (entry %d).\n", i + j));
+        mv_switch_atu_cmd_failed(retVal);
+        if(first == MV_OK)
+            first = retVal;
+        /* the failed poll or write belongs to entry j */
+        if(status)
+            status[i + j] = retVal;
+        chunk = j + 1;
+        regs.valid = MV_FALSE;
+
+        if(retVal == MV_NOT_READY || retVal == MV_TIMEOUT)
+        {
+            /* the ATU is stuck, the other entries would time out too; */
+            /* after an unanswered RMU request nothing is known at all  */
+            for(j = i + chunk; j < count; j++)
+                if(status)
+                    status[j] = retVal;
+            break;
+        }
+    }
+
+    gtSemGive(dev, dev->atuRegsSem);
+
+    return first;
+}
+
+/*******************************************************************************
+* gfdbAddMacEntry
+*
+* DESCRIPTION:
+*       Creates the new entry in MAC address table.
+*
+* INPUTS:
+*       macEntry    - mac address entry to insert to the ATU.
+*
+* OUTPUTS:
+*       None
+*
+* RETURNS:
+*       MV_OK             - on success
+*       MV_FAIL           - on error
+*
+* COMMENTS:
+*        DBNum in atuEntry -
+*            ATU MAC Address Database number. If multiple address
+*            databases are not being used, DBNum should be zero.
+*            If multiple address databases are being used, this value
+*            should be set to the desired address database number.
+*
+*******************************************************************************/
+MV_STATUS gfdbAddMacEntry
+(
+    IN GT_QD_DEV *dev,
+    IN GT_ATU_ENTRY *macEntry
+)
+{
+    DBG_INFO(("gfdbAddMacEntry Called.\n"));
+
+    if(macEntry->entryState.ucEntryState == 0)
+        return MV_BAD_PARAM;
+
+    return gfdbLoadAtuEntries(dev, macEntry, 1, NULL);
+}
+
+/*******************************************************************************
+* gfdbDelAtuEntry
+*
+* DESCRIPTION:
+*       Deletes ATU entry.
+*
+* INPUTS:
+*       atuEntry - the ATU entry to be deleted.
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*
+* COMMENTS:
+*        DBNum in atuEntry -
+*            ATU MAC Address Database number. If multiple address
+*            databases are not being used, DBNum should be zero.
+*            If multiple address databases are being used, this value
+*            should be set to the desired address database number.
+*
+*******************************************************************************/
+MV_STATUS gfdbDelAtuEntry
+(
+    IN GT_QD_DEV *dev,
+    IN GT_ATU_ENTRY  *atuEntry
+)
+{
+    GT_ATU_ENTRY    entry;
+
+    DBG_INFO(("gfdbDelAtuEntry Called.\n"));
+
+    entry = *atuEntry;
+    entry.entryState.ucEntryState = 0;
+
+    return gfdbLoadAtuEntries(dev, &entry, 1, NULL);
+}
+
+/*******************************************************************************
+* gatuGetViolation
+*
+* DESCRIPTION:
+*       Services the oldest pending ATU violation.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       intCause - GT_AGE_VIOLATION, GT_MEMBER_VIOLATION, GT_MISS_VIOLATION,
+*                  GT_FULL_VIOLATION, or 0 if no violation is pending.
+*       entry    - DBNum and macAddr of the violating address, and the
+*                  source port in entryState.ucEntryState. Not valid for a
+*                  full violation.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*
+* COMMENTS:
+*       Unlike gatuGetIntStatus, the full 12 bits DBNum are returned.
+*
+*******************************************************************************/
+MV_STATUS gatuGetViolation
+(
+    IN  GT_QD_DEV       *dev,
+    OUT MV_U32          *intCause,
+    OUT GT_ATU_ENTRY    *entry
+)
+{
+    MV_STATUS           retVal;
+    GT_EXTRA_OP_DATA    opData;
+
+    DBG_INFO(("gatuGetViolation Called.\n"));
+
+    memset(entry, 0, sizeof(GT_ATU_ENTRY));
+    opData.intCause = 0;
+
+    retVal = atuOperationPerform(dev, SERVICE_VIOLATIONS, &opData, entry);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    *intCause = opData.intCause;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gatuGetIntStatus
+*
+* DESCRIPTION:
+*        Check to see if a specific type of ATU interrupt occured
+*
+* INPUTS:
+*     intType - the type of interrupt which causes an interrupt.
+*                    GT_MEMEBER_VIOLATION, GT_MISS_VIOLATION, or GT_FULL_VIOLATION
+*
+* OUTPUTS:
+*         None.
+*
+* RETURNS:
+*         MV_OK     - on success
+*         MV_FAIL     - on error
+*
+* COMMENTS:
+*
+*******************************************************************************/
+MV_STATUS gatuGetIntStatus
+(
+    IN  GT_QD_DEV                *dev,
+    OUT GT_ATU_INT_STATUS    *atuIntStatus
+)
+{
+    MV_STATUS       retVal;
+    MV_U32          intCause;
+    GT_ATU_ENTRY    entry;
+
+    DBG_INFO(("gatuGetIntStatus Called.\n"));
+
+    retVal = gatuGetViolation(dev, &intCause, &entry);
+    if(retVal != MV_OK)
+        return retVal;
+
+    atuIntStatus->atuIntCause = (MV_U16)intCause;
+    atuIntStatus->spid = entry.entryState.ucEntryState;
+    atuIntStatus->dbNum = (MV_U8)entry.DBNum;
+    memcpy(atuIntStatus->macAddr, entry.macAddr, 6);
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* VTU
+*
+* 88E6172 VTU registers (Global1): FID (VIDPolicy in bit 12), SID, the VTU
+* operation, VID (valid in bit 12) and three data registers holding a 2-bit
+* MemberTag per port in the low bits of each nibble, and the VID priority
+* override in bits 15:12 of the third one.
+*******************************************************************************/
+
+/* MemberTag of the data registers from/to the MEMBER_* values */
+static const MV_U8 vtuTagToHw[4] =
+{
+    0,      /* MEMBER_EGRESS_UNMODIFIED */
+    3,      /* NOT_A_MEMBER */
+    1,      /* MEMBER_EGRESS_UNTAGGED */
+    2       /* MEMBER_EGRESS_TAGGED */
+};
+
+static const MV_U8 vtuTagFromHw[4] =
+{
+    MEMBER_EGRESS_UNMODIFIED,
+    MEMBER_EGRESS_UNTAGGED,
+    MEMBER_EGRESS_TAGGED,
+    NOT_A_MEMBER
+};
+
+/* VTU registers of one entry */
+typedef struct
+{
+    MV_U16      vid;
+    MV_U16      fid;
+    MV_U16      sid;
+    MV_U16      data[3];
+} VTU_REGS;
+
+static void vtuEntryToRegs
+(
+    IN  GT_QD_DEV       *dev,
+    IN  GT_VTU_ENTRY    *entry,
+    IN  MV_BOOL         valid,
+    OUT VTU_REGS        *regs
+)
+{
+    MV_U8   tag;
+    MV_U32  p;
+
+    regs->vid = (MV_U16)((valid ? (1 << 12) : 0) | (entry->vid & 0xFFF));
+    regs->fid = (MV_U16)((entry->vidPolicy ? (1 << 12) : 0) | (entry->DBNum & 0xFFF));
+    regs->sid = entry->sid & 0x3F;
+    regs->data[0] = regs->data[1] = regs->data[2] = 0;
+
+    /* ports the device does not have are left out of every VLAN */
+    for(p = 0; p < 11; p++)
+    {
+        tag = (p < dev->maxPorts) ? vtuTagToHw[entry->vtuData.memberTagP[p] & 0x3] : 3;
+        regs->data[p / 4] |= tag << ((p % 4) * 4);
+    }
+    if(entry->vidPriOverride)
+        regs->data[2] |= 0x8000 | ((entry->vidPriority & 0x7) << 12);
+}
+
+static void vtuRegsToEntry
+(
+    IN  GT_QD_DEV       *dev,
+    IN  VTU_REGS        *regs,
+    OUT GT_VTU_ENTRY    *entry
+)
+{
+    MV_U32  p;
+
+    memset(entry, 0, sizeof(GT_VTU_ENTRY));
+    entry->vid = regs->vid & 0xFFF;
+    entry->DBNum = regs->fid & 0xFFF;
+    entry->vidPolicy = (regs->fid & (1 << 12)) ? MV_TRUE : MV_FALSE;
+    entry->sid = regs->sid & 0x3F;
+    for(p = 0; p < dev->maxPorts; p++)
+        entry->vtuData.memberTagP[p] = vtuTagFromHw[(regs->data[p / 4] >> ((p % 4) * 4)) & 0x3];
+    entry->vidPriOverride = (regs->data[2] & 0x8000) ? MV_TRUE : MV_FALSE;
+    entry->vidPriority = (regs->data[2] >> 12) & 0x7;
+}
+
+static void vtuListAdd(HW_DEV_RW_REG *list, MV_U32 *n, MV_U32 cmd, MV_U32 reg, MV_U32 data)
+{
+    list[*n].cmd = cmd;
+    list[*n].addr = 0x1b;
+    list[*n].reg = reg;
+    list[*n].data = data;
+    (*n)++;
+}
+
+/*******************************************************************************
+* vtuOperationPerform
+*
+* DESCRIPTION:
+*       Runs a VTU flush or GetNext as one register list: busy poll,
+*       operation and, for GetNext, the busy poll and reads of the result.
+*       The busy polls are bounded by the register poll deadline.
+*
+* INPUTS:
+*       vtuOp - FLUSH_ALL or GET_NEXT_ENTRY.
+*       regs  - GET_NEXT_ENTRY: VID to start after (0xFFF: first entry).
+*
+* OUTPUTS:
+*       regs  - GET_NEXT_ENTRY: the next entry; the valid bit of the VID
+*               register is clear when there is none.
+*
+* RETURNS:
+*       MV_OK on success,
+*       MV_NOT_READY if the VTU stayed busy,
+*       MV_FAIL otherwise.
+*
+*******************************************************************************/
+static MV_STATUS vtuOperationPerform
+(
+    IN      GT_QD_DEV           *dev,
+    IN      GT_VTU_OPERATION    vtuOp,
+    INOUT   VTU_REGS            *regs
+)
+{
+    HW_DEV_RW_REG   list[10];
+    MV_STATUS       retVal;
+    MV_U32          n = 0, i;
+
+    vtuListAdd(list, &n, HW_REG_WAIT_TILL_0, QD_REG_VTU_OPERATION, 15);
+    if(vtuOp == GET_NEXT_ENTRY)
+        vtuListAdd(list, &n, HW_REG_WRITE, QD_REG_VTU_VID_REG, regs->vid & 0xFFF);
+    vtuListAdd(list, &n, HW_REG_WRITE, QD_REG_VTU_OPERATION, (1 << 15) | (vtuOp << 12));
+    vtuListAdd(list, &n, HW_REG_WAIT_TILL_0, QD_REG_VTU_OPERATION, 15);
+    if(vtuOp == GET_NEXT_ENTRY)
+    {
+        vtuListAdd(list, &n, HW_REG_READ, QD_REG_VTU_VID_REG, 0);
+        vtuListAdd(list, &n, HW_REG_READ, QD_REG_VTU_FID_REG, 0);
+        vtuListAdd(list, &n, HW_REG_READ, QD_REG_STU_SID_REG, 0);
+        for(i = 0; i < 3; i++)
+            vtuListAdd(list, &n, HW_REG_READ, QD_REG_VTU_DATA1_REG + i, 0);
+    }
+
+    gtSemTake(dev, dev->vtuRegsSem, OS_WAIT_FOREVER);
+    retVal = mv_switch_dev_rw_reg_list(dev, list, n, NULL);
+    gtSemGive(dev, dev->vtuRegsSem);
+    if(retVal != MV_OK)
+        return retVal;
+
+    if(vtuOp == GET_NEXT_ENTRY)
+    {
+        regs->vid = (MV_U16)list[4].data;
+        regs->fid = (MV_U16)list[5].data;
+        regs->sid = (MV_U16)list[6].data;
+        for(i = 0; i < 3; i++)
+            regs->data[i] = (MV_U16)list[7 + i].data;
+    }
+
+    return MV_OK;
+}
+
+/* Register list of one gvtuLoadEntries chunk, used under vtuRegsSem */
+static HW_DEV_RW_REG vtuLoadList[MV_SWITCH_VTU_LOAD_CHUNK * MV_SWITCH_VTU_LOAD_OPS + 1];
+
+/* Stage one load/purge, skipping the registers already holding its values */
+static void vtuLoadStage(VTU_REGS *cur, MV_BOOL *curValid, VTU_REGS *regs, MV_U32 *n)
+{
+    MV_U32  i;
+
+    /* the previous operation has to be over before its registers change */
+    vtuListAdd(vtuLoadList, n, HW_REG_WAIT_TILL_0, QD_REG_VTU_OPERATION, 15);
+
+    /* a purge only needs the VID */
+    if(regs->vid & (1 << 12))
+    {
+        for(i = 0; i < 3; i++)
+        {
+            if(!*curValid || cur->data[i] != regs->data[i])
+                vtuListAdd(vtuLoadList, n, HW_REG_WRITE, QD_REG_VTU_DATA1_REG + i, regs->data[i]);
+            cur->data[i] = regs->data[i];
+        }
+        if(!*curValid || cur->fid != regs->fid)
+            vtuListAdd(vtuLoadList, n, HW_REG_WRITE, QD_REG_VTU_FID_REG, regs->fid);
+        cur->fid = regs->fid;
+        if(!*curValid || cur->sid != regs->sid)
+            vtuListAdd(vtuLoadList, n, HW_REG_WRITE, QD_REG_STU_SID_REG, regs->sid);
+        cur->sid = regs->sid;
+        *curValid = MV_TRUE;
+    }
+
+    vtuListAdd(vtuLoadList, n, HW_REG_WRITE, QD_REG_VTU_VID_REG, regs->vid);
+    vtuListAdd(vtuLoadList, n, HW_REG_WRITE, QD_REG_VTU_OPERATION, (1 << 15) | (LOAD_PURGE_ENTRY << 12));
+}
+
+/*******************************************************************************
+* gvtuLoadEntries
+*
+* DESCRIPTION:
+*       Loads or purges a list of VTU entries back-to-back.
+*
+* INPUTS:
+*       vtuEntry - entries to load, or whose VIDs to purge.
+*       count    - number of entries.
+*       purge    - MV_TRUE to purge the entries, MV_FALSE to load them.
+*
+* OUTPUTS:
+*       status   - per entry MV_OK, or the error of its register access.
+*                  May be NULL.
+*
+* RETURNS:
+*       MV_OK          - all entries were loaded/purged.
+*       MV_BAD_PARAM   - a VID is out of range (nothing was written).
+*       MV_NOT_READY   - the VTU stayed busy; the entries from the one that
+*                        did not complete on are not loaded.
+*       other          - the error of the first failing entry.
+*
+* COMMENTS:
+*       Up to MV_SWITCH_VTU_LOAD_CHUNK entries go to the switch in one
+*       register list. The data, FID and SID registers are only written
+*       when they differ from the previous entry, so VLANs of the same
+*       members cost the busy poll, the VID and the operation write each.
+*       Every entry done is applied to the VTU mirror.
+*
+*******************************************************************************/
+MV_STATUS gvtuLoadEntries
+(
+    IN  GT_QD_DEV       *dev,
+    IN  GT_VTU_ENTRY    *vtuEntry,
+    IN  MV_U32          count,
+    IN  MV_BOOL         purge,
+    OUT MV_STATUS       *status
+)
+{
+    MV_U32          start[MV_SWITCH_VTU_LOAD_CHUNK + 1];
+    VTU_REGS        cur, regs;
+    MV_BOOL         curValid = MV_FALSE;
+    MV_STATUS       retVal, first = MV_OK;
+    MV_U32          i, j, n, chunk, failed;
+
+    DBG_INFO(("gvtuLoadEntries Called.\n"));
+
+    /* VID 0xFFF is reserved */
+    for(i = 0; i < count; i++)
+    {
+        if(vtuEntry[i].vid >= 0xFFF)
+        {
+            DBG_INFO(("Failed (bad VID %d).\n", vtuEntry[i].vid));
+            return MV_BAD_PARAM;
+        }
+    }
+
+    gtSemTake(dev, dev->vtuRegsSem, OS_WAIT_FOREVER);
+
+    for(i = 0; i < count; i += chunk)
+    {
+        chunk = min_t(MV_U32, count - i, MV_SWITCH_VTU_LOAD_CHUNK);
+
+        n = 0;
+        for(j = 0; j < chunk; j++)
+        {
+            start[j] = n;
+            vtuEntryToRegs(dev, &vtuEntry[i + j], purge ? MV_FALSE : MV_TRUE, &regs);
+            vtuLoadStage(&cur, &curValid, &regs, &n);
+        }
+        /* the last operation is over when the list returns */
+        start[chunk] = n;
+        vtuListAdd(vtuLoadList, &n, HW_REG_WAIT_TILL_0, QD_REG_VTU_OPERATION, 15);
+
+        retVal = mv_switch_dev_rw_reg_list(dev, vtuLoadList, n, &failed);
+        if(retVal == MV_OK)
+            failed = n;
+
+        /* entry j is over once the poll that starts entry j + 1 passed */
+        for(j = 0; j < chunk && start[j + 1] < failed; j++)
+        {
+            if(status)
+                status[i + j] = MV_OK;
+            mv_switch_vtu_mirror_op(&vtuEntry[i + j], purge);
+        }
+        if(retVal == MV_OK)
+            continue;
+
+        DBG_INFO(("Failed (entry %d).\n", i + j));
+        if(first == MV_OK)
+            first = retVal;
+        if(status)
+            status[i + j] = retVal;
+        chunk = j + 1;
+        curValid = MV_FALSE;
+
+        if(retVal == MV_NOT_READY || retVal == MV_TIMEOUT)
+        {
+            /* the VTU is stuck, the other entries would time out too; */
+            /* after an unanswered RMU request nothing is known at all  */
+            for(j = i + chunk; j < count; j++)
+                if(status)
+                    status[j] = retVal;
+            break;
+        }
+    }
+
+    gtSemGive(dev, dev->vtuRegsSem);
+
+    return first;
+}
+
+/*******************************************************************************
+* gvtuAddEntry
+*
+* DESCRIPTION:
+*       Creates the new entry in VTU table based on user input.
+*
+* INPUTS:
+*       vtuEntry    - vtu entry to insert to the VTU.
+*
+* OUTPUTS:
+*       None
+*
+* RETURNS:
+*       MV_OK             - on success
+*       MV_FAIL           - on error
+*       MV_BAD_PARAM      - VID out of range
+*
+* COMMENTS:
+*       An existing entry of the VID is replaced.
+*
+*******************************************************************************/
+MV_STATUS gvtuAddEntry
+(
+    IN GT_QD_DEV     *dev,
+    IN GT_VTU_ENTRY *vtuEntry
+)
+{
+    DBG_INFO(("gvtuAddEntry Called.\n"));
+
+    return gvtuLoadEntries(dev, vtuEntry, 1, MV_FALSE, NULL);
+}
+
+/*******************************************************************************
+* gvtuDelEntry
+*
+* DESCRIPTION:
+*       Deletes VTU entry specified by user.
+*
+* INPUTS:
+*       vtuEntry - the VTU entry to be deleted
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*       MV_BAD_PARAM    - VID out of range
+*
+* COMMENTS:
+*       Only the VID of vtuEntry is used.
+*
+*******************************************************************************/
+MV_STATUS gvtuDelEntry
+(
+    IN GT_QD_DEV     *dev,
+    IN GT_VTU_ENTRY *vtuEntry
+)
+{
+    DBG_INFO(("gvtuDelEntry Called.\n"));
+
+    return gvtuLoadEntries(dev, vtuEntry, 1, MV_TRUE, NULL);
+}
+
+/*******************************************************************************
+* gvtuFlush
+*
+* DESCRIPTION:
+*       This routine removes all entries from VTU Table.
+*
+* INPUTS:
+*       None
+*
+* OUTPUTS:
+*       None
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*
+* COMMENTS:
+*       The STU entries are flushed as well.
+*
+*******************************************************************************/
+MV_STATUS gvtuFlush
+(
+    IN GT_QD_DEV *dev
+)
+{
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gvtuFlush Called.\n"));
+
+    retVal = vtuOperationPerform(dev, FLUSH_ALL, NULL);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    mv_switch_vtu_mirror_flush();
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gvtuGetEntryNext
+*
+* DESCRIPTION:
+*       Gets next valid VTU entry from the specified VID.
+*
+* INPUTS:
+*       vtuEntry - the VID to start the search.
+*
+* OUTPUTS:
+*       vtuEntry - match VTU  entry.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error or entry does not exist.
+*       MV_NO_SUCH - no more entries.
+*
+* COMMENTS:
+*       Search starts from the VID of vtuEntry; VID 0xFFF starts from the
+*       first entry.
+*
+*******************************************************************************/
+MV_STATUS gvtuGetEntryNext
+(
+    IN  GT_QD_DEV         *dev,
+    INOUT GT_VTU_ENTRY  *vtuEntry
+)
+{
+    VTU_REGS        regs;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gvtuGetEntryNext Called.\n"));
+
+    regs.vid = vtuEntry->vid & 0xFFF;
+    retVal = vtuOperationPerform(dev, GET_NEXT_ENTRY, &regs);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    /* the walk ends on VID 0xFFF without the valid bit */
+    if(!(regs.vid & (1 << 12)) || ((regs.vid & 0xFFF) == 0xFFF))
+    {
+        DBG_INFO(("Failed (no more entries).\n"));
+        return MV_NO_SUCH;
+    }
+
+    vtuRegsToEntry(dev, &regs, vtuEntry);
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gvtuGetEntryFirst
+*
+* DESCRIPTION:
+*       Gets first lexicographic VTU entry.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       vtuEntry - match VTU entry.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error.
+*       MV_NO_SUCH - table is empty.
+*
+* COMMENTS:
+*
+*******************************************************************************/
+MV_STATUS gvtuGetEntryFirst
+(
+    IN  GT_QD_DEV         *dev,
+    OUT GT_VTU_ENTRY    *vtuEntry
+)
+{
+    DBG_INFO(("gvtuGetEntryFirst Called.\n"));
+
+    vtuEntry->vid = 0xFFF;
+
+    return gvtuGetEntryNext(dev, vtuEntry);
+}
+
+/*******************************************************************************
+* gvtuFindVidEntry
+*
+* DESCRIPTION:
+*       Find VTU entry for a specific VID, it will return the entry, if found,
+*       along with its associated data
+*
+* INPUTS:
+*       vtuEntry - contains the VID to search for.
+*
+* OUTPUTS:
+*       found    - MV_TRUE, if the appropriate entry exists.
+*       vtuEntry - the entry parameters.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error.
+*       MV_NO_SUCH - the entry does not exist.
+*
+* COMMENTS:
+*       One GetNext from the VID before the searched one.
+*
+*******************************************************************************/
+MV_STATUS gvtuFindVidEntry
+(
+    IN GT_QD_DEV         *dev,
+    INOUT GT_VTU_ENTRY  *vtuEntry,
+    OUT MV_BOOL         *found
+)
+{
+    GT_VTU_ENTRY    entry;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gvtuFindVidEntry Called.\n"));
+
+    *found = MV_FALSE;
+    entry.vid = (vtuEntry->vid == 0) ? 0xFFF : vtuEntry->vid - 1;
+
+    retVal = gvtuGetEntryNext(dev, &entry);
+    if(retVal != MV_OK)
+        return retVal;
+    if(entry.vid != vtuEntry->vid)
+        return MV_NO_SUCH;
+
+    *vtuEntry = entry;
+    *found = MV_TRUE;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* STU
+*
+* The 802.1s Port State database shares the VTU registers: the SID register
+* selects the entry, the valid bit of the VID register marks it valid and
+* the data registers hold a 2-bit port state (GT_PORT_STP_STATE) per port in
+* bits 3:2 of each nibble.
+*******************************************************************************/
+
+static void stuEntryToRegs
+(
+    IN  GT_QD_DEV       *dev,
+    IN  GT_STU_ENTRY    *entry,
+    IN  MV_BOOL         valid,
+    OUT VTU_REGS        *regs
+)
+{
+    MV_U32  p;
+
+    regs->vid = valid ? (1 << 12) : 0;
+    regs->sid = entry->sid & 0x3F;
+    regs->data[0] = regs->data[1] = regs->data[2] = 0;
+
+    /* ports the device does not have stay disabled */
+    for(p = 0; p < dev->maxPorts && p < MAX_SWITCH_PORTS; p++)
+        regs->data[p / 4] |= (entry->portState[p] & 0x3) << ((p % 4) * 4 + 2);
+}
+
+static void stuRegsToEntry
+(
+    IN  GT_QD_DEV       *dev,
+    IN  VTU_REGS        *regs,
+    OUT GT_STU_ENTRY    *entry
+)
+{
+    MV_U32  p;
+
+    memset(entry, 0, sizeof(GT_STU_ENTRY));
+    entry->sid = regs->sid & 0x3F;
+    for(p = 0; p < dev->maxPorts && p < MAX_SWITCH_PORTS; p++)
+        entry->portState[p] = (regs->data[p / 4] >> ((p % 4) * 4 + 2)) & 0x3;
+}
+
+/*******************************************************************************
+* stuOperationPerform
+*
+* DESCRIPTION:
+*       Runs an STU load/purge or GetNext as one register list under the VTU
+*       semaphore, the busy polls bounded by the register poll deadline.
+*
+* INPUTS:
+*       stuOp - LOAD_PURGE_STU_ENTRY or GET_NEXT_STU_ENTRY.
+*       regs  - LOAD_PURGE_STU_ENTRY: the entry (purged if not valid).
+*               GET_NEXT_STU_ENTRY: SID to start after (0x3F: first entry).
+*
+* OUTPUTS:
+*       regs  - GET_NEXT_STU_ENTRY: the next entry; the valid bit of the VID
+*               register is clear when there is none.
+*
+* RETURNS:
+*       MV_OK on success,
+*       MV_NOT_READY if the VTU stayed busy,
+*       MV_FAIL otherwise.
+*
+*******************************************************************************/
+static MV_STATUS stuOperationPerform
+(
+    IN      GT_QD_DEV           *dev,
+    IN      GT_STU_OPERATION    stuOp,
+    INOUT   VTU_REGS            *regs
+)
+{
+    HW_DEV_RW_REG   list[10];
+    MV_STATUS       retVal;
+    MV_U32          n = 0, i;
+
+    vtuListAdd(list, &n, HW_REG_WAIT_TILL_0, QD_REG_VTU_OPERATION, 15);
+    if(stuOp == LOAD_PURGE_STU_ENTRY)
+    {
+        for(i = 0; i < 3; i++)
+            vtuListAdd(list, &n, HW_REG_WRITE, QD_REG_VTU_DATA1_REG + i, regs->data[i]);
+        vtuListAdd(list, &n, HW_REG_WRITE, QD_REG_VTU_VID_REG, regs->vid);
+    }
+    vtuListAdd(list, &n, HW_REG_WRITE, QD_REG_STU_SID_REG, regs->sid & 0x3F);
+    vtuListAdd(list, &n, HW_REG_WRITE, QD_REG_VTU_OPERATION, (1 << 15) | (stuOp << 12));
+    vtuListAdd(list, &n, HW_REG_WAIT_TILL_0, QD_REG_VTU_OPERATION, 15);
+    if(stuOp == GET_NEXT_STU_ENTRY)
+    {
+        vtuListAdd(list, &n, HW_REG_READ, QD_REG_STU_SID_REG, 0);
+        vtuListAdd(list, &n, HW_REG_READ, QD_REG_VTU_VID_REG, 0);
+        for(i = 0; i < 3; i++)
+            vtuListAdd(list, &n, HW_REG_READ, QD_REG_VTU_DATA1_REG + i, 0);
+    }
+
+    gtSemTake(dev, dev->vtuRegsSem, OS_WAIT_FOREVER);
+    retVal = mv_switch_dev_rw_reg_list(dev, list, n, NULL);
+    gtSemGive(dev, dev->vtuRegsSem);
+    if(retVal != MV_OK)
+        return retVal;
+
+    if(stuOp == GET_NEXT_STU_ENTRY)
+    {
+        regs->sid = (MV_U16)list[4].data;
+        regs->vid = (MV_U16)list[5].data;
+        for(i = 0; i < 3; i++)
+            regs->data[i] = (MV_U16)list[6 + i].data;
+    }
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gstuAddEntry
+*
+* DESCRIPTION:
+*       Creates or update the entry in STU table based on user input.
+*
+* INPUTS:
+*       stuEntry    - stu entry to insert to the STU.
+*
+* OUTPUTS:
+*       None
+*
+* RETURNS:
+*       MV_OK             - on success
+*       MV_FAIL           - on error
+*       MV_BAD_PARAM      - SID out of range
+*
+* COMMENTS:
+*       The port states apply to the VLANs whose VTU entry holds the SID.
+*       Valid SIDs are 0 to 62; 0x3F starts and ends the GetNext walk.
+*
+*******************************************************************************/
+MV_STATUS gstuAddEntry
+(
+    IN  GT_QD_DEV       *dev,
+    IN  GT_STU_ENTRY    *stuEntry
+)
+{
+    VTU_REGS        regs;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gstuAddEntry Called.\n"));
+
+    if(stuEntry->sid >= 0x3F)
+    {
+        DBG_INFO(("Failed (bad SID %d).\n", stuEntry->sid));
+        return MV_BAD_PARAM;
+    }
+
+    stuEntryToRegs(dev, stuEntry, MV_TRUE, &regs);
+    retVal = stuOperationPerform(dev, LOAD_PURGE_STU_ENTRY, &regs);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    mv_switch_stu_mirror_op(stuEntry, MV_FALSE);
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gstuDelEntry
+*
+* DESCRIPTION:
+*       Deletes STU entry specified by user.
+*
+* INPUTS:
+*       stuEntry - the STU entry to be deleted
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*       MV_BAD_PARAM    - SID out of range (0x3F is the GetNext walk marker)
+*
+* COMMENTS:
+*       Only the SID of stuEntry is used.
+*
+*******************************************************************************/
+MV_STATUS gstuDelEntry
+(
+    IN  GT_QD_DEV       *dev,
+    IN  GT_STU_ENTRY    *stuEntry
+)
+{
+    VTU_REGS        regs;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gstuDelEntry Called.\n"));
+
+    if(stuEntry->sid >= 0x3F)
+    {
+        DBG_INFO(("Failed (bad SID %d).\n", stuEntry->sid));
+        return MV_BAD_PARAM;
+    }
+
+    stuEntryToRegs(dev, stuEntry, MV_FALSE, &regs);
+    retVal = stuOperationPerform(dev, LOAD_PURGE_STU_ENTRY, &regs);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    mv_switch_stu_mirror_op(stuEntry, MV_TRUE);
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gstuGetEntryNext
+*
+* DESCRIPTION:
+*       Gets next lexicographic STU entry from the specified SID.
+*
+* INPUTS:
+*       stuEntry - the SID to start the search.
+*
+* OUTPUTS:
+*       stuEntry - next STU entry.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error or entry does not exist.
+*       MV_NO_SUCH - no more entries.
+*
+* COMMENTS:
+*       SID 0x3F starts from the first entry.
+*
+*******************************************************************************/
+MV_STATUS gstuGetEntryNext
+(
+    IN  GT_QD_DEV       *dev,
+    INOUT GT_STU_ENTRY  *stuEntry
+)
+{
+    VTU_REGS        regs;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gstuGetEntryNext Called.\n"));
+
+    regs.sid = stuEntry->sid & 0x3F;
+    retVal = stuOperationPerform(dev, GET_NEXT_STU_ENTRY, &regs);
+    if(retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    /* the walk ends on SID 0x3F without the valid bit */
+    if(!(regs.vid & (1 << 12)) || ((regs.sid & 0x3F) == 0x3F))
+    {
+        DBG_INFO(("Failed (no more entries).\n"));
+        return MV_NO_SUCH;
+    }
+
+    stuRegsToEntry(dev, &regs, stuEntry);
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gstuGetEntryFirst
+*
+* DESCRIPTION:
+*       Gets first lexicographic entry from the STU.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       stuEntry - find the first valid STU entry.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*       MV_NO_SUCH - table is empty.
+*
+* COMMENTS:
+*       None.
+*
+*******************************************************************************/
+MV_STATUS gstuGetEntryFirst
+(
+    IN  GT_QD_DEV       *dev,
+    OUT GT_STU_ENTRY    *stuEntry
+)
+{
+    DBG_INFO(("gstuGetEntryFirst Called.\n"));
+
+    stuEntry->sid = 0x3F;
+    return gstuGetEntryNext(dev, stuEntry);
+}
+
+/*******************************************************************************
+* gstuFindSidEntry
+*
+* DESCRIPTION:
+*       Find STU entry for a specific SID, it will return the entry, if found,
+*       along with its associated data
+*
+* INPUTS:
+*       stuEntry - contains the SID to search for
+*
+* OUTPUTS:
+*       found    - MV_TRUE, if the appropriate entry exists.
+*       stuEntry - the entry parameters.
+*
+* RETURNS:
+*       MV_OK      - on success.
+*       MV_FAIL    - on error or entry does not exist.
+*       MV_NO_SUCH - no such entry.
+*
+* COMMENTS:
+*       One GetNext from the SID before the searched one.
+*
+*******************************************************************************/
+MV_STATUS gstuFindSidEntry
+(
+    IN  GT_QD_DEV       *dev,
+    INOUT GT_STU_ENTRY  *stuEntry,
+    OUT MV_BOOL         *found
+)
+{
+    GT_STU_ENTRY    entry;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gstuFindSidEntry Called.\n"));
+
+    *found = MV_FALSE;
+    if(stuEntry->sid >= 0x3F)
+        return MV_BAD_PARAM;
+    entry.sid = (stuEntry->sid == 0) ? 0x3F : stuEntry->sid - 1;
+
+    retVal = gstuGetEntryNext(dev, &entry);
+    if(retVal != MV_OK)
+        return retVal;
+    if(entry.sid != stuEntry->sid)
+        return MV_NO_SUCH;
+
+    *stuEntry = entry;
+    *found = MV_TRUE;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gstuGetEntryCount
+*
+* DESCRIPTION:
+*       Gets the current number of valid entries in the STU table
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       numEntries - number of STU entries.
+*
+* RETURNS:
+*       MV_OK      - on success
+*       MV_FAIL    - on error
+*
+* COMMENTS:
+*       Walks the STU.
+*
+*******************************************************************************/
+MV_STATUS gstuGetEntryCount
+(
+    IN  GT_QD_DEV *dev,
+    OUT MV_U32    *numEntries
+)
+{
+    GT_STU_ENTRY    entry;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gstuGetEntryCount Called.\n"));
+
+    *numEntries = 0;
+    entry.sid = 0x3F;
+    while((retVal = gstuGetEntryNext(dev, &entry)) == MV_OK)
+        (*numEntries)++;
+
+    return (retVal == MV_NO_SUCH) ? MV_OK : retVal;
+}
+
+/*******************************************************************************
+* gsysSetRMUMode
+*
+* DESCRIPTION:
+*        Set Rmote Management Unit Mode: disable, enable on port 4, 5 or 6.
+*        When RMU is enabled and this device receives a Remote Management
+*        Request frame directed to this device, the frame will be processed.
+*
+* INPUTS:
+*        rmu - GT_RMU structure
+*
+* OUTPUTS:
+*        None.
+*
+* RETURNS:
+*        MV_OK           - on success
+*        MV_FAIL         - on error
+*        MV_BAD_PARAM    - on unsupported port
+*
+* COMMENTS:
+*        Global Control 2 register, bits 13:12.
+*
+*******************************************************************************/
+MV_STATUS gsysSetRMUMode
+(
+    IN GT_QD_DEV    *dev,
+    IN GT_RMU       *rmu
+)
+{
+    MV_U16          data;
+
+    DBG_INFO(("gsysSetRMUMode Called.\n"));
+
+    if (rmu->rmuEn == MV_FALSE)
+        data = 0;
+    else if ((rmu->port >= 4) && (rmu->port <= 6))
+        data = (MV_U16)(rmu->port - 3);
+    else
+        return MV_BAD_PARAM;
+
+    return mv_switch_mii_write_RegField(CALC_SMI_DEV_ADDR(dev, 0, GLOBAL_REG_ACCESS),
+                                        QD_REG_GLOBAL_CONTROL2, 12, 2, data);
+}
+
+/*******************************************************************************
+* gsysGetRMUMode
+*
+* DESCRIPTION:
+*        Get Rmote Management Unit Mode: disable, enable on port 4, 5 or 6.
+*
+* INPUTS:
+*        None.
+*
+* OUTPUTS:
+*        rmu - GT_RMU structure
+*
+* RETURNS:
+*        MV_OK           - on success
+*        MV_FAIL         - on error
+*
+* COMMENTS:
+*
+*******************************************************************************/
+MV_STATUS gsysGetRMUMode
+(
+    IN  GT_QD_DEV   *dev,
+    OUT GT_RMU      *rmu
+)
+{
+    unsigned int    data;
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gsysGetRMUMode Called.\n"));
+
+    retVal = mv_switch_mii_read(CALC_SMI_DEV_ADDR(dev, 0, GLOBAL_REG_ACCESS),
+                                QD_REG_GLOBAL_CONTROL2, &data);
+    if (retVal != MV_OK)
+        return retVal;
+
+    data = (data >> 12) & 0x3;
+    rmu->rmuEn = data ? MV_TRUE : MV_FALSE;
+    rmu->port = data ? data + 3 : 0;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gsysSwReset
+*
+* DESCRIPTION:
+*       This routine preforms switch software reset.
+*
+* INPUTS:
+*       None.
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK           - on success
+*       MV_FAIL         - on error
+*       MV_NOT_READY    - the reset did not complete in time
+*
+* COMMENTS:
+*       Global Control register, bit 15 (self clearing). Resets the switch
+*       core state machines, the ATU/VTU engines included; the register
+*       values are kept, the register shadow is dropped all the same.
+*
+*******************************************************************************/
+MV_STATUS gsysSwReset
+(
+    IN GT_QD_DEV    *dev
+)
+{
+    HW_DEV_RW_REG   list[2];
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gsysSwReset Called.\n"));
+
+    list[0].cmd = HW_REG_RMW;
+    list[0].addr = CALC_SMI_DEV_ADDR(dev, 0, GLOBAL_REG_ACCESS);
+    list[0].reg = QD_REG_GLOBAL_CONTROL;
+    list[0].data = (0x8000 << 16) | 0x8000;
+
+    list[1].cmd = HW_REG_WAIT_TILL_0;
+    list[1].addr = list[0].addr;
+    list[1].reg = QD_REG_GLOBAL_CONTROL;
+    list[1].data = 15;
+
+    retVal = mv_switch_dev_rw_reg_list(dev, list, 2, NULL);
+    mv_switch_shadow_invalidate();
+
+    return retVal;
+}
+
+/*******************************************************************************
+* phyRegAccess
+*
+* DESCRIPTION:
+*       Accesses a PHY register indirectly through the Global2 SMI PHY
+*       command/data registers, so the PHYs need not be visible on the MDIO
+*       bus (required in SMI_MULTI_ADDR_MODE). The whole transaction runs
+*       as a single register list under one switch lock hold.
+*
+* INPUTS:
+*       port    - logical port number.
+*       regAddr - PHY register offset.
+*       op      - QD_SMI_READ or QD_SMI_WRITE.
+*       data    - value to write (QD_SMI_WRITE).
+*
+* OUTPUTS:
+*       data    - value read (QD_SMI_READ).
+*
+* RETURNS:
+*       MV_OK        - on success
+*       MV_BAD_PARAM - on invalid port or register
+*       MV_FAIL      - on error
+*
+*******************************************************************************/
+static MV_STATUS phyRegAccess
+(
+    IN    GT_QD_DEV    *dev,
+    IN    GT_LPORT     port,
+    IN    MV_U32       regAddr,
+    IN    MV_U32       op,
+    INOUT MV_U16       *data
+)
+{
+    HW_DEV_RW_REG   list[5];
+    MV_U32          entries = 0;
+    MV_U8           g2Addr, phyAddr;
+    MV_STATUS       retVal;
+
+    if ((port >= dev->maxPhyNum) || !(dev->validPhyVec & (1 << port)) || (regAddr > 0x1F))
+        return MV_BAD_PARAM;
+
+    phyAddr = CALC_SMI_DEV_ADDR(dev, port, PHY_ACCESS);
+    g2Addr = CALC_SMI_DEV_ADDR(dev, 0, GLOBAL2_REG_ACCESS);
+
+    list[entries].cmd = HW_REG_WAIT_TILL_0;
+    list[entries].addr = g2Addr;
+    list[entries].reg = QD_REG_SMI_PHY_CMD;
+    list[entries++].data = 15;
+
+    if (op == QD_SMI_WRITE)
+    {
+        list[entries].cmd = HW_REG_WRITE;
+        list[entries].addr = g2Addr;
+        list[entries].reg = QD_REG_SMI_PHY_DATA;
+        list[entries++].data = *data;
+    }
+
+    list[entries].cmd = HW_REG_WRITE;
+    list[entries].addr = g2Addr;
+    list[entries].reg = QD_REG_SMI_PHY_CMD;
+    list[entries++].data = QD_SMI_BUSY | (QD_SMI_CLAUSE22 << QD_SMI_MODE_BIT) |
+                           (op << QD_SMI_OP_BIT) | (phyAddr << QD_SMI_DEV_ADDR_BIT) |
+                           (regAddr << QD_SMI_REG_ADDR_BIT);
+
+    list[entries].cmd = HW_REG_WAIT_TILL_0;
+    list[entries].addr = g2Addr;
+    list[entries].reg = QD_REG_SMI_PHY_CMD;
+    list[entries++].data = 15;
+
+    if (op == QD_SMI_READ)
+    {
+        list[entries].cmd = HW_REG_READ;
+        list[entries].addr = g2Addr;
+        list[entries].reg = QD_REG_SMI_PHY_DATA;
+        list[entries++].data = 0;
+    }
+
+    retVal = mv_switch_dev_rw_reg_list(dev, list, entries, NULL);
+    if (retVal != MV_OK)
+    {
+        DBG_INFO(("Failed.\n"));
+        return retVal;
+    }
+
+    if (op == QD_SMI_READ)
+        *data = (MV_U16)list[entries - 1].data;
+
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gprtGetPhyReg
+*
+* DESCRIPTION:
+*       This routine reads Phy Registers.
+*
+* INPUTS:
+*       port    - logical port number
+*       regAddr - The register's address.
+*
+* OUTPUTS:
+*       data    - The read register's data.
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*       Uses the Global2 SMI PHY command/data registers.
+*
+* GalTis:
+*
+*******************************************************************************/
+MV_STATUS gprtGetPhyReg
+(
+    IN  GT_QD_DEV    *dev,
+    IN  GT_LPORT     port,
+    IN  MV_U32       regAddr,
+    OUT MV_U16       *data
+)
+{
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gprtGetPhyReg Called.\n"));
+
+    gtSemTake(dev, dev->phyRegsSem, OS_WAIT_FOREVER);
+    retVal = phyRegAccess(dev, port, regAddr, QD_SMI_READ, data);
+    gtSemGive(dev, dev->phyRegsSem);
+
+    return retVal;
+}
+
+/*******************************************************************************
+* gprtSetPhyReg
+*
+* DESCRIPTION:
+*       This routine writes Phy Registers.
+*
+* INPUTS:
+*       port    - logical port number
+*       regAddr - The register's address.
+*       data    - The data to write.
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*       Uses the Global2 SMI PHY command/data registers.
+*
+* GalTis:
+*
+*******************************************************************************/
+MV_STATUS gprtSetPhyReg
+(
+    IN  GT_QD_DEV    *dev,
+    IN  GT_LPORT     port,
+    IN  MV_U32       regAddr,
+    IN  MV_U16       data
+)
+{
+    MV_STATUS       retVal;
+
+    DBG_INFO(("gprtSetPhyReg Called.\n"));
+
+    gtSemTake(dev, dev->phyRegsSem, OS_WAIT_FOREVER);
+    retVal = phyRegAccess(dev, port, regAddr, QD_SMI_WRITE, &data);
+    gtSemGive(dev, dev->phyRegsSem);
+
+    return retVal;
+}
+
+/* Read-modify-write of a PHY register field, caller holds phyRegsSem */
+static MV_STATUS phyRegFieldSet
+(
+    IN GT_QD_DEV    *dev,
+    IN GT_LPORT     port,
+    IN MV_U32       regAddr,
+    IN MV_U8        fieldOffset,
+    IN MV_U8        fieldLength,
+    IN MV_U16       data
+)
+{
+    MV_U16          mask, tmp;
+    MV_STATUS       retVal;
+
+    retVal = phyRegAccess(dev, port, regAddr, QD_SMI_READ, &tmp);
+    if (retVal != MV_OK)
+        return retVal;
+
+    CALC_MASK(fieldOffset, fieldLength, mask);
+    tmp = (tmp & ~mask) | ((data << fieldOffset) & mask);
+
+    return phyRegAccess(dev, port, regAddr, QD_SMI_WRITE, &tmp);
+}
+
+/*******************************************************************************
+* gprtPortPowerGet
+*
+* DESCRIPTION:
+*       This routine reads the PHY power state of a port.
+*
+* INPUTS:
+*       port    - the logical port number.
+*
+* OUTPUTS:
+*       powerOn - MV_TRUE unless the PHY is powered down.
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+*******************************************************************************/
+MV_STATUS gprtPortPowerGet( IN GT_QD_DEV  *dev, IN GT_LPORT port, OUT MV_BOOL *powerOn)
+{
+    MV_U16          data;
+    MV_STATUS       retVal;
+
+    retVal = gprtGetPhyReg(dev, port, QD_PHY_CONTROL_REG, &data);
+    if(retVal != MV_OK)
+        return retVal;
+
+    *powerOn = (data & (1 << QD_PHY_POWER_BIT)) ? MV_FALSE : MV_TRUE;
+    return MV_OK;
+}
+
+/*******************************************************************************
+* gprtPortPowerSet
+*
+* DESCRIPTION:
+*       This routine resets port disables/enables port power
+*
+* INPUTS:
+*       port  - the logical port number.
+*       onoff - 0 port power down, otherwise port power up
+*
+* OUTPUTS:
+*       None.
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*
+*
+* GalTis:
+*
+*******************************************************************************/
+MV_STATUS gprtPortPowerSet(IN GT_QD_DEV  *dev,
+			   IN GT_LPORT   port,
+			   IN MV_BOOL    onoff)
+{
+	MV_U16		down = (onoff != MV_TRUE) ? 1 : 0;
+	MV_STATUS	retVal;
+
+	/* the page register makes the sequence stateful, keep it atomic */
+	gtSemTake(dev, dev->phyRegsSem, OS_WAIT_FOREVER);
+
+	/* Set Phy to page#2 */
+	retVal = phyRegFieldSet(dev, port, QD_PHY_PAGE_ANY_REG, 0, 8, 2);
+
+	/* Page 2, register 16, bit 3 GMII interface power down */
+	retVal |= phyRegFieldSet(dev, port, QD_PHY_SPEC_CONTROL_REG, 3, 1, !down);
+
+	/* Set Phy to page#0 */
+	retVal |= phyRegFieldSet(dev, port, QD_PHY_PAGE_ANY_REG, 0, 8, 0);
+
+	/* Page 0, register 16, bits 3,2. Copper Transmitter disable, Power down */
+	retVal |= phyRegFieldSet(dev, port, QD_PHY_SPEC_CONTROL_REG, 2, 2, down ? 3 : 0);
+
+	/* Register 0, bit 11, Power Down */
+	retVal |= phyRegFieldSet(dev, port, QD_PHY_CONTROL_REG, QD_PHY_POWER_BIT, 1, down);
+
+	gtSemGive(dev, dev->phyRegsSem);
+
+	return (retVal == MV_OK) ? MV_OK : MV_FAIL;
+}
+
+/*******************************************************************************
+* gprtGetLinkState
+*
+* DESCRIPTION:
+*       This routine retrives the link state.
+*
+* INPUTS:
+*       port - the logical port number.
+*
+* OUTPUTS:
+*       state - MV_TRUE for Up  or MV_FALSE otherwise
+*
+* RETURNS:
+*       MV_OK   - on success
+*       MV_FAIL - on error
+*
+* COMMENTS:
+*
+*
+* GalTis:
+*
+*******************************************************************************/
+MV_STATUS gprtGetLinkState
+(
+    IN  GT_QD_DEV *dev,
+    IN  GT_LPORT  port,
+    OUT MV_BOOL   *state
+)
+{
+    unsigned int    data;           /* Used to poll the SWReset bit */
     MV_STATUS       retVal;         /* Functions return value.      */
 
     DBG_INFO(("gprtGetLinkState Called.\n"));
@@ -0,0 +1,1373 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+
+/*
+ * ATU (address database) services on top of the DSDT ATU engine.
+ *
+ * The ATU walk is resumable: its state is a cursor (database and last MAC
+ * returned) plus a small chunk of prefetched entries, so the table can be
+ * streamed to a consumer without holding it in memory and without holding
+ * the ATU engine between entries. Entries are fetched in chunks with
+ * mv_switch_atu_dump(), i.e. over RMU when it runs and with GetNext over
+ * SMI otherwise.
+ *
+ * /proc/mv_switch_atu streams the walk; writing "<db>", "<first> <last>"
+ * or "all" to it selects the databases.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <linux/bitops.h>
+#include <linux/mutex.h>
+#include <linux/etherdevice.h>
+#include <linux/vmalloc.h>
+#include <linux/sort.h>
+#include <asm/uaccess.h>
+
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "dsdt/msApiPrototype.h"
+#include "mv_switch.h"
+
+extern GT_QD_DEV qddev;
+
+/*******************************************************************************
+* mv_switch_atu_walk_start - Start a walk of databases dbFirst..dbLast.
+*
+*******************************************************************************/
+void mv_switch_atu_walk_start(MV_SWITCH_ATU_WALK *walk, MV_U16 dbFirst, MV_U16 dbLast)
+{
+	memset(walk, 0, sizeof(*walk));
+	walk->dbNum = dbFirst;
+	walk->dbLast = dbLast;
+	memset(walk->lastMac, 0xFF, 6);
+	walk->start = ktime_get();
+}
+
+/*******************************************************************************
+* mv_switch_atu_walk_next - Return the next entry of a walk.
+*
+* DESCRIPTION:
+*       Entries come in MAC order per database, databases in increasing
+*       order. The ATU engine is only held while a chunk is fetched, so the
+*       walk may be suspended between calls for any time; entries learned or
+*       aged meanwhile behind the cursor are not seen.
+*
+* OUTPUT:
+*       entry - the next entry.
+*
+* RETURN:
+*       MV_OK, MV_NO_SUCH at the end of the walk, or the ATU access error
+*       (the walk is then over too).
+*
+*******************************************************************************/
+MV_STATUS mv_switch_atu_walk_next(GT_QD_DEV *dev, MV_SWITCH_ATU_WALK *walk, GT_ATU_ENTRY *entry)
+{
+	MV_U32		count;
+	MV_STATUS	status;
+
+	while (walk->chunkIdx >= walk->chunkCount) {
+		if (walk->status != MV_OK)
+			return walk->status;
+
+		if (walk->dbDone) {
+			if (walk->dbNum >= walk->dbLast) {
+				walk->status = MV_NO_SUCH;
+				walk->elapsedNs = ktime_to_ns(ktime_sub(ktime_get(), walk->start));
+				return MV_NO_SUCH;
+			}
+			walk->dbNum++;
+			walk->dbDone = MV_FALSE;
+			memset(walk->lastMac, 0xFF, 6);
+		}
+
+		status = mv_switch_atu_dump(dev, walk->dbNum, walk->lastMac, walk->chunk,
+					    MV_SWITCH_ATU_WALK_CHUNK, &count);
+		if (status != MV_OK) {
+			walk->status = status;
+			walk->elapsedNs = ktime_to_ns(ktime_sub(ktime_get(), walk->start));
+			return status;
+		}
+
+		walk->chunkIdx = 0;
+		walk->chunkCount = count;
+		if (count)
+			memcpy(walk->lastMac, walk->chunk[count - 1].macAddr, 6);
+		/* a broadcast entry ends the database, GetNext would wrap */
+		if (count < MV_SWITCH_ATU_WALK_CHUNK || is_broadcast_ether_addr(walk->lastMac))
+			walk->dbDone = MV_TRUE;
+	}
+
+	*entry = walk->chunk[walk->chunkIdx++];
+	walk->entries++;
+
+	return MV_OK;
+}
+
+/* Walk rate in entries per second */
+static MV_U32 mvSwitchAtuWalkRate(MV_SWITCH_ATU_WALK *walk)
+{
+	s64 ns = walk->elapsedNs ? walk->elapsedNs : ktime_to_ns(ktime_sub(ktime_get(), walk->start));
+
+	return ns ? (MV_U32)div_s64((s64)walk->entries * NSEC_PER_SEC, ns) : 0;
+}
+
+/*******************************************************************************
+* /proc/mv_switch_atu
+*******************************************************************************/
+static MV_U16 switch_atu_db_first;
+static MV_U16 switch_atu_db_last;
+
+#define ATU_SEQ_TRAILER		((void *)2)
+
+struct mv_switch_atu_seq {
+	MV_SWITCH_ATU_WALK	walk;
+	GT_ATU_ENTRY		entry;		/* record at 'pos' */
+	loff_t			pos;
+	MV_BOOL			end;		/* record at 'pos' is the trailer */
+};
+
+/* Positions the walk on record 'pos': 0 header, then entries, then trailer */
+static void *mvSwitchAtuSeqGet(struct mv_switch_atu_seq *it, loff_t pos)
+{
+	if (pos == 0 || pos < it->pos) {
+		mv_switch_atu_walk_start(&it->walk, switch_atu_db_first, switch_atu_db_last);
+		it->pos = 0;
+		it->end = MV_FALSE;
+	}
+	if (pos == 0)
+		return SEQ_START_TOKEN;
+
+	while (it->pos < pos) {
+		if (it->end)
+			return NULL;
+		if (mv_switch_atu_walk_next(&qddev, &it->walk, &it->entry) != MV_OK)
+			it->end = MV_TRUE;
+		it->pos++;
+	}
+
+	return it->end ? ATU_SEQ_TRAILER : &it->entry;
+}
+
+static void *mvSwitchAtuSeqStart(struct seq_file *m, loff_t *pos)
+{
+	return mvSwitchAtuSeqGet(m->private, *pos);
+}
+
+static void *mvSwitchAtuSeqNext(struct seq_file *m, void *v, loff_t *pos)
+{
+	return mvSwitchAtuSeqGet(m->private, ++(*pos));
+}
+
+static void mvSwitchAtuSeqStop(struct seq_file *m, void *v)
+{
+}
+
+static int mvSwitchAtuSeqShow(struct seq_file *m, void *v)
+{
+	struct mv_switch_atu_seq	*it = m->private;
+	GT_ATU_ENTRY			*e = v;
+
+	if (v == SEQ_START_TOKEN) {
+		seq_printf(m, "db %u..%u\n  db  mac                ports    state prio\n",
+			   switch_atu_db_first, switch_atu_db_last);
+	} else if (v == ATU_SEQ_TRAILER) {
+		seq_printf(m, "%u entries in %lld us, %u entries/s%s\n", it->walk.entries,
+			   div_s64(it->walk.elapsedNs, NSEC_PER_USEC), mvSwitchAtuWalkRate(&it->walk),
+			   (it->walk.status == MV_NO_SUCH) ? "" : ", walk FAILED");
+	} else {
+		seq_printf(m, "%4u  %02x:%02x:%02x:%02x:%02x:%02x  0x%04x   0x%x   %u\n", e->DBNum,
+			   e->macAddr[0], e->macAddr[1], e->macAddr[2], e->macAddr[3], e->macAddr[4],
+			   e->macAddr[5], e->portVec, e->entryState.ucEntryState, e->prio);
+	}
+
+	return 0;
+}
+
+static const struct seq_operations mv_switch_atu_seq_ops = {
+	.start	= mvSwitchAtuSeqStart,
+	.next	= mvSwitchAtuSeqNext,
+	.stop	= mvSwitchAtuSeqStop,
+	.show	= mvSwitchAtuSeqShow,
+};
+
+static int mvSwitchAtuProcOpen(struct inode *inode, struct file *file)
+{
+	return __seq_open_private(file, &mv_switch_atu_seq_ops,
+				  sizeof(struct mv_switch_atu_seq)) ? 0 : -ENOMEM;
+}
+
+static ssize_t mvSwitchAtuProcWrite(struct file *file, const char __user *buffer,
+				    size_t count, loff_t *ppos)
+{
+	char		buf[32];
+	unsigned int	first, last;
+	int		n;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, buffer, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (!strncmp(buf, "all", 3)) {
+		first = 0;
+		last = MV_SWITCH_ATU_DB_MAX;
+	} else {
+		n = sscanf(buf, "%u %u", &first, &last);
+		if (n < 1)
+			return -EINVAL;
+		if (n == 1)
+			last = first;
+		if (first > last || last > MV_SWITCH_ATU_DB_MAX)
+			return -EINVAL;
+	}
+
+	switch_atu_db_first = first;
+	switch_atu_db_last = last;
+
+	return count;
+}
+
+static const struct file_operations mv_switch_atu_proc_fops = {
+	.owner		= THIS_MODULE,
+	.open		= mvSwitchAtuProcOpen,
+	.read		= seq_read,
+	.write		= mvSwitchAtuProcWrite,
+	.llseek		= seq_lseek,
+	.release	= seq_release_private,
+};
+
+/*******************************************************************************
+* ATU command engine
+*
+* ATU operations wait for the busy bit of the ATU Operation register before
+* they are issued and, when they return data, before it is read. The wait is
+* bounded by the register poll deadline (HW_REG_WAIT_TILL_0). An ATU still
+* busy at the deadline is marked wedged: the operations that follow probe
+* the busy bit once and fail with MV_NOT_READY instead of holding the ATU
+* and SMI locks for a whole deadline each. An ATU wedged for
+* MV_SWITCH_ATU_WEDGED_RESET_MS is recovered with a switch software reset.
+* The reset runs out of line, in switch_atu_recover_work: the register
+* queue is drained first, the reset is issued with the ATU and VTU engines
+* held, and then the register shadow and the ATU, VTU and STU mirrors are
+* all read back. Callers hold the ATU semaphore; the counters and the
+* wedged state are under switch_atu_cmd_lock.
+*******************************************************************************/
+static MV_SWITCH_ATU_CMD_STATS	switch_atu_cmd_stats;
+static MV_BOOL			switch_atu_wedged;
+static s64			switch_atu_wedged_ns;	/* wedged since, or last reset */
+static DEFINE_SPINLOCK(switch_atu_cmd_lock);
+
+static void mvSwitchAtuMirrorInvalidate(void);
+
+static void mv_switch_atu_recover(struct work_struct *work)
+{
+	GT_QD_DEV	*dev = &qddev;
+	MV_STATUS	status;
+
+	/* queued register lists complete (or fail fast) before the reset */
+	mv_switch_queue_flush();
+
+	gtSemTake(dev, dev->atuRegsSem, OS_WAIT_FOREVER);
+	gtSemTake(dev, dev->vtuRegsSem, OS_WAIT_FOREVER);
+	status = gsysSwReset(dev);
+	gtSemGive(dev, dev->vtuRegsSem);
+	gtSemGive(dev, dev->atuRegsSem);
+
+	/* whatever the reset did to the tables, read them back */
+	mv_switch_shadow_invalidate();
+	mvSwitchAtuMirrorInvalidate();
+	mv_switch_vtu_init();
+
+	if (status != MV_OK)
+		printk(KERN_ERR "mv_switch: switch core reset failed (%d)\n", status);
+	/* the next ATU command probes the busy bit and resumes when idle */
+}
+
+static DECLARE_WORK(switch_atu_recover_work, mv_switch_atu_recover);
+
+/* Account an ATU command that did not complete */
+void mv_switch_atu_cmd_failed(MV_STATUS status)
+{
+	MV_BOOL wedged = MV_FALSE;
+
+	spin_lock(&switch_atu_cmd_lock);
+	if (status != MV_NOT_READY) {
+		switch_atu_cmd_stats.errors++;
+	} else {
+		switch_atu_cmd_stats.timeouts++;
+		if (!switch_atu_wedged) {
+			switch_atu_wedged = wedged = MV_TRUE;
+			switch_atu_wedged_ns = ktime_to_ns(ktime_get());
+		}
+	}
+	spin_unlock(&switch_atu_cmd_lock);
+
+	if (wedged)
+		printk(KERN_ERR "mv_switch: ATU busy past its deadline, operations suspended\n");
+}
+
+/*******************************************************************************
+* mv_switch_atu_cmd_ready - Admit 'ops' ATU commands.
+*
+* RETURN:
+*       MV_OK at once unless the ATU is wedged. A wedged ATU is probed
+*       with a single read: MV_OK if it became idle, MV_NOT_READY if not.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_atu_cmd_ready(GT_QD_DEV *dev, MV_U32 ops)
+{
+	HW_DEV_RW_REG	probe = {
+		.cmd	= HW_REG_READ,
+		.addr	= 0x1b,
+		.reg	= QD_REG_ATU_OPERATION,
+	};
+	MV_BOOL		wedged, reset;
+	MV_STATUS	status;
+	s64		now;
+
+	spin_lock(&switch_atu_cmd_lock);
+	switch_atu_cmd_stats.ops += ops;
+	wedged = switch_atu_wedged;
+	spin_unlock(&switch_atu_cmd_lock);
+	if (!wedged)
+		return MV_OK;
+
+	status = mv_switch_dev_rw_reg_list(dev, &probe, 1, NULL);
+
+	spin_lock(&switch_atu_cmd_lock);
+	if (status != MV_OK) {
+		switch_atu_cmd_stats.errors++;
+		spin_unlock(&switch_atu_cmd_lock);
+		return MV_FAIL;
+	}
+	if (!(probe.data & 0x8000)) {
+		switch_atu_wedged = MV_FALSE;
+		switch_atu_cmd_stats.recoveries++;
+		spin_unlock(&switch_atu_cmd_lock);
+		printk(KERN_INFO "mv_switch: ATU idle again, operations resumed\n");
+		return MV_OK;
+	}
+
+	now = ktime_to_ns(ktime_get());
+	reset = (now - switch_atu_wedged_ns >= (s64)MV_SWITCH_ATU_WEDGED_RESET_MS * NSEC_PER_MSEC);
+	if (reset) {
+		/* the next reset, if needed, is one period away */
+		switch_atu_wedged_ns = now;
+		switch_atu_cmd_stats.resets++;
+	}
+	spin_unlock(&switch_atu_cmd_lock);
+
+	if (reset) {
+		printk(KERN_ERR "mv_switch: ATU wedged for %d ms, resetting the switch core\n",
+		       MV_SWITCH_ATU_WEDGED_RESET_MS);
+		schedule_work(&switch_atu_recover_work);
+	}
+
+	spin_lock(&switch_atu_cmd_lock);
+	switch_atu_cmd_stats.rejected += ops;
+	spin_unlock(&switch_atu_cmd_lock);
+
+	return MV_NOT_READY;
+}
+
+/*******************************************************************************
+* mv_switch_atu_cmd_wait - Wait until the ATU is idle.
+*
+* RETURN:
+*       MV_OK, MV_NOT_READY when the deadline passed (the ATU is then
+*       wedged), or the SMI error.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_atu_cmd_wait(GT_QD_DEV *dev)
+{
+	HW_DEV_RW_REG	wait = {
+		.cmd	= HW_REG_WAIT_TILL_0,
+		.addr	= 0x1b,
+		.reg	= QD_REG_ATU_OPERATION,
+		.data	= 15,
+	};
+	ktime_t		start = ktime_get();
+	MV_STATUS	status;
+	MV_U32		us;
+
+	status = mv_switch_dev_rw_reg_list(dev, &wait, 1, NULL);
+
+	us = (MV_U32)ktime_us_delta(ktime_get(), start);
+	spin_lock(&switch_atu_cmd_lock);
+	if (us > switch_atu_cmd_stats.maxWaitUs)
+		switch_atu_cmd_stats.maxWaitUs = us;
+	spin_unlock(&switch_atu_cmd_lock);
+	if (status != MV_OK)
+		mv_switch_atu_cmd_failed(status);
+
+	return status;
+}
+
+int mv_switch_atu_cmd_show(char *buf)
+{
+	MV_SWITCH_ATU_CMD_STATS	s;
+	MV_BOOL			wedged;
+
+	spin_lock(&switch_atu_cmd_lock);
+	s = switch_atu_cmd_stats;
+	wedged = switch_atu_wedged;
+	spin_unlock(&switch_atu_cmd_lock);
+
+	return sprintf(buf, "atu engine %s: ops %u timeouts %u errors %u rejected %u recoveries %u resets %u, max wait %u us\n",
+		       wedged ? "wedged" : "ready", s.ops, s.timeouts, s.errors,
+		       s.rejected, s.recoveries, s.resets, s.maxWaitUs);
+}
+
+/*******************************************************************************
+* ATU mirror
+*
+* Software copy of the hardware ATU, hashed on (DBNum, MAC), so that MAC
+* lookups are memory operations. It is kept coherent by
+*   - mv_switch_atu_mirror_op(), called by atuOperationPerform() for every
+*     load/purge, flush/move and GetNext done through the driver,
+*   - mv_switch_atu_mirror_update()/_remove(), for entries read back,
+*   - an incremental resync: every MV_SWITCH_ATU_RESYNC_MS a chunk of one
+*     database is read back; at the end of a database pass the entries that
+*     were neither read back nor updated during the pass are dropped.
+* Only databases that ever held a mirrored entry or were added with
+* mv_switch_atu_mirror_db_add() (VLAN group databases) are resynced.
+*******************************************************************************/
+typedef struct mv_switch_atu_mirror_entry {
+	struct mv_switch_atu_mirror_entry *next;
+	MV_U8		macAddr[6];
+	MV_U16		DBNum;
+	MV_U8		prio;
+	MV_U8		state;
+	MV_U32		portVec;
+	MV_U32		gen;		/* resync pass that last saw the entry */
+} MV_SWITCH_ATU_MIRROR_ENTRY;
+
+static MV_SWITCH_ATU_MIRROR_ENTRY	*switch_atu_mirror[MV_SWITCH_ATU_MIRROR_BUCKETS];
+static DEFINE_SPINLOCK(switch_atu_mirror_lock);
+static DECLARE_BITMAP(switch_atu_mirror_dbs, MV_SWITCH_ATU_DB_MAX + 1);
+static MV_U32				switch_atu_mirror_gen;
+static MV_SWITCH_ATU_MIRROR_STATS	switch_atu_mirror_stats;
+
+static struct delayed_work		switch_atu_resync_work;
+static MV_SWITCH_ATU_WALK		switch_atu_resync_walk;
+static MV_BOOL				switch_atu_resync_restart;	/* under the mirror lock */
+
+static inline MV_U32 mvSwitchAtuHash(MV_U16 dbNum, const MV_U8 *mac)
+{
+	MV_U32 h;
+
+	h = ((mac[2] << 24) | (mac[3] << 16) | (mac[4] << 8) | mac[5]) ^ ((mac[0] << 8) | mac[1]);
+	h ^= dbNum * 0x9E3779B1;
+	h ^= h >> 16;
+
+	return h & (MV_SWITCH_ATU_MIRROR_BUCKETS - 1);
+}
+
+static inline MV_BOOL mvSwitchAtuMacEqual(const MV_U8 *a, const MV_U8 *b)
+{
+	return (a[0] == b[0] && a[1] == b[1] && a[2] == b[2] &&
+		a[3] == b[3] && a[4] == b[4] && a[5] == b[5]) ? MV_TRUE : MV_FALSE;
+}
+
+/* Link to the entry, NULL-terminated chain. Called with the mirror lock held. */
+static MV_SWITCH_ATU_MIRROR_ENTRY **mvSwitchAtuMirrorSlot(MV_U16 dbNum, const MV_U8 *mac)
+{
+	MV_SWITCH_ATU_MIRROR_ENTRY **slot = &switch_atu_mirror[mvSwitchAtuHash(dbNum, mac)];
+
+	while (*slot && ((*slot)->DBNum != dbNum || !mvSwitchAtuMacEqual((*slot)->macAddr, mac)))
+		slot = &(*slot)->next;
+
+	return slot;
+}
+
+/*******************************************************************************
+* mv_switch_atu_mirror_update - Insert or update a mirror entry.
+*
+* DESCRIPTION:
+*       A zero entry state removes the entry. May sleep.
+*
+*******************************************************************************/
+void mv_switch_atu_mirror_update(GT_ATU_ENTRY *entry)
+{
+	MV_SWITCH_ATU_MIRROR_ENTRY	**slot, *e, *fresh;
+	unsigned long			flags;
+
+	if (entry->entryState.ucEntryState == 0) {
+		mv_switch_atu_mirror_remove(entry->DBNum, entry->macAddr);
+		return;
+	}
+
+	fresh = NULL;
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	slot = mvSwitchAtuMirrorSlot(entry->DBNum, entry->macAddr);
+	if (*slot == NULL) {
+		/* allocate outside the lock and look again */
+		spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+		fresh = kmalloc(sizeof(MV_SWITCH_ATU_MIRROR_ENTRY), GFP_KERNEL);
+		spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+		slot = mvSwitchAtuMirrorSlot(entry->DBNum, entry->macAddr);
+	}
+	e = *slot;
+	if (e == NULL) {
+		if (fresh == NULL || switch_atu_mirror_stats.entries >= MV_SWITCH_ATU_MIRROR_MAX) {
+			switch_atu_mirror_stats.dropped++;
+			spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+			kfree(fresh);
+			return;
+		}
+		e = fresh;
+		fresh = NULL;
+		memcpy(e->macAddr, entry->macAddr, 6);
+		e->DBNum = entry->DBNum;
+		e->next = NULL;
+		*slot = e;
+		switch_atu_mirror_stats.entries++;
+		__set_bit(entry->DBNum & MV_SWITCH_ATU_DB_MAX, switch_atu_mirror_dbs);
+	}
+	e->prio = entry->prio;
+	e->state = entry->entryState.ucEntryState;
+	e->portVec = entry->portVec;
+	e->gen = switch_atu_mirror_gen;
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+
+	kfree(fresh);
+}
+
+void mv_switch_atu_mirror_remove(MV_U16 dbNum, const MV_U8 *mac)
+{
+	MV_SWITCH_ATU_MIRROR_ENTRY	**slot, *e;
+	unsigned long			flags;
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	slot = mvSwitchAtuMirrorSlot(dbNum, mac);
+	e = *slot;
+	if (e) {
+		*slot = e->next;
+		switch_atu_mirror_stats.entries--;
+	}
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+
+	kfree(e);
+}
+
+/*******************************************************************************
+* mv_switch_atu_mirror_db_add - Include an address database in the resync.
+*
+* DESCRIPTION:
+*       For databases the switch learns into by itself, e.g. the one of a
+*       VLAN group, so that learned entries reach the mirror even when the
+*       driver never loaded an entry there.
+*
+*******************************************************************************/
+void mv_switch_atu_mirror_db_add(MV_U16 dbNum)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	__set_bit(dbNum & MV_SWITCH_ATU_DB_MAX, switch_atu_mirror_dbs);
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+}
+
+/* Unicast entry states 1..7 are dynamic (aging); everything else is locked */
+static inline MV_BOOL mvSwitchAtuMirrorUnlocked(MV_SWITCH_ATU_MIRROR_ENTRY *e)
+{
+	return (!(e->macAddr[0] & 0x01) && e->state <= 7) ? MV_TRUE : MV_FALSE;
+}
+
+/*******************************************************************************
+* mvSwitchAtuMirrorFlush - Mirror of a flush or move.
+*
+* INPUT:
+*       allDb      - all databases, or dbNum only.
+*       unlocked   - dynamic entries only.
+*       moveFrom   - -1 for a flush, else the port whose entries move to
+*                    'moveTo' (0xF removes the port from the entries).
+*       stale      - only entries not seen in the current resync pass, used
+*                    to drop what a database pass did not read back; the
+*                    dynamic ones aged out and are queued as events.
+*
+*******************************************************************************/
+static MV_U32 mvSwitchAtuMirrorFlush(MV_BOOL allDb, MV_U16 dbNum, MV_BOOL unlocked,
+				     int moveFrom, int moveTo, MV_BOOL stale)
+{
+	MV_SWITCH_ATU_MIRROR_ENTRY	**slot, *e, *freed = NULL;
+	unsigned long			flags;
+	MV_U32				i, removed = 0;
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	for (i = 0; i < MV_SWITCH_ATU_MIRROR_BUCKETS; i++) {
+		slot = &switch_atu_mirror[i];
+		while ((e = *slot) != NULL) {
+			if ((!allDb && e->DBNum != dbNum) ||
+			    (unlocked && !mvSwitchAtuMirrorUnlocked(e)) ||
+			    (stale && e->gen == switch_atu_mirror_gen)) {
+				slot = &e->next;
+				continue;
+			}
+			if (moveFrom >= 0) {
+				if (!(e->portVec & (1 << moveFrom))) {
+					slot = &e->next;
+					continue;
+				}
+				e->portVec &= ~(1 << moveFrom);
+				if (moveTo != 0xF)
+					e->portVec |= (1 << moveTo);
+				if (e->portVec) {
+					slot = &e->next;
+					continue;
+				}
+			}
+			*slot = e->next;
+			e->next = freed;
+			freed = e;
+			removed++;
+		}
+	}
+	switch_atu_mirror_stats.entries -= removed;
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+
+	while (freed) {
+		e = freed;
+		freed = e->next;
+		if (stale && mvSwitchAtuMirrorUnlocked(e))
+			mv_switch_atu_event_age_out(e->DBNum, e->macAddr, e->portVec);
+		kfree(e);
+	}
+
+	return removed;
+}
+
+/*******************************************************************************
+* mv_switch_atu_mirror_op - Apply a successful ATU operation to the mirror.
+*
+* DESCRIPTION:
+*       Called by atuOperationPerform() with the ATU semaphore held.
+*
+*******************************************************************************/
+void mv_switch_atu_mirror_op(GT_ATU_OPERATION atuOp, GT_EXTRA_OP_DATA *opData, GT_ATU_ENTRY *entry)
+{
+	MV_BOOL	move = (entry->entryState.ucEntryState == 0xF && opData != NULL) ? MV_TRUE : MV_FALSE;
+	int	from = move ? (opData->moveFrom & 0xF) : -1;
+	int	to = move ? (opData->moveTo & 0xF) : 0xF;
+
+	switch (atuOp) {
+	case LOAD_PURGE_ENTRY:
+		mv_switch_atu_mirror_update(entry);
+		break;
+	case GET_NEXT_ENTRY:
+		/* end of walk marker, not an entry */
+		if (entry->entryState.ucEntryState != 0)
+			mv_switch_atu_mirror_update(entry);
+		break;
+	case FLUSH_ALL:
+	case FLUSH_UNLOCKED:
+		mvSwitchAtuMirrorFlush(MV_TRUE, 0, atuOp == FLUSH_UNLOCKED, from, to, MV_FALSE);
+		break;
+	case FLUSH_ALL_IN_DB:
+	case FLUSH_UNLOCKED_IN_DB:
+		mvSwitchAtuMirrorFlush(MV_FALSE, entry->DBNum, atuOp == FLUSH_UNLOCKED_IN_DB, from, to, MV_FALSE);
+		break;
+	default:
+		break;
+	}
+}
+
+/*******************************************************************************
+* mv_switch_atu_mirror_find - Look a MAC up in the mirror.
+*
+* INPUT:
+*       entry - DBNum and macAddr to look up.
+*
+* OUTPUT:
+*       entry - portVec, prio and entry state of the mirrored entry.
+*
+* RETURN:
+*       MV_TRUE if the entry is mirrored. May be called from any context.
+*
+*******************************************************************************/
+MV_BOOL mv_switch_atu_mirror_find(GT_ATU_ENTRY *entry)
+{
+	MV_SWITCH_ATU_MIRROR_ENTRY	*e;
+	unsigned long			flags;
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	e = *mvSwitchAtuMirrorSlot(entry->DBNum, entry->macAddr);
+	if (e) {
+		entry->prio = e->prio;
+		entry->portVec = e->portVec;
+		entry->entryState.ucEntryState = e->state;
+		entry->trunkMember = MV_FALSE;
+		switch_atu_mirror_stats.hits++;
+	} else {
+		switch_atu_mirror_stats.misses++;
+	}
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+
+	return e ? MV_TRUE : MV_FALSE;
+}
+
+/*******************************************************************************
+* mv_switch_atu_mac_port - Which port a MAC address was learned on.
+*
+* RETURN:
+*       The lowest port of the mirrored entry's port vector, -1 if the MAC is
+*       not mirrored. May be called from any context.
+*
+*******************************************************************************/
+int mv_switch_atu_mac_port(MV_U16 dbNum, const MV_U8 *mac)
+{
+	GT_ATU_ENTRY entry;
+
+	entry.DBNum = dbNum;
+	memcpy(entry.macAddr, mac, 6);
+	if (!mv_switch_atu_mirror_find(&entry) || entry.portVec == 0)
+		return -1;
+
+	return ffs(entry.portVec) - 1;
+}
+
+/*
+ * First resynced database at or after 'from', under the mirror lock. Past
+ * the last one it wraps to the first database of the set (database 0 with
+ * an empty set), so a walk never starts out of range.
+ */
+static MV_U32 mvSwitchAtuResyncDb(MV_U32 from, MV_BOOL *wrapped)
+{
+	MV_U32 db = MV_SWITCH_ATU_DB_MAX + 1;
+
+	if (from <= MV_SWITCH_ATU_DB_MAX)
+		db = find_next_bit(switch_atu_mirror_dbs, MV_SWITCH_ATU_DB_MAX + 1, from);
+	if (db > MV_SWITCH_ATU_DB_MAX) {
+		*wrapped = MV_TRUE;
+		db = find_first_bit(switch_atu_mirror_dbs, MV_SWITCH_ATU_DB_MAX + 1);
+		if (db > MV_SWITCH_ATU_DB_MAX)
+			db = 0;
+	}
+
+	return db;
+}
+
+/* One resync step: reads back up to MV_SWITCH_ATU_RESYNC_BUDGET entries */
+static void mvSwitchAtuResyncWork(struct work_struct *work)
+{
+	MV_SWITCH_ATU_WALK	*walk = &switch_atu_resync_walk;
+	GT_ATU_ENTRY		entry;
+	MV_STATUS		status = MV_OK;
+	MV_BOOL			restart, wrapped = MV_FALSE;
+	MV_U32			i, db = 0, stale = 0;
+
+	/* the mirror was invalidated: read everything back from the first database */
+	spin_lock_irq(&switch_atu_mirror_lock);
+	restart = switch_atu_resync_restart;
+	switch_atu_resync_restart = MV_FALSE;
+	if (restart) {
+		switch_atu_mirror_gen++;
+		db = mvSwitchAtuResyncDb(0, &wrapped);
+	}
+	spin_unlock_irq(&switch_atu_mirror_lock);
+	if (restart)
+		mv_switch_atu_walk_start(walk, db, db);
+
+	for (i = 0; i < MV_SWITCH_ATU_RESYNC_BUDGET; i++) {
+		status = mv_switch_atu_walk_next(&qddev, walk, &entry);
+		if (status != MV_OK)
+			break;
+		mv_switch_atu_mirror_update(&entry);
+	}
+
+	/* end of a database pass: drop what the hardware no longer has */
+	if (status == MV_NO_SUCH)
+		stale = mvSwitchAtuMirrorFlush(MV_FALSE, walk->dbNum, MV_FALSE, -1, 0, MV_TRUE);
+
+	spin_lock_irq(&switch_atu_mirror_lock);
+	switch_atu_mirror_stats.resyncEntries += i;
+	if (status != MV_OK) {
+		if (status == MV_NO_SUCH)
+			switch_atu_mirror_stats.resyncStale += stale;
+		else
+			switch_atu_mirror_stats.resyncErrors++;
+
+		/* next database that ever held an entry; a wrap ends a pass over the set */
+		wrapped = MV_FALSE;
+		db = mvSwitchAtuResyncDb(walk->dbNum + 1, &wrapped);
+		if (wrapped)
+			switch_atu_mirror_stats.resyncPasses++;
+		switch_atu_mirror_gen++;
+	}
+	spin_unlock_irq(&switch_atu_mirror_lock);
+	if (status != MV_OK)
+		mv_switch_atu_walk_start(walk, db, db);
+
+	schedule_delayed_work(&switch_atu_resync_work, msecs_to_jiffies(MV_SWITCH_ATU_RESYNC_MS));
+}
+
+/*******************************************************************************
+* mvSwitchAtuMirrorInvalidate - Drop the mirror after a switch reset.
+*
+* DESCRIPTION:
+*       All entries are dropped, and the resync starts a new pass over the
+*       database set, which names every database that can hold entries.
+*       Lookups miss until the entries are read back.
+*
+*******************************************************************************/
+static void mvSwitchAtuMirrorInvalidate(void)
+{
+	unsigned long flags;
+
+	mvSwitchAtuMirrorFlush(MV_TRUE, 0, MV_FALSE, -1, 0, MV_FALSE);
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	switch_atu_resync_restart = MV_TRUE;
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+}
+
+int mv_switch_atu_mirror_show(char *buf)
+{
+	MV_SWITCH_ATU_MIRROR_STATS	s;
+	unsigned long			flags;
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	s = switch_atu_mirror_stats;
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+
+	return sprintf(buf, "atu mirror: entries %u hits %u misses %u hw probes %u dropped %u\n"
+		       "resync: db %u passes %u entries %u stale %u errors %u\n",
+		       s.entries, s.hits, s.misses, s.probes, s.dropped,
+		       switch_atu_resync_walk.dbNum, s.resyncPasses, s.resyncEntries,
+		       s.resyncStale, s.resyncErrors);
+}
+
+void mv_switch_atu_mirror_probe_count(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&switch_atu_mirror_lock, flags);
+	switch_atu_mirror_stats.probes++;
+	spin_unlock_irqrestore(&switch_atu_mirror_lock, flags);
+}
+
+/*******************************************************************************
+* ATU occupancy sampling
+*
+* Every MV_SWITCH_ATU_STATS_MS the ATU Stats counters (total and dynamic
+* entries) and the per-port learn counts are sampled into a ring of
+* MV_SWITCH_ATU_STATS_POINTS points, without walking the table.
+*******************************************************************************/
+static MV_SWITCH_ATU_SAMPLE	switch_atu_samples[MV_SWITCH_ATU_STATS_POINTS];
+static MV_U32			switch_atu_sample_count;	/* ever taken */
+static DEFINE_SPINLOCK(switch_atu_sample_lock);
+static struct delayed_work	switch_atu_stats_work;
+static MV_U32			switch_atu_near_full;		/* samples over the threshold */
+static MV_U32			switch_atu_stats_errors;
+
+static void mvSwitchAtuStatsWork(struct work_struct *work)
+{
+	MV_SWITCH_ATU_SAMPLE	sample;
+	MV_U32			count;
+	int			p;
+
+	memset(&sample, 0, sizeof(sample));
+	if (gfdbGetAtuAllCount(&qddev, &sample.all) != MV_OK ||
+	    gfdbGetAtuDynamicCount(&qddev, &sample.dynamic) != MV_OK) {
+		switch_atu_stats_errors++;
+		goto resched;
+	}
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		if (gfdbGetPortAtuLearnCnt(&qddev, p, &count) == MV_OK)
+			sample.learnCnt[p] = count;
+	sample.timeNs = ktime_to_ns(ktime_get());
+
+	if (sample.all * 100 >= MV_SWITCH_ATU_SIZE * MV_SWITCH_ATU_NEAR_FULL_PCT) {
+		switch_atu_near_full++;
+		printk_ratelimited(KERN_WARNING "mv_switch: ATU %u of %u entries in use\n",
+				   sample.all, MV_SWITCH_ATU_SIZE);
+	}
+
+	spin_lock_irq(&switch_atu_sample_lock);
+	switch_atu_samples[switch_atu_sample_count & (MV_SWITCH_ATU_STATS_POINTS - 1)] = sample;
+	switch_atu_sample_count++;
+	spin_unlock_irq(&switch_atu_sample_lock);
+
+resched:
+	schedule_delayed_work(&switch_atu_stats_work, msecs_to_jiffies(MV_SWITCH_ATU_STATS_MS));
+}
+
+/*******************************************************************************
+* mv_switch_atu_samples_get - Copy the latest ATU occupancy samples.
+*
+* OUTPUT:
+*       samples - up to max samples, oldest first.
+*
+* RETURN:
+*       Number of samples copied.
+*
+*******************************************************************************/
+MV_U32 mv_switch_atu_samples_get(MV_SWITCH_ATU_SAMPLE *samples, MV_U32 max)
+{
+	MV_U32 i, n, first;
+
+	spin_lock_irq(&switch_atu_sample_lock);
+	n = min_t(MV_U32, switch_atu_sample_count, MV_SWITCH_ATU_STATS_POINTS);
+	n = min_t(MV_U32, n, max);
+	first = switch_atu_sample_count - n;
+	for (i = 0; i < n; i++)
+		samples[i] = switch_atu_samples[(first + i) & (MV_SWITCH_ATU_STATS_POINTS - 1)];
+	spin_unlock_irq(&switch_atu_sample_lock);
+
+	return n;
+}
+
+int mv_switch_atu_stats_show(char *buf)
+{
+	static MV_SWITCH_ATU_SAMPLE	samples[MV_SWITCH_ATU_STATS_POINTS];
+	static DEFINE_MUTEX(show_lock);
+	MV_SWITCH_ATU_SAMPLE		*last;
+	MV_U32				i, n, db, count;
+	s64				ms;
+	int				off = 0, p;
+
+	mutex_lock(&show_lock);
+	n = mv_switch_atu_samples_get(samples, MV_SWITCH_ATU_STATS_POINTS);
+	if (n == 0) {
+		mutex_unlock(&show_lock);
+		return sprintf(buf, "no ATU samples yet\n");
+	}
+	last = &samples[n - 1];
+
+	off += sprintf(buf + off, "entries %u of %u (%u%%), dynamic %u, near full %u, errors %u\n",
+		       last->all, MV_SWITCH_ATU_SIZE, last->all * 100 / MV_SWITCH_ATU_SIZE,
+		       last->dynamic, switch_atu_near_full, switch_atu_stats_errors);
+
+	off += sprintf(buf + off, "learn count:");
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		off += sprintf(buf + off, " p%d %u", p, last->learnCnt[p]);
+	off += sprintf(buf + off, "\n");
+
+	/* net dynamic entries per second over the ring */
+	ms = div_s64(last->timeNs - samples[0].timeNs, NSEC_PER_MSEC);
+	if (n > 1 && ms > 0)
+		off += sprintf(buf + off, "dynamic change: %lld/s over %u samples\n",
+			       div_s64(((s64)last->dynamic - samples[0].dynamic) * MSEC_PER_SEC, ms), n);
+
+	off += sprintf(buf + off, "last samples (all/dynamic):");
+	for (i = (n > 16) ? n - 16 : 0; i < n; i++)
+		off += sprintf(buf + off, " %u/%u", samples[i].all, samples[i].dynamic);
+	off += sprintf(buf + off, "\n");
+	mutex_unlock(&show_lock);
+
+	/* per database, counted now */
+	off += sprintf(buf + off, "db (all/dynamic):");
+	for (i = 0, db = find_first_bit(switch_atu_mirror_dbs, MV_SWITCH_ATU_DB_MAX + 1);
+	     i < MV_SWITCH_ATU_STATS_DBS && db <= MV_SWITCH_ATU_DB_MAX;
+	     i++, db = find_next_bit(switch_atu_mirror_dbs, MV_SWITCH_ATU_DB_MAX + 1, db + 1)) {
+		if (gfdbGetAtuAllCountInDBNum(&qddev, db, &count) != MV_OK)
+			break;
+		off += sprintf(buf + off, " %u:%u", db, count);
+		if (gfdbGetAtuDynamicCountInDBNum(&qddev, db, &count) != MV_OK)
+			break;
+		off += sprintf(buf + off, "/%u", count);
+	}
+	off += sprintf(buf + off, "\n");
+
+	return off;
+}
+
+/*******************************************************************************
+* Adaptive ATU aging
+*
+* A table near full evicts nothing and floods unknown stations, so the
+* aging timeout is halved while the occupancy is at or above the high mark.
+* Entries aging out while the table has room only cause floods when their
+* stations talk again, so the timeout is doubled when entries aged out
+* during a period below the low mark, at most once every
+* MV_SWITCH_ATU_AGING_HOLD periods. The timeout stays in [min, max].
+* Age-outs are counted by the mirror resync: entries it finds gone from the
+* hardware without a driver operation (resyncStale) have aged out.
+*******************************************************************************/
+static MV_SWITCH_ATU_AGING_STATS	switch_atu_aging = {
+	.timeout	= MV_SWITCH_ATU_AGING_DEFAULT,
+	.min		= MV_SWITCH_ATU_AGING_MIN,
+	.max		= MV_SWITCH_ATU_AGING_MAX,
+	.enabled	= MV_TRUE,
+};
+static DEFINE_MUTEX(switch_atu_aging_lock);
+static struct delayed_work		switch_atu_aging_work;
+static MV_U32				switch_atu_aging_stale;		/* resyncStale at the last run */
+static MV_U32				switch_atu_aging_since;		/* periods since an increase */
+
+static void mvSwitchAtuAgingWork(struct work_struct *work)
+{
+	MV_SWITCH_ATU_AGING_STATS	*a = &switch_atu_aging;
+	MV_SWITCH_ATU_SAMPLE		sample;
+	MV_U32				timeout, ageOuts, stale;
+
+	mutex_lock(&switch_atu_aging_lock);
+	if (!a->enabled || mv_switch_atu_samples_get(&sample, 1) == 0)
+		goto out;
+
+	stale = ACCESS_ONCE(switch_atu_mirror_stats.resyncStale);
+	ageOuts = stale - switch_atu_aging_stale;
+	switch_atu_aging_stale = stale;
+	switch_atu_aging_since++;
+
+	a->runs++;
+	a->lastAll = sample.all;
+	a->lastAgeOuts = ageOuts;
+
+	timeout = a->timeout;
+	if (sample.all * 100 >= MV_SWITCH_ATU_SIZE * MV_SWITCH_ATU_AGING_HIGH_PCT) {
+		timeout = max_t(MV_U32, timeout / 2, a->min);
+		if (timeout == a->timeout)
+			a->held++;
+		else
+			a->shortened++;
+	} else if (sample.all * 100 < MV_SWITCH_ATU_SIZE * MV_SWITCH_ATU_AGING_LOW_PCT && ageOuts) {
+		if (switch_atu_aging_since >= MV_SWITCH_ATU_AGING_HOLD)
+			timeout = min_t(MV_U32, timeout * 2, a->max);
+		if (timeout == a->timeout) {
+			a->held++;
+		} else {
+			a->lengthened++;
+			switch_atu_aging_since = 0;
+		}
+	} else {
+		a->idle++;
+	}
+
+	if (timeout != a->timeout) {
+		if (gfdbSetAgingTimeout(&qddev, timeout) != MV_OK) {
+			a->errors++;
+			goto out;
+		}
+		printk(KERN_INFO "mv_switch: ATU aging %u -> %u s (entries %u, aged out %u)\n",
+		       a->timeout, timeout, sample.all, ageOuts);
+		a->timeout = timeout;
+	}
+out:
+	mutex_unlock(&switch_atu_aging_lock);
+	schedule_delayed_work(&switch_atu_aging_work, msecs_to_jiffies(MV_SWITCH_ATU_AGING_PERIOD_MS));
+}
+
+/*******************************************************************************
+* mv_switch_atu_aging_set - Set the bounds of the aging controller.
+*
+* INPUT:
+*       min, max - aging timeout bounds in seconds; min == 0 stops the
+*                  controller and restores MV_SWITCH_ATU_AGING_DEFAULT.
+*
+*******************************************************************************/
+int mv_switch_atu_aging_set(MV_U32 min, MV_U32 max)
+{
+	MV_SWITCH_ATU_AGING_STATS	*a = &switch_atu_aging;
+	MV_U32				hwMax, hwMin;
+	int				err = 0;
+
+	gfdbGetAgingTimeRange(&qddev, &hwMax, &hwMin);
+	if (min && (min < hwMin || max > hwMax || min > max))
+		return -EINVAL;
+
+	mutex_lock(&switch_atu_aging_lock);
+	a->enabled = min ? MV_TRUE : MV_FALSE;
+	if (min) {
+		a->min = min;
+		a->max = max;
+		a->timeout = clamp_t(MV_U32, a->timeout, min, max);
+	} else {
+		a->timeout = MV_SWITCH_ATU_AGING_DEFAULT;
+	}
+	if (gfdbSetAgingTimeout(&qddev, a->timeout) != MV_OK) {
+		a->errors++;
+		err = -EIO;
+	}
+	mutex_unlock(&switch_atu_aging_lock);
+
+	return err;
+}
+
+int mv_switch_atu_aging_show(char *buf)
+{
+	MV_SWITCH_ATU_AGING_STATS	*a = &switch_atu_aging;
+	MV_U32				hw = 0;
+
+	gfdbGetAgingTimeout(&qddev, &hw);
+
+	return sprintf(buf, "aging: %s, timeout %u s (hw %u s), bounds %u..%u s\n"
+		       "decisions: runs %u shortened %u lengthened %u held %u idle %u errors %u\n"
+		       "last: entries %u, aged out %u\n",
+		       a->enabled ? "adaptive" : "fixed", a->timeout, hw, a->min, a->max,
+		       a->runs, a->shortened, a->lengthened, a->held, a->idle, a->errors,
+		       a->lastAll, a->lastAgeOuts);
+}
+
+/*******************************************************************************
+* ATU microbenchmark
+*
+* Runs the ATU paths against the software register model (switch_sim=1)
+* with a configurable cost per SMI transaction, in a database of its own:
+* single entry loads, the GetNext walk of the loaded entries, flushes of
+* the database and bulk loads of MV_SWITCH_ATU_LOAD_CHUNK entries. The
+* background ATU works are stopped meanwhile so that the transaction
+* counts belong to the benchmark. The report of the last run is kept for
+* mv_switch_atu_bench_show().
+*******************************************************************************/
+static DEFINE_MUTEX(switch_atu_bench_lock);
+static char	switch_atu_bench_report[MV_SWITCH_BENCH_REPORT_SIZE];
+static int	switch_atu_bench_len;
+
+enum {
+	ATU_BENCH_LOAD,
+	ATU_BENCH_WALK,
+	ATU_BENCH_FLUSH,
+	ATU_BENCH_BULK,
+	ATU_BENCH_PHASES
+};
+
+static const char *atu_bench_names[ATU_BENCH_PHASES] = { "load", "walk", "flush", "bulk" };
+
+struct mv_switch_atu_bench {
+	MV_U32		ops;
+	MV_U32		failed;
+	MV_U32		smi;	/* model register transactions */
+	s64		ns;
+	MV_U32		*lat;	/* ns, one per operation */
+};
+
+static MV_U32 mvSwitchAtuBenchSmi(void)
+{
+	MV_SWITCH_SIM_STATS s;
+
+	mv_switch_sim_stats_get(&s);
+	return s.reads + s.writes;
+}
+
+static void mvSwitchAtuBenchAdd(struct mv_switch_atu_bench *b, ktime_t start, MV_U32 smi, MV_STATUS status)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	b->lat[b->ops++] = (MV_U32)min_t(s64, ns, 0xFFFFFFFF);
+	b->ns += ns;
+	b->smi += mvSwitchAtuBenchSmi() - smi;
+	if (status != MV_OK)
+		b->failed++;
+}
+
+static int mvSwitchAtuBenchCmp(const void *a, const void *b)
+{
+	MV_U32 x = *(const MV_U32 *)a, y = *(const MV_U32 *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int mvSwitchAtuBenchReport(char *buf, const char *name, struct mv_switch_atu_bench *b)
+{
+	MV_U32 smi100;
+
+	if (b->ops == 0)
+		return 0;
+
+	sort(b->lat, b->ops, sizeof(MV_U32), mvSwitchAtuBenchCmp, NULL);
+	smi100 = (MV_U32)div_u64((u64)b->smi * 100, b->ops);
+
+	return sprintf(buf, "atu bench %-5s: %6u ops in %lld us, %lld ops/s, %u.%02u SMI/op, p50 %u ns p99 %u ns, failed %u\n",
+		       name, b->ops, div_s64(b->ns, 1000), b->ns ? div_s64((s64)b->ops * NSEC_PER_SEC, b->ns) : 0,
+		       smi100 / 100, smi100 % 100, b->lat[(b->ops - 1) / 2], b->lat[(b->ops - 1) * 99 / 100], b->failed);
+}
+
+/*******************************************************************************
+* mv_switch_atu_bench - Measure the ATU paths over the register model.
+*
+* INPUT:
+*       entries   - test entries per round, up to MV_SWITCH_ATU_BENCH_ENTRIES.
+*       rounds    - rounds, up to MV_SWITCH_ATU_BENCH_ROUNDS.
+*       latencyNs - SMI transaction cost to model, reset to 0 afterwards.
+*
+* DESCRIPTION:
+*       Reports, per operation kind, the throughput, the SMI transactions
+*       per operation and the p50/p99 operation latency; read the report
+*       with mv_switch_atu_bench_show().
+*
+*******************************************************************************/
+int mv_switch_atu_bench(int entries, int rounds, int latencyNs)
+{
+	struct mv_switch_atu_bench	bench[ATU_BENCH_PHASES];
+	MV_U32				max[ATU_BENCH_PHASES];
+	GT_ATU_ENTRY			*atu, entry;
+	MV_STATUS			status;
+	ktime_t				start;
+	MV_U32				smi;
+	int				i, r, n, ph, err = 0;
+
+	if (qddev.fgtReadMii != mv_switch_sim_read_mii)
+		return -ENODEV;
+	if (entries <= 0 || entries > MV_SWITCH_ATU_BENCH_ENTRIES ||
+	    rounds <= 0 || rounds > MV_SWITCH_ATU_BENCH_ROUNDS ||
+	    latencyNs < 0 || mv_switch_sim_latency_set(latencyNs))
+		return -EINVAL;
+
+	max[ATU_BENCH_LOAD] = entries * rounds;
+	max[ATU_BENCH_WALK] = (entries + 1) * rounds;
+	max[ATU_BENCH_FLUSH] = 2 * rounds;
+	max[ATU_BENCH_BULK] = DIV_ROUND_UP(entries, MV_SWITCH_ATU_LOAD_CHUNK) * rounds;
+
+	memset(bench, 0, sizeof(bench));
+	atu = kcalloc(entries, sizeof(GT_ATU_ENTRY), GFP_KERNEL);
+	for (ph = 0; ph < ATU_BENCH_PHASES; ph++)
+		bench[ph].lat = vmalloc(max[ph] * sizeof(MV_U32));
+	for (ph = 0; ph < ATU_BENCH_PHASES; ph++)
+		if (bench[ph].lat == NULL)
+			err = -ENOMEM;
+	if (atu == NULL || err)
+		goto out_free;
+
+	/* locally administered unicast addresses, static so they never age */
+	for (i = 0; i < entries; i++) {
+		atu[i].macAddr[0] = 0x02;
+		atu[i].macAddr[4] = (MV_U8)(i >> 8);
+		atu[i].macAddr[5] = (MV_U8)i;
+		atu[i].DBNum = MV_SWITCH_ATU_BENCH_DB;
+		atu[i].portVec = 1 << (i % MAX_SWITCH_PORT_NUM);
+		atu[i].entryState.ucEntryState = GT_UC_NO_PRI_STATIC;
+	}
+
+	mutex_lock(&switch_atu_bench_lock);
+	cancel_delayed_work_sync(&switch_atu_resync_work);
+	cancel_delayed_work_sync(&switch_atu_stats_work);
+	cancel_delayed_work_sync(&switch_atu_aging_work);
+
+	gfdbFlushInDB(&qddev, GT_FLUSH_ALL, MV_SWITCH_ATU_BENCH_DB);
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < entries; i++) {
+			start = ktime_get();
+			smi = mvSwitchAtuBenchSmi();
+			status = gfdbLoadAtuEntries(&qddev, &atu[i], 1, NULL);
+			mvSwitchAtuBenchAdd(&bench[ATU_BENCH_LOAD], start, smi, status);
+		}
+
+		memset(entry.macAddr, 0xFF, sizeof(entry.macAddr));
+		entry.DBNum = MV_SWITCH_ATU_BENCH_DB;
+		for (i = 0; i <= entries; i++) {
+			start = ktime_get();
+			smi = mvSwitchAtuBenchSmi();
+			status = gfdbGetAtuEntryNext(&qddev, &entry);
+			mvSwitchAtuBenchAdd(&bench[ATU_BENCH_WALK], start, smi,
+					    (status == MV_NO_SUCH) ? MV_OK : status);
+			if (status != MV_OK)
+				break;
+		}
+
+		start = ktime_get();
+		smi = mvSwitchAtuBenchSmi();
+		status = gfdbFlushInDB(&qddev, GT_FLUSH_ALL, MV_SWITCH_ATU_BENCH_DB);
+		mvSwitchAtuBenchAdd(&bench[ATU_BENCH_FLUSH], start, smi, status);
+
+		for (i = 0; i < entries; i += n) {
+			n = min_t(int, entries - i, MV_SWITCH_ATU_LOAD_CHUNK);
+			start = ktime_get();
+			smi = mvSwitchAtuBenchSmi();
+			status = gfdbLoadAtuEntries(&qddev, &atu[i], n, NULL);
+			mvSwitchAtuBenchAdd(&bench[ATU_BENCH_BULK], start, smi, status);
+		}
+
+		start = ktime_get();
+		smi = mvSwitchAtuBenchSmi();
+		status = gfdbFlushInDB(&qddev, GT_FLUSH_ALL, MV_SWITCH_ATU_BENCH_DB);
+		mvSwitchAtuBenchAdd(&bench[ATU_BENCH_FLUSH], start, smi, status);
+	}
+
+	schedule_delayed_work(&switch_atu_resync_work, msecs_to_jiffies(MV_SWITCH_ATU_RESYNC_MS));
+	schedule_delayed_work(&switch_atu_stats_work, msecs_to_jiffies(MV_SWITCH_ATU_STATS_MS));
+	schedule_delayed_work(&switch_atu_aging_work, msecs_to_jiffies(MV_SWITCH_ATU_AGING_PERIOD_MS));
+
+	n = sprintf(switch_atu_bench_report, "atu bench: %d entries, %d rounds, %d ns/SMI transaction\n",
+		    entries, rounds, latencyNs);
+	for (ph = 0; ph < ATU_BENCH_PHASES; ph++) {
+		n += mvSwitchAtuBenchReport(switch_atu_bench_report + n, atu_bench_names[ph], &bench[ph]);
+		if (bench[ph].failed)
+			err = -EIO;
+	}
+	switch_atu_bench_len = n;
+	mutex_unlock(&switch_atu_bench_lock);
+
+out_free:
+	mv_switch_sim_latency_set(0);
+	for (ph = 0; ph < ATU_BENCH_PHASES; ph++)
+		vfree(bench[ph].lat);
+	kfree(atu);
+
+	return err;
+}
+
+/* Report of the last mv_switch_atu_bench() run */
+int mv_switch_atu_bench_show(char *buf)
+{
+	int len;
+
+	mutex_lock(&switch_atu_bench_lock);
+	len = switch_atu_bench_len;
+	memcpy(buf, switch_atu_bench_report, len);
+	mutex_unlock(&switch_atu_bench_lock);
+
+	return len;
+}
+
+int mv_switch_atu_init(void)
+{
+	static MV_BOOL done;
+
+	if (done)
+		return 0;
+
+	if (!proc_create("mv_switch_atu", S_IRUSR | S_IWUSR, NULL, &mv_switch_atu_proc_fops)) {
+		printk(KERN_ERR "%s: failed to create /proc/mv_switch_atu\n", __func__);
+		return -ENOMEM;
+	}
+
+	__set_bit(0, switch_atu_mirror_dbs);
+	mv_switch_atu_walk_start(&switch_atu_resync_walk, 0, 0);
+	INIT_DELAYED_WORK(&switch_atu_resync_work, mvSwitchAtuResyncWork);
+	schedule_delayed_work(&switch_atu_resync_work, msecs_to_jiffies(MV_SWITCH_ATU_RESYNC_MS));
+	INIT_DELAYED_WORK(&switch_atu_stats_work, mvSwitchAtuStatsWork);
+	schedule_delayed_work(&switch_atu_stats_work, msecs_to_jiffies(MV_SWITCH_ATU_STATS_MS));
+
+	if (gfdbSetAgingTimeout(&qddev, switch_atu_aging.timeout) != MV_OK)
+		printk(KERN_ERR "%s: failed to set the ATU aging timeout\n", __func__);
+	INIT_DELAYED_WORK(&switch_atu_aging_work, mvSwitchAtuAgingWork);
+	schedule_delayed_work(&switch_atu_aging_work, msecs_to_jiffies(MV_SWITCH_ATU_AGING_PERIOD_MS));
+	done = MV_TRUE;
+
+	return 0;
+}
+
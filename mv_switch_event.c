@@ -0,0 +1,487 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+
+/*
+ * ATU violation events.
+ *
+ * The ATU problem interrupt (Global 1 status bit 3) is serviced in the
+ * thread of a threaded IRQ, or by a periodic work while no interrupt line
+ * was given with mv_switch_atu_irq_init(). The line is requested exclusive
+ * and IRQF_ONESHOT, so every interrupt on it is the switch's and is handled,
+ * ATU problem or not. Every pending violation is read
+ * with SERVICE_VIOLATIONS, checked against the ATU mirror, and queued as an
+ * MV_SWITCH_ATU_EVENT in a single producer / single consumer ring, read
+ * without a lock from /dev/mv_switch_atu_events (blocking or poll()).
+ *
+ * Age violations (an age refresh of an entry on a locked port) are queued
+ * like the others. Dynamic entries that aged out are found by the mirror
+ * resync, which queues them as GT_AGE_OUT_VIOLATION events with
+ * mv_switch_atu_event_age_out(). A member or miss
+ * violation from a port other than the mirrored one is flagged as a MAC
+ * move, one from a port that reached its learn limit as an over-limit
+ * event. MV_SWITCH_ATU_STORM_FULL full violations within
+ * MV_SWITCH_ATU_STORM_WINDOW_MS flag an ATU-full storm.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/interrupt.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/miscdevice.h>
+#include <linux/ktime.h>
+#include <asm/uaccess.h>
+
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "dsdt/msApiPrototype.h"
+#include "mv_switch.h"
+
+extern GT_QD_DEV qddev;
+
+/* Ring: head is only written by the producer, tail only by the reader */
+static MV_SWITCH_ATU_EVENT	switch_atu_events[MV_SWITCH_ATU_EVENT_RING];
+static MV_U32			switch_atu_event_head;
+static MV_U32			switch_atu_event_tail;
+static DECLARE_WAIT_QUEUE_HEAD(switch_atu_event_wait);
+static DEFINE_MUTEX(switch_atu_event_read_lock);
+
+static DEFINE_MUTEX(switch_atu_service_lock);	/* one producer at a time */
+static MV_SWITCH_ATU_EVENT_STATS	switch_atu_event_stats;
+static s64				switch_atu_storm_start;
+static MV_U32				switch_atu_storm_full;
+
+static int				switch_atu_irq = -1;
+static MV_U32				switch_learn_limit[MAX_SWITCH_PORT_NUM];
+static struct delayed_work		switch_atu_poll_work;
+
+static void mvSwitchAtuEventPut(MV_SWITCH_ATU_EVENT *ev)
+{
+	MV_U32 head = switch_atu_event_head;
+
+	if (head - ACCESS_ONCE(switch_atu_event_tail) >= MV_SWITCH_ATU_EVENT_RING) {
+		switch_atu_event_stats.dropped++;
+		return;
+	}
+
+	switch_atu_events[head & (MV_SWITCH_ATU_EVENT_RING - 1)] = *ev;
+	/* publish the record before the index */
+	smp_wmb();
+	switch_atu_event_head = head + 1;
+	wake_up_interruptible(&switch_atu_event_wait);
+}
+
+/* Full violation storm detection, see MV_SWITCH_ATU_STORM_FULL */
+static MV_BOOL mvSwitchAtuStorm(s64 now)
+{
+	if (now - switch_atu_storm_start > (s64)MV_SWITCH_ATU_STORM_WINDOW_MS * NSEC_PER_MSEC) {
+		switch_atu_storm_start = now;
+		switch_atu_storm_full = 0;
+	}
+
+	return (++switch_atu_storm_full == MV_SWITCH_ATU_STORM_FULL) ? MV_TRUE : MV_FALSE;
+}
+
+static void mvSwitchAtuEventDecode(MV_U32 cause, GT_ATU_ENTRY *entry, MV_SWITCH_ATU_EVENT *ev)
+{
+	MV_SWITCH_ATU_EVENT_STATS	*s = &switch_atu_event_stats;
+	int				port;
+
+	memset(ev, 0, sizeof(*ev));
+	ev->timeNs = ktime_to_ns(ktime_get());
+	ev->cause = cause;
+	ev->port = entry->entryState.ucEntryState & 0xF;
+	ev->oldPort = 0xF;
+	ev->DBNum = entry->DBNum;
+	memcpy(ev->macAddr, entry->macAddr, 6);
+
+	switch (cause) {
+	case GT_AGE_VIOLATION:
+		/* an age refresh on a locked port, the entry stays in the ATU */
+		s->age++;
+		break;
+
+	case GT_MEMBER_VIOLATION:
+	case GT_MISS_VIOLATION:
+		if (cause == GT_MEMBER_VIOLATION) {
+			s->member++;
+		} else {
+			s->miss++;
+			/* the over limit interrupt comes as a miss violation */
+			if (ev->port < MAX_SWITCH_PORT_NUM && switch_learn_limit[ev->port]) {
+				ev->flags |= MV_SWITCH_ATU_EVENT_OVER_LIMIT;
+				s->overLimit[ev->port]++;
+			}
+		}
+		port = mv_switch_atu_mac_port(entry->DBNum, entry->macAddr);
+		if (port >= 0 && port != ev->port) {
+			ev->flags |= MV_SWITCH_ATU_EVENT_MOVE;
+			ev->oldPort = port;
+			s->moves++;
+		}
+		break;
+
+	case GT_FULL_VIOLATION:
+		s->full++;
+		ev->port = 0xF;
+		if (mvSwitchAtuStorm(ev->timeNs)) {
+			ev->flags |= MV_SWITCH_ATU_EVENT_STORM;
+			s->storms++;
+			printk_ratelimited(KERN_WARNING "mv_switch: ATU full violation storm (%d in %d ms)\n",
+					   MV_SWITCH_ATU_STORM_FULL, MV_SWITCH_ATU_STORM_WINDOW_MS);
+		}
+		break;
+	}
+}
+
+/*******************************************************************************
+* mvSwitchAtuService - Drain the pending ATU violations.
+*
+* RETURN:
+*       Number of violations serviced, at most MV_SWITCH_ATU_EVENT_BUDGET so
+*       that a storm does not hold the ATU; the rest keeps the interrupt
+*       asserted (or is found by the next poll).
+*
+*******************************************************************************/
+static int mvSwitchAtuService(void)
+{
+	MV_SWITCH_ATU_EVENT	ev;
+	GT_ATU_ENTRY		entry;
+	MV_U32			cause;
+	int			n;
+
+	mutex_lock(&switch_atu_service_lock);
+	for (n = 0; n < MV_SWITCH_ATU_EVENT_BUDGET; n++) {
+		if (gatuGetViolation(&qddev, &cause, &entry) != MV_OK) {
+			switch_atu_event_stats.errors++;
+			break;
+		}
+		if (cause == 0)
+			break;
+		mvSwitchAtuEventDecode(cause, &entry, &ev);
+		mvSwitchAtuEventPut(&ev);
+	}
+	mutex_unlock(&switch_atu_service_lock);
+
+	return n;
+}
+
+static MV_BOOL mvSwitchAtuProblem(void)
+{
+	unsigned int status;
+
+	if (mv_switch_mii_read(0x1b, QD_REG_GLOBAL_STATUS, &status) != MV_OK)
+		return MV_FALSE;
+
+	return (status & (1 << MV_SWITCH_G1_ATU_PROB_BIT)) ? MV_TRUE : MV_FALSE;
+}
+
+static irqreturn_t mv_switch_atu_irq_thread(int irq, void *dev_id)
+{
+	/* the line is not shared: another switch source is still ours */
+	switch_atu_event_stats.interrupts++;
+	if (mvSwitchAtuProblem())
+		mvSwitchAtuService();
+
+	return IRQ_HANDLED;
+}
+
+static void mvSwitchAtuPollWork(struct work_struct *work)
+{
+	if (mvSwitchAtuProblem()) {
+		switch_atu_event_stats.polls++;
+		mvSwitchAtuService();
+	}
+
+	if (switch_atu_irq < 0)
+		schedule_delayed_work(&switch_atu_poll_work, msecs_to_jiffies(MV_SWITCH_ATU_EVENT_POLL_MS));
+}
+
+/*
+ * /dev/mv_switch_atu_events: read() returns whole MV_SWITCH_ATU_EVENT
+ * records, blocking until one is queued unless O_NONBLOCK.
+ */
+static ssize_t mvSwitchAtuEventRead(struct file *file, char __user *buf, size_t len, loff_t *ppos)
+{
+	MV_SWITCH_ATU_EVENT	*ev;
+	MV_U32			tail;
+	ssize_t			done = 0;
+	int			err;
+
+	if (len < sizeof(MV_SWITCH_ATU_EVENT))
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&switch_atu_event_read_lock))
+		return -ERESTARTSYS;
+
+	tail = switch_atu_event_tail;
+	while (ACCESS_ONCE(switch_atu_event_head) == tail) {
+		mutex_unlock(&switch_atu_event_read_lock);
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		err = wait_event_interruptible(switch_atu_event_wait,
+					       ACCESS_ONCE(switch_atu_event_head) != switch_atu_event_tail);
+		if (err)
+			return err;
+		if (mutex_lock_interruptible(&switch_atu_event_read_lock))
+			return -ERESTARTSYS;
+		tail = switch_atu_event_tail;
+	}
+	/* read the records only after their index */
+	smp_rmb();
+
+	while (tail != ACCESS_ONCE(switch_atu_event_head) && len - done >= sizeof(MV_SWITCH_ATU_EVENT)) {
+		ev = &switch_atu_events[tail & (MV_SWITCH_ATU_EVENT_RING - 1)];
+		if (copy_to_user(buf + done, ev, sizeof(MV_SWITCH_ATU_EVENT))) {
+			if (done == 0)
+				done = -EFAULT;
+			break;
+		}
+		done += sizeof(MV_SWITCH_ATU_EVENT);
+		tail++;
+	}
+	/* the records are copied before the producer may reuse them */
+	smp_mb();
+	switch_atu_event_tail = tail;
+	mutex_unlock(&switch_atu_event_read_lock);
+
+	return done;
+}
+
+static unsigned int mvSwitchAtuEventPoll(struct file *file, poll_table *wait)
+{
+	poll_wait(file, &switch_atu_event_wait, wait);
+
+	if (ACCESS_ONCE(switch_atu_event_head) != ACCESS_ONCE(switch_atu_event_tail))
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations mv_switch_atu_event_fops = {
+	.owner		= THIS_MODULE,
+	.open		= nonseekable_open,
+	.read		= mvSwitchAtuEventRead,
+	.poll		= mvSwitchAtuEventPoll,
+	.llseek		= no_llseek,
+};
+
+static struct miscdevice mv_switch_atu_event_dev = {
+	.minor		= MISC_DYNAMIC_MINOR,
+	.name		= "mv_switch_atu_events",
+	.fops		= &mv_switch_atu_event_fops,
+};
+
+/*******************************************************************************
+* mv_switch_atu_event_init - Enable ATU violation events.
+*
+* DESCRIPTION:
+*       Registers /dev/mv_switch_atu_events, enables the ATU problem
+*       interrupt in the switch and starts servicing it by polling the
+*       Global 1 status until mv_switch_atu_irq_init() is called.
+*
+*******************************************************************************/
+int mv_switch_atu_event_init(void)
+{
+	static MV_BOOL	done;
+	int		err;
+
+	if (done)
+		return 0;
+
+	err = misc_register(&mv_switch_atu_event_dev);
+	if (err) {
+		printk(KERN_ERR "%s: failed to register /dev/%s, err=%d\n",
+		       __func__, mv_switch_atu_event_dev.name, err);
+		return err;
+	}
+
+	if (mv_switch_mii_write_RegField(0x1b, QD_REG_GLOBAL_CONTROL, MV_SWITCH_G1_ATU_PROB_BIT, 1, 1) != MV_OK)
+		printk(KERN_ERR "%s: failed to enable the ATU interrupt\n", __func__);
+
+	INIT_DELAYED_WORK(&switch_atu_poll_work, mvSwitchAtuPollWork);
+	schedule_delayed_work(&switch_atu_poll_work, msecs_to_jiffies(MV_SWITCH_ATU_EVENT_POLL_MS));
+	done = MV_TRUE;
+
+	return 0;
+}
+
+/*******************************************************************************
+* mv_switch_atu_irq_init - Service ATU violations from the switch interrupt.
+*
+* INPUT:
+*       irq - interrupt line of the switch INTn output (level, active low).
+*
+* RETURN:
+*       0 on success, negative errno otherwise (polling goes on then).
+*
+*******************************************************************************/
+int mv_switch_atu_irq_init(int irq)
+{
+	int err;
+
+	if (switch_atu_irq >= 0)
+		return -EBUSY;
+
+	err = request_threaded_irq(irq, NULL, mv_switch_atu_irq_thread,
+				   IRQF_ONESHOT | IRQF_TRIGGER_LOW, "mv_switch_atu", &mv_switch_atu_event_dev);
+	if (err) {
+		printk(KERN_ERR "%s: request_threaded_irq(%d) failed, err=%d. Polling ATU violations\n",
+		       __func__, irq, err);
+		return err;
+	}
+
+	/* the poll work does not rearm itself any more */
+	switch_atu_irq = irq;
+	cancel_delayed_work_sync(&switch_atu_poll_work);
+
+	return 0;
+}
+
+void mv_switch_atu_event_stats_get(MV_SWITCH_ATU_EVENT_STATS *stats)
+{
+	*stats = switch_atu_event_stats;
+}
+
+/*******************************************************************************
+* mv_switch_atu_event_age_out - Queue the age out of a dynamic entry.
+*
+* DESCRIPTION:
+*       Called by the mirror resync for a dynamic entry the hardware no
+*       longer holds. Process context only: it shares the producer side of
+*       the ring with the violation service.
+*
+*******************************************************************************/
+void mv_switch_atu_event_age_out(MV_U16 dbNum, const MV_U8 *mac, MV_U32 portVec)
+{
+	MV_SWITCH_ATU_EVENT ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.timeNs = ktime_to_ns(ktime_get());
+	ev.cause = GT_AGE_OUT_VIOLATION;
+	ev.port = portVec ? (ffs(portVec) - 1) : 0xF;
+	ev.oldPort = 0xF;
+	ev.DBNum = dbNum;
+	memcpy(ev.macAddr, mac, 6);
+
+	mutex_lock(&switch_atu_service_lock);
+	switch_atu_event_stats.ageOut++;
+	mvSwitchAtuEventPut(&ev);
+	mutex_unlock(&switch_atu_service_lock);
+}
+
+int mv_switch_atu_event_show(char *buf)
+{
+	MV_SWITCH_ATU_EVENT_STATS	*s = &switch_atu_event_stats;
+	int				off = 0, p;
+
+	off += sprintf(buf + off, "mode: %s", (switch_atu_irq >= 0) ? "irq" : "poll");
+	if (switch_atu_irq >= 0)
+		off += sprintf(buf + off, " %d", switch_atu_irq);
+	off += sprintf(buf + off, ", interrupts %u polls %u\n", s->interrupts, s->polls);
+	off += sprintf(buf + off, "violations: age %u member %u miss %u full %u errors %u, age out %u\n",
+		       s->age, s->member, s->miss, s->full, s->errors, s->ageOut);
+	off += sprintf(buf + off, "moves %u storms %u\n", s->moves, s->storms);
+	off += sprintf(buf + off, "over limit:");
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		off += sprintf(buf + off, " p%d %u", p, s->overLimit[p]);
+	off += sprintf(buf + off, "\n");
+	off += sprintf(buf + off, "ring: queued %u dropped %u\n",
+		       switch_atu_event_head - switch_atu_event_tail, s->dropped);
+
+	return off;
+}
+
+/*******************************************************************************
+* mv_switch_port_learn_limit_set - Limit the addresses a port may learn.
+*
+* DESCRIPTION:
+*       Follows the sequence required by gfdbSetPortAtuLearnLimit: learning
+*       is stopped on the port (zero Port Association Vector), its dynamic
+*       entries are removed, the limit is set and learning is restored. The
+*       over limit interrupt is enabled with a non-zero limit, so a port
+*       flooding source addresses shows up as over-limit events instead of
+*       evicting the entries of the other ports.
+*
+* INPUT:
+*       port  - switch port.
+*       limit - 1..255, or 0 for no limit.
+*
+*******************************************************************************/
+int mv_switch_port_learn_limit_set(int port, MV_U32 limit)
+{
+	unsigned int	pav;
+	MV_U32		smiAddr;
+	MV_STATUS	status;
+
+	if (port < 0 || port >= MAX_SWITCH_PORT_NUM || limit > 0xFF)
+		return -EINVAL;
+
+	smiAddr = CALC_SMI_DEV_ADDR(&qddev, port, PORT_ACCESS);
+	if (mv_switch_mii_read(smiAddr, QD_REG_PAV, &pav) != MV_OK)
+		return -EIO;
+
+	status = mv_switch_mii_write_RegField(smiAddr, QD_REG_PAV, 0, MAX_SWITCH_PORT_NUM, 0);
+	if (status == MV_OK)
+		status = gfdbRemovePort(&qddev, GT_MOVE_ALL_UNLOCKED, port);
+	if (status == MV_OK)
+		status = gfdbSetPortAtuLearnLimit(&qddev, port, limit);
+	if (status == MV_OK)
+		status = geventSetOverLimitInt(&qddev, port, limit ? MV_TRUE : MV_FALSE);
+	/* learning back on in any case */
+	if (mv_switch_mii_write_RegField(smiAddr, QD_REG_PAV, 0, MAX_SWITCH_PORT_NUM,
+					 pav & ((1 << MAX_SWITCH_PORT_NUM) - 1)) != MV_OK)
+		status = MV_FAIL;
+
+	if (status != MV_OK) {
+		printk(KERN_ERR "%s: port %d limit %u failed (%d)\n", __func__, port, limit, status);
+		return -EIO;
+	}
+	switch_learn_limit[port] = limit;
+
+	return 0;
+}
+
+int mv_switch_port_learn_limit_show(int port, char *buf)
+{
+	MV_U32	limit = 0, count = 0;
+	MV_BOOL	reached = MV_FALSE;
+
+	if (port < 0 || port >= MAX_SWITCH_PORT_NUM)
+		return sprintf(buf, "n/a\n");
+
+	if (gfdbGetPortAtuLearnLimit(&qddev, port, &limit) != MV_OK ||
+	    gfdbGetPortAtuLearnCnt(&qddev, port, &count) != MV_OK ||
+	    geventGetPortAtuLimitReached(&qddev, port, &reached) != MV_OK)
+		return -EIO;
+
+	return sprintf(buf, "limit %u count %u reached %d over limit events %u\n",
+		       limit, count, reached == MV_TRUE, switch_atu_event_stats.overLimit[port]);
+}
@@ -0,0 +1,120 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+/*
+ * Command path of the cross chip port VLAN table (PVT): the busy wait and
+ * the counters of pvtOperationRun() and gpvtLoadPVTMatrix() in
+ * mv_switch_api.c, next to the ATU (mv_switch_atu.c) engine accounting.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/spinlock.h>
+#include <linux/ktime.h>
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "dsdt/msApiPrototype.h"
+#include "mv_switch.h"
+
+/*******************************************************************************
+* PVT command path
+*
+* pvtOperationRun() samples the PVT busy bit with a read that rides along
+* with the access before it, and only enters the bounded wait below when the
+* bit is found set; bulk loads poll it inside their register lists. Callers
+* hold tblRegsSem; the counters are under switch_pvt_cmd_lock.
+*******************************************************************************/
+static MV_SWITCH_PVT_STATS	switch_pvt_stats;
+static DEFINE_SPINLOCK(switch_pvt_cmd_lock);
+
+/*******************************************************************************
+* mv_switch_pvt_cmd_wait - Wait until the PVT is idle.
+*
+* RETURN:
+*       MV_OK, MV_NOT_READY when the register poll deadline passed, or the
+*       SMI error.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_pvt_cmd_wait(GT_QD_DEV *dev)
+{
+	HW_DEV_RW_REG	wait = {
+		.cmd	= HW_REG_WAIT_TILL_0,
+		.addr	= 0x1c,
+		.reg	= QD_REG_PVT_ADDR,
+		.data	= 15,
+	};
+	ktime_t		start = ktime_get();
+	MV_STATUS	status;
+	MV_U32		us;
+
+	status = mv_switch_dev_rw_reg_list(dev, &wait, 1, NULL);
+
+	us = (MV_U32)ktime_us_delta(ktime_get(), start);
+	spin_lock(&switch_pvt_cmd_lock);
+	switch_pvt_stats.retries++;
+	switch_pvt_stats.waitUs += us;
+	if (us > switch_pvt_stats.maxWaitUs)
+		switch_pvt_stats.maxWaitUs = us;
+	spin_unlock(&switch_pvt_cmd_lock);
+
+	return status;
+}
+
+/* Account 'ops' PVT operations that ended with 'status' */
+void mv_switch_pvt_cmd_done(MV_U32 ops, MV_STATUS status)
+{
+	spin_lock(&switch_pvt_cmd_lock);
+	switch_pvt_stats.ops += ops;
+	if (status == MV_NOT_READY)
+		switch_pvt_stats.timeouts++;
+	else if (status != MV_OK)
+		switch_pvt_stats.errors++;
+	spin_unlock(&switch_pvt_cmd_lock);
+}
+
+/* Account a bulk register list of 'ops' PVT writes that took 'us' */
+void mv_switch_pvt_list_done(MV_U32 ops, MV_STATUS status, MV_U32 us)
+{
+	spin_lock(&switch_pvt_cmd_lock);
+	switch_pvt_stats.lists++;
+	if (us > switch_pvt_stats.maxListUs)
+		switch_pvt_stats.maxListUs = us;
+	spin_unlock(&switch_pvt_cmd_lock);
+	mv_switch_pvt_cmd_done(ops, status);
+}
+
+int mv_switch_pvt_show(char *buf)
+{
+	MV_SWITCH_PVT_STATS s;
+
+	spin_lock(&switch_pvt_cmd_lock);
+	s = switch_pvt_stats;
+	spin_unlock(&switch_pvt_cmd_lock);
+
+	return sprintf(buf, "pvt: ops %u retries %u timeouts %u errors %u, waited %u us (max %u us), bulk lists %u (max %u us)\n",
+		       s.ops, s.retries, s.timeouts, s.errors, s.waitUs, s.maxWaitUs,
+		       s.lists, s.maxListUs);
+}
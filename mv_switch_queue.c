@@ -0,0 +1,470 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+
+/*
+ * Asynchronous register operation queue.
+ *
+ * mv_switch_op_submit() queues a register list and returns at once, from
+ * any context. A single-threaded workqueue drains the queue in submission
+ * order: consecutive operations are concatenated into one register list of
+ * up to MV_SWITCH_BATCH_MAX_OPS entries and executed with one
+ * mv_switch_rw_reg_list() call, i.e. one switch_lock hold (or one RMU
+ * frame). Every operation then gets its own status and done() callback.
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/completion.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
+
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "mv_switch.h"
+
+static struct workqueue_struct	*switch_queue_wq;
+static struct work_struct	switch_queue_work;
+static LIST_HEAD(switch_queue);
+static DEFINE_SPINLOCK(switch_queue_lock);	/* switch_queue and stats */
+static MV_SWITCH_QUEUE_STATS	switch_queue_stats;
+
+/* Staging list of the worker */
+static HW_DEV_RW_REG		switch_queue_list[MV_SWITCH_BATCH_MAX_OPS];
+
+static void mvSwitchQueueComplete(MV_SWITCH_OP *op, MV_STATUS status)
+{
+	unsigned long	flags;
+	s64		us = ktime_us_delta(ktime_get(), op->submitted);
+	MV_U32		bucket = (us > 0) ? fls64(us) : 0;
+
+	if (bucket >= MV_SWITCH_SMI_HIST_BUCKETS)
+		bucket = MV_SWITCH_SMI_HIST_BUCKETS - 1;
+
+	spin_lock_irqsave(&switch_queue_lock, flags);
+	switch_queue_stats.depth--;
+	switch_queue_stats.completed++;
+	if (status != MV_OK)
+		switch_queue_stats.failed++;
+	switch_queue_stats.hist[bucket]++;
+	spin_unlock_irqrestore(&switch_queue_lock, flags);
+
+	op->status = status;
+	if (op->done)
+		op->done(op);
+}
+
+/* Moves the operations that fit in one register list to 'ops' */
+static MV_U32 mvSwitchQueueStage(struct list_head *ops)
+{
+	MV_SWITCH_OP	*op;
+	unsigned long	flags;
+	MV_U32		entries = 0;
+
+	spin_lock_irqsave(&switch_queue_lock, flags);
+	while (!list_empty(&switch_queue)) {
+		op = list_first_entry(&switch_queue, MV_SWITCH_OP, link);
+		if (entries + op->entries > MV_SWITCH_BATCH_MAX_OPS)
+			break;
+		memcpy(&switch_queue_list[entries], op->list, op->entries * sizeof(HW_DEV_RW_REG));
+		entries += op->entries;
+		list_move_tail(&op->link, ops);
+	}
+	spin_unlock_irqrestore(&switch_queue_lock, flags);
+
+	return entries;
+}
+
+static void mvSwitchQueueWork(struct work_struct *work)
+{
+	LIST_HEAD(ops);
+	MV_SWITCH_OP	*op, *tmp;
+	unsigned long	flags;
+	MV_U32		entries, failed, offs;
+	MV_STATUS	status;
+
+	while ((entries = mvSwitchQueueStage(&ops)) != 0) {
+		status = mv_switch_rw_reg_list(switch_queue_list, entries, &failed);
+		spin_lock_irqsave(&switch_queue_lock, flags);
+		switch_queue_stats.runs++;
+		spin_unlock_irqrestore(&switch_queue_lock, flags);
+
+		/* operations before the failing one are done, it fails,   */
+		/* the ones after it were not executed and are run again    */
+		/* unless it is not known how far the list got: they fail   */
+		offs = 0;
+		list_for_each_entry_safe(op, tmp, &ops, link) {
+			if (status != MV_OK && status != MV_TIMEOUT && offs > failed)
+				break;
+			list_del(&op->link);
+			memcpy(op->list, &switch_queue_list[offs], op->entries * sizeof(HW_DEV_RW_REG));
+			offs += op->entries;
+			mvSwitchQueueComplete(op, (status == MV_OK || offs <= failed) ? MV_OK : status);
+		}
+
+		if (!list_empty(&ops)) {
+			spin_lock_irqsave(&switch_queue_lock, flags);
+			list_splice(&ops, &switch_queue);
+			INIT_LIST_HEAD(&ops);
+			spin_unlock_irqrestore(&switch_queue_lock, flags);
+		}
+	}
+}
+
+/*******************************************************************************
+* mv_switch_queue_init - Create the worker of the register operation queue.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_queue_init(void)
+{
+	if (switch_queue_wq)
+		return MV_OK;
+
+	INIT_WORK(&switch_queue_work, mvSwitchQueueWork);
+	switch_queue_wq = create_singlethread_workqueue("mv_switch");
+	if (switch_queue_wq == NULL) {
+		printk(KERN_ERR "%s: failed to create the register queue worker\n", __func__);
+		return MV_NO_RESOURCE;
+	}
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* mv_switch_op_submit - Queue a register operation list.
+*
+* DESCRIPTION:
+*       May be called from any context. The list is executed by the queue
+*       worker after all previously submitted operations; op->done() is
+*       then called from the worker with op->status set and the read
+*       results in op->list[].data. The caller must not touch 'op' until
+*       done() is called; done() may free it.
+*
+* INPUT:
+*       op - list[], entries (1..MV_SWITCH_OP_MAX_REGS), done and cookie.
+*
+* RETURN:
+*       MV_OK if queued, MV_NOT_READY if the worker is not running,
+*       MV_FULL if MV_SWITCH_QUEUE_MAX_DEPTH operations are pending,
+*       MV_BAD_PARAM on a bad entry count.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_op_submit(MV_SWITCH_OP *op)
+{
+	unsigned long flags;
+
+	if (op->entries == 0 || op->entries > MV_SWITCH_OP_MAX_REGS)
+		return MV_BAD_PARAM;
+
+	if (switch_queue_wq == NULL)
+		return MV_NOT_READY;
+
+	op->status = MV_NOT_READY;
+	op->submitted = ktime_get();
+
+	spin_lock_irqsave(&switch_queue_lock, flags);
+	if (switch_queue_stats.depth >= MV_SWITCH_QUEUE_MAX_DEPTH) {
+		switch_queue_stats.rejected++;
+		spin_unlock_irqrestore(&switch_queue_lock, flags);
+		return MV_FULL;
+	}
+	list_add_tail(&op->link, &switch_queue);
+	switch_queue_stats.submitted++;
+	if (++switch_queue_stats.depth > switch_queue_stats.maxDepth)
+		switch_queue_stats.maxDepth = switch_queue_stats.depth;
+	spin_unlock_irqrestore(&switch_queue_lock, flags);
+
+	queue_work(switch_queue_wq, &switch_queue_work);
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* mv_switch_queue_call - Run a work item on the queue worker.
+*
+* DESCRIPTION:
+*       For sequences that need process context, e.g. the table engine
+*       semaphores, requested from atomic context. The work runs after the
+*       operations submitted before it. May be called from any context.
+*
+* RETURN:
+*       MV_OK if queued (or already pending), MV_NOT_READY if the worker is
+*       not running.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_queue_call(struct work_struct *work)
+{
+	if (switch_queue_wq == NULL)
+		return MV_NOT_READY;
+
+	queue_work(switch_queue_wq, work);
+
+	return MV_OK;
+}
+
+/*******************************************************************************
+* mv_switch_op_reg_add - Append a register access to an operation.
+*
+* INPUT:
+*       cmd        - HW_REG_READ, HW_REG_WRITE or HW_REG_RMW.
+*       port, reg,
+*       type       - as in mv_switch_reg_write(); MV_SWITCH_SMI_ACCESS is not
+*                    supported.
+*       value      - value to write.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_op_reg_add(MV_SWITCH_OP *op, MV_U32 cmd, int port, int reg, int type,
+			       unsigned int value)
+{
+	HW_DEV_RW_REG *entry;
+
+	if (op->entries >= MV_SWITCH_OP_MAX_REGS || reg < 0 || reg > 31)
+		return MV_BAD_PARAM;
+
+	entry = &op->list[op->entries];
+	switch (type) {
+	case MV_SWITCH_PHY_ACCESS:
+		entry->addr = port;
+		break;
+	case MV_SWITCH_PORT_ACCESS:
+		entry->addr = 0x10 + port;
+		break;
+	case MV_SWITCH_GLOBAL_ACCESS:
+		entry->addr = 0x1b;
+		break;
+	case MV_SWITCH_GLOBAL2_ACCESS:
+		entry->addr = 0x1c;
+		break;
+	default:
+		return MV_NOT_SUPPORTED;
+	}
+	entry->cmd = cmd;
+	entry->reg = reg;
+	entry->data = value;
+	op->entries++;
+
+	return MV_OK;
+}
+
+static void mvSwitchOpFree(MV_SWITCH_OP *op)
+{
+	if (op->status != MV_OK)
+		printk(KERN_ERR "%s: queued write of 0x%02lx/%lu failed, status %d\n",
+		       __func__, op->list[0].addr, op->list[0].reg, op->status);
+	kfree(op);
+}
+
+/*******************************************************************************
+* mv_switch_reg_write_async - Queue a register write, see mv_switch_reg_write.
+*
+* DESCRIPTION:
+*       Fire and forget: may be called from any context, failures of the
+*       write itself are only logged. Use mv_switch_queue_flush() to wait
+*       for the write.
+*
+* RETURN:
+*       0 once queued, -ENOMEM, -EINVAL for a bad port/register/type, or
+*       -EBUSY when the queue is not running or full.
+*
+*******************************************************************************/
+int mv_switch_reg_write_async(int port, int reg, int type, unsigned int value)
+{
+	MV_SWITCH_OP	*op;
+
+	op = kzalloc(sizeof(MV_SWITCH_OP), GFP_ATOMIC);
+	if (op == NULL)
+		return -ENOMEM;
+
+	op->done = mvSwitchOpFree;
+	if (mv_switch_op_reg_add(op, HW_REG_WRITE, port, reg, type, value) != MV_OK) {
+		kfree(op);
+		return -EINVAL;
+	}
+	if (mv_switch_op_submit(op) != MV_OK) {
+		kfree(op);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+/* Waits until all operations submitted so far are done. May sleep. */
+void mv_switch_queue_flush(void)
+{
+	if (switch_queue_wq)
+		flush_workqueue(switch_queue_wq);
+}
+
+void mv_switch_queue_stats_get(MV_SWITCH_QUEUE_STATS *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&switch_queue_lock, flags);
+	*stats = switch_queue_stats;
+	spin_unlock_irqrestore(&switch_queue_lock, flags);
+}
+
+/* Upper bound in us of the bucket holding the given percentile */
+static MV_U32 mvSwitchQueuePercentile(MV_SWITCH_QUEUE_STATS *s, MV_U32 percent)
+{
+	MV_U32 i, sum = 0, total = 0;
+
+	for (i = 0; i < MV_SWITCH_SMI_HIST_BUCKETS; i++)
+		total += s->hist[i];
+	for (i = 0; i < MV_SWITCH_SMI_HIST_BUCKETS; i++) {
+		sum += s->hist[i];
+		if (sum * 100 >= total * percent)
+			break;
+	}
+	return (i < MV_SWITCH_SMI_HIST_BUCKETS) ? (1 << i) : 0;
+}
+
+int mv_switch_queue_show(char *buf)
+{
+	MV_SWITCH_QUEUE_STATS	s;
+	int			i, off = 0;
+
+	mv_switch_queue_stats_get(&s);
+
+	off += sprintf(buf + off, "queue %s: depth %u max %u submitted %u completed %u failed %u rejected %u runs %u\n",
+		       switch_queue_wq ? "on" : "off", s.depth, s.maxDepth, s.submitted,
+		       s.completed, s.failed, s.rejected, s.runs);
+	off += sprintf(buf + off, "latency p50 <%uus p99 <%uus, log2(us):", mvSwitchQueuePercentile(&s, 50),
+		       mvSwitchQueuePercentile(&s, 99));
+	for (i = 0; i < MV_SWITCH_SMI_HIST_BUCKETS; i++)
+		off += sprintf(buf + off, " %u", s.hist[i]);
+	off += sprintf(buf + off, "\n");
+
+	return off;
+}
+
+/*******************************************************************************
+* mv_switch_queue_bench - Measure the queue with 'count' register reads.
+*
+* DESCRIPTION:
+*       Submits 'count' single read operations of the port 0 switch
+*       identifier register back-to-back, waits for all of them and reports
+*       the throughput, the reached queue depth and the latency percentiles
+*       of this run; read the report with mv_switch_queue_bench_show().
+*
+*******************************************************************************/
+struct mv_switch_queue_bench {
+	atomic_t		left;
+	struct completion	done;
+};
+
+static DEFINE_MUTEX(switch_queue_bench_lock);
+static char	switch_queue_bench_report[MV_SWITCH_BENCH_REPORT_SIZE];
+static int	switch_queue_bench_len;
+
+static void mvSwitchQueueBenchDone(MV_SWITCH_OP *op)
+{
+	struct mv_switch_queue_bench *bench = op->cookie;
+
+	if (atomic_dec_and_test(&bench->left))
+		complete(&bench->done);
+}
+
+int mv_switch_queue_bench(int count)
+{
+	struct mv_switch_queue_bench	bench;
+	MV_SWITCH_QUEUE_STATS		before, after;
+	MV_SWITCH_OP			*ops;
+	ktime_t				start;
+	s64				ns;
+	int				i, submitted = 0, failed = 0;
+
+	if (count <= 0 || count > MV_SWITCH_QUEUE_MAX_DEPTH)
+		return -EINVAL;
+
+	ops = kcalloc(count, sizeof(MV_SWITCH_OP), GFP_KERNEL);
+	if (ops == NULL)
+		return -ENOMEM;
+
+	mutex_lock(&switch_queue_bench_lock);
+	/* run from a quiet queue so that the counters belong to this run */
+	mv_switch_queue_flush();
+	spin_lock_irq(&switch_queue_lock);
+	switch_queue_stats.maxDepth = 0;
+	before = switch_queue_stats;
+	spin_unlock_irq(&switch_queue_lock);
+
+	atomic_set(&bench.left, count);
+	init_completion(&bench.done);
+
+	start = ktime_get();
+	for (i = 0; i < count; i++) {
+		ops[i].done = mvSwitchQueueBenchDone;
+		ops[i].cookie = &bench;
+		mv_switch_op_reg_add(&ops[i], HW_REG_READ, 0, QD_REG_SWITCH_ID, MV_SWITCH_PORT_ACCESS, 0);
+		if (mv_switch_op_submit(&ops[i]) != MV_OK)
+			break;
+		submitted++;
+	}
+	/* account for the operations that were never queued */
+	if (submitted < count && atomic_sub_and_test(count - submitted, &bench.left))
+		complete(&bench.done);
+	if (submitted)
+		wait_for_completion(&bench.done);
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	mv_switch_queue_stats_get(&after);
+	for (i = 0; i < MV_SWITCH_SMI_HIST_BUCKETS; i++)
+		after.hist[i] -= before.hist[i];
+	for (i = 0; i < submitted; i++)
+		if (ops[i].status != MV_OK)
+			failed++;
+
+	i = sprintf(switch_queue_bench_report,
+		    "queue bench: %d/%d ops in %lld us, %lld ops/s, %u runs, max depth %u, failed %d\n",
+		    submitted, count, div_s64(ns, 1000), ns ? div_s64((s64)submitted * NSEC_PER_SEC, ns) : 0,
+		    after.runs - before.runs, after.maxDepth, failed);
+	i += sprintf(switch_queue_bench_report + i, "queue bench: latency p50 <%uus p99 <%uus max <%uus\n",
+		     mvSwitchQueuePercentile(&after, 50), mvSwitchQueuePercentile(&after, 99),
+		     mvSwitchQueuePercentile(&after, 100));
+	switch_queue_bench_len = i;
+	mutex_unlock(&switch_queue_bench_lock);
+
+	kfree(ops);
+
+	return (submitted == count) ? 0 : -EBUSY;
+}
+
+/* Report of the last mv_switch_queue_bench() run */
+int mv_switch_queue_bench_show(char *buf)
+{
+	int len;
+
+	mutex_lock(&switch_queue_bench_lock);
+	len = switch_queue_bench_len;
+	memcpy(buf, switch_queue_bench_report, len);
+	mutex_unlock(&switch_queue_bench_lock);
+
+	return len;
+}
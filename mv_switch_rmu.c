@@ -0,0 +1,807 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+
+/*
+ * Remote Management Unit (RMU) access path.
+ *
+ * Register lists, MIB dumps and ATU dumps are sent to the switch as request
+ * frames through the CPU port and answered with one response frame, instead
+ * of one ~20us MDIO transaction per register. Only one request is in flight
+ * at a time. Whenever RMU is not running or a request is not answered the
+ * callers fall back to SMI.
+ *
+ * The transport is pluggable: mv_switch_rmu_netdev_start() uses the network
+ * device of the CPU port, mv_switch_rmu_loopback_start() a stand-in that
+ * answers requests in software over SMI (or the register model), which
+ * exercises the whole frame path without RMU capable hardware.
+ *
+ * Frame layout (all fields big endian):
+ *   DA[6] SA[6] DSA tag[4] format[2] seq[2] code[2] data[...]
+ * The data of an error response to a register list is the index[2] of the
+ * failing operation, the operations before it were executed.
+ */
+
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/completion.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/etherdevice.h>
+#include <linux/string.h>
+
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "dsdt/msApiPrototype.h"
+#include "mv_switch.h"
+
+#define RMU_FRAME_MAX			1518
+#define RMU_FRAME_MIN			60
+#define RMU_OFFS_DSA			12
+#define RMU_OFFS_FORMAT			16
+#define RMU_OFFS_SEQ			18
+#define RMU_OFFS_CODE			20
+#define RMU_HDR_LEN			22
+
+#define RMU_FORMAT_REQUEST		0x0001
+#define RMU_FORMAT_RESPONSE		0x0002
+#define RMU_FORMAT_ERROR		0xFFFF
+
+#define RMU_CODE_GET_ID			0x0000
+#define RMU_CODE_ATU_DUMP		0x1000
+#define RMU_CODE_MIB_DUMP		0x1020
+#define RMU_CODE_REG_RW			0x2000
+
+/* DSA FROM_CPU tag towards the RMU of device 'dev' */
+#define RMU_DSA_FROM_CPU(dev)		(0x40 | ((dev) & 0x1F))
+#define RMU_DSA_RMU_PORT		0xF8
+
+/* Register RW word: op[27:26] dev[25:21] reg[20:16] data[15:0], wait  */
+/* polarity in bit 28 and the bit number in data[3:0]; list terminator */
+#define RMU_RW_OP_WRITE			0x1
+#define RMU_RW_OP_READ			0x2
+#define RMU_RW_OP_WAIT			0x3
+#define RMU_RW_WORD(op, dev, reg, data)	(((op) << 26) | ((dev) << 21) | ((reg) << 16) | ((data) & 0xFFFF))
+#define RMU_RW_WAIT_TILL_1		(1 << 28)
+#define RMU_RW_END			0xFFFFFFFF
+#define RMU_RW_MAX_OPS			((RMU_FRAME_MAX - RMU_HDR_LEN) / 4 - 1)
+#define RMU_RW_INDEX_UNKNOWN		0xFFFF
+
+/* ATU dump entry: MAC[6] ATU data[2] DBNum[2] */
+#define RMU_ATU_ENTRY_LEN		10
+#define RMU_ATU_PER_FRAME		48
+
+#define RMU_TIMEOUT_MS			20
+
+typedef int (*MV_SWITCH_RMU_XMIT)(MV_U8 *frame, int len);
+
+static DEFINE_MUTEX(switch_rmu_lock);		/* one request in flight */
+static DEFINE_SPINLOCK(switch_rmu_rx_lock);
+static DECLARE_COMPLETION(switch_rmu_done);
+
+static const MV_U8 switch_rmu_da[6] = { 0x01, 0x50, 0x43, 0x00, 0x00, 0x00 };
+
+static struct {
+	MV_SWITCH_RMU_XMIT	xmit;
+	MV_U8			cpuMac[6];
+	MV_U8			devNum;
+	MV_U16			seq;
+	MV_U16			code;
+	MV_BOOL			waiting;
+	int			respLen;
+	MV_U8			req[RMU_FRAME_MAX];
+	MV_U8			resp[RMU_FRAME_MAX];
+	struct net_device	*netdev;
+	MV_SWITCH_RMU_STATS	stats;
+} switch_rmu;
+
+static struct packet_type switch_rmu_packet;
+
+static inline MV_U16 rmuGet16(const MV_U8 *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static inline void rmuPut16(MV_U8 *p, MV_U16 v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xFF;
+}
+
+static inline MV_U32 rmuGet32(const MV_U8 *p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline void rmuPut32(MV_U8 *p, MV_U32 v)
+{
+	rmuPut16(p, v >> 16);
+	rmuPut16(p + 2, v & 0xFFFF);
+}
+
+/* Builds the request header, returns the offset of the data */
+static int mvSwitchRmuHeader(MV_U8 *frame, MV_U16 code)
+{
+	memcpy(frame, switch_rmu_da, 6);
+	memcpy(frame + 6, switch_rmu.cpuMac, 6);
+	frame[RMU_OFFS_DSA] = RMU_DSA_FROM_CPU(switch_rmu.devNum);
+	frame[RMU_OFFS_DSA + 1] = RMU_DSA_RMU_PORT;
+	frame[RMU_OFFS_DSA + 2] = 0;
+	frame[RMU_OFFS_DSA + 3] = 0;
+	rmuPut16(frame + RMU_OFFS_FORMAT, RMU_FORMAT_REQUEST);
+	rmuPut16(frame + RMU_OFFS_SEQ, ++switch_rmu.seq);
+	rmuPut16(frame + RMU_OFFS_CODE, code);
+
+	return RMU_HDR_LEN;
+}
+
+/*******************************************************************************
+* mvSwitchRmuRequest - Send the request in switch_rmu.req and wait for the
+*                      response.
+*
+* DESCRIPTION:
+*       Must be called with switch_rmu_lock held. On success the response is
+*       in switch_rmu.resp.
+*
+* RETURN:
+*       MV_OK, MV_NOT_READY if RMU is not running, MV_TIMEOUT if no response
+*       arrived, MV_FAIL if the switch answered with an error frame.
+*
+*******************************************************************************/
+static MV_STATUS mvSwitchRmuRequest(int len)
+{
+	unsigned long	flags;
+	MV_STATUS	status;
+
+	if (switch_rmu.xmit == NULL)
+		return MV_NOT_READY;
+
+	if (len < RMU_FRAME_MIN) {
+		memset(switch_rmu.req + len, 0, RMU_FRAME_MIN - len);
+		len = RMU_FRAME_MIN;
+	}
+
+	spin_lock_irqsave(&switch_rmu_rx_lock, flags);
+	switch_rmu.code = rmuGet16(switch_rmu.req + RMU_OFFS_CODE);
+	switch_rmu.respLen = 0;
+	switch_rmu.waiting = MV_TRUE;
+	INIT_COMPLETION(switch_rmu_done);
+	spin_unlock_irqrestore(&switch_rmu_rx_lock, flags);
+
+	switch_rmu.stats.requests++;
+	if (switch_rmu.xmit(switch_rmu.req, len)) {
+		status = MV_TX_ERROR;
+	} else if (!wait_for_completion_timeout(&switch_rmu_done, msecs_to_jiffies(RMU_TIMEOUT_MS))) {
+		status = MV_TIMEOUT;
+	} else {
+		status = (rmuGet16(switch_rmu.resp + RMU_OFFS_FORMAT) == RMU_FORMAT_ERROR) ? MV_FAIL : MV_OK;
+	}
+
+	spin_lock_irqsave(&switch_rmu_rx_lock, flags);
+	switch_rmu.waiting = MV_FALSE;
+	spin_unlock_irqrestore(&switch_rmu_rx_lock, flags);
+
+	if (status == MV_OK)
+		switch_rmu.stats.responses++;
+	else if (status == MV_FAIL)
+		switch_rmu.stats.errors++;
+	else
+		switch_rmu.stats.timeouts++;
+
+	return status;
+}
+
+/*******************************************************************************
+* mv_switch_rmu_rx - Deliver a frame received from the CPU port.
+*
+* DESCRIPTION:
+*       Completes the pending request if the frame is its response. May be
+*       called from any context.
+*
+* RETURN:
+*       MV_TRUE if the frame was an RMU response and was consumed.
+*
+*******************************************************************************/
+MV_BOOL mv_switch_rmu_rx(const MV_U8 *frame, int len)
+{
+	unsigned long	flags;
+	MV_U16		format;
+	MV_BOOL		consumed = MV_FALSE;
+
+	if (len < RMU_HDR_LEN || len > RMU_FRAME_MAX)
+		return MV_FALSE;
+
+	format = rmuGet16(frame + RMU_OFFS_FORMAT);
+	if (format != RMU_FORMAT_RESPONSE && format != RMU_FORMAT_ERROR)
+		return MV_FALSE;
+
+	spin_lock_irqsave(&switch_rmu_rx_lock, flags);
+	if (switch_rmu.waiting && switch_rmu.respLen == 0 &&
+	    rmuGet16(frame + RMU_OFFS_SEQ) == switch_rmu.seq &&
+	    rmuGet16(frame + RMU_OFFS_CODE) == switch_rmu.code) {
+		memcpy(switch_rmu.resp, frame, len);
+		switch_rmu.respLen = len;
+		complete(&switch_rmu_done);
+		consumed = MV_TRUE;
+	}
+	spin_unlock_irqrestore(&switch_rmu_rx_lock, flags);
+
+	return consumed;
+}
+
+/*******************************************************************************
+* mv_switch_rmu_rw_reg_list - Execute a register list with one RMU request.
+*
+* DESCRIPTION:
+*       Supports HW_REG_READ, HW_REG_WRITE and HW_REG_WAIT_TILL_0/1 in direct
+*       addressing mode. Read results are returned in list[].data.
+*
+* OUTPUT:
+*       failed  - entries on success, the index of the failing operation
+*                 when the switch reported it, 0 otherwise.
+*
+* RETURN:
+*       MV_OK on success, MV_NOT_READY if RMU is not running or the list can
+*       not be sent over RMU, MV_TX_ERROR if the request frame could not be
+*       sent (the caller uses SMI then, nothing was executed), MV_FAIL if
+*       operation 'failed' failed, MV_TIMEOUT if it is not known how much
+*       of the list was executed (no answer, or an error without an index):
+*       the list must then be failed as a whole and not be retried.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_rmu_rw_reg_list(HW_DEV_RW_REG *list, MV_U32 entries, MV_U32 *failed)
+{
+	MV_U8		*data;
+	MV_U32		i, word, op, index = 0;
+	MV_STATUS	status;
+
+	if (switch_rmu.xmit == NULL || entries > RMU_RW_MAX_OPS)
+		return MV_NOT_READY;
+
+	for (i = 0; i < entries; i++)
+		if (list[i].cmd > HW_REG_WAIT_TILL_1)
+			return MV_NOT_READY;
+
+	mutex_lock(&switch_rmu_lock);
+
+	data = switch_rmu.req + mvSwitchRmuHeader(switch_rmu.req, RMU_CODE_REG_RW);
+	for (i = 0; i < entries; i++, data += 4) {
+		switch (list[i].cmd) {
+		case HW_REG_READ:
+			op = RMU_RW_OP_READ;
+			break;
+		case HW_REG_WRITE:
+			op = RMU_RW_OP_WRITE;
+			break;
+		default:
+			op = RMU_RW_OP_WAIT;
+			break;
+		}
+		word = RMU_RW_WORD(op, list[i].addr, list[i].reg, list[i].data);
+		if (list[i].cmd == HW_REG_WAIT_TILL_1)
+			word |= RMU_RW_WAIT_TILL_1;
+		rmuPut32(data, word);
+	}
+	rmuPut32(data, RMU_RW_END);
+
+	status = mvSwitchRmuRequest(data + 4 - switch_rmu.req);
+	if (status == MV_OK) {
+		data = switch_rmu.resp + RMU_HDR_LEN;
+		for (i = 0; i < entries; i++, data += 4)
+			if (list[i].cmd == HW_REG_READ)
+				list[i].data = rmuGet32(data) & 0xFFFF;
+		switch_rmu.stats.rwOps += entries;
+		index = entries;
+	} else if (status == MV_FAIL) {
+		index = (switch_rmu.respLen >= RMU_HDR_LEN + 2) ?
+			rmuGet16(switch_rmu.resp + RMU_HDR_LEN) : RMU_RW_INDEX_UNKNOWN;
+		if (index >= entries) {
+			index = 0;
+			status = MV_TIMEOUT;
+		}
+	}
+
+	mutex_unlock(&switch_rmu_lock);
+
+	if (failed)
+		*failed = index;
+
+	return status;
+}
+
+/*******************************************************************************
+* SMI implementations of the dump requests, used as fallback and by the
+* loopback stand-in.
+*******************************************************************************/
+static MV_STATUS mvSwitchSmiMibDump(GT_QD_DEV *dev, GT_LPORT port, MV_U32 *counters)
+{
+	HW_DEV_RW_REG	list[4 * 4];
+	MV_U32		g1, i, c, n;
+	MV_U16		op;
+	MV_STATUS	status;
+
+	g1 = CALC_SMI_DEV_ADDR(dev, 0, GLOBAL_REG_ACCESS);
+
+	gtSemTake(dev, dev->statsRegsSem, OS_WAIT_FOREVER);
+
+	/* capture all counters of the port, both histogram directions */
+	op = QD_SMI_BUSY | (GT_STATS_CAPTURE_PORT << 12) | (3 << 10) | ((port + 1) << 5);
+	n = 0;
+	list[n].cmd = HW_REG_WAIT_TILL_0;
+	list[n].addr = g1;
+	list[n].reg = QD_REG_STATS_OPERATION;
+	list[n++].data = 15;
+	list[n].cmd = HW_REG_WRITE;
+	list[n].addr = g1;
+	list[n].reg = QD_REG_STATS_OPERATION;
+	list[n++].data = op;
+	list[n].cmd = HW_REG_WAIT_TILL_0;
+	list[n].addr = g1;
+	list[n].reg = QD_REG_STATS_OPERATION;
+	list[n++].data = 15;
+	status = mv_switch_smi_rw_reg_list(list, n, NULL);
+
+	/* read the captured counters, 4 per register list */
+	for (c = 0; c < MV_SWITCH_MIB_COUNTERS && status == MV_OK; c += 4) {
+		for (i = 0, n = 0; i < 4; i++) {
+			list[n].cmd = HW_REG_WRITE;
+			list[n].addr = g1;
+			list[n].reg = QD_REG_STATS_OPERATION;
+			list[n++].data = QD_SMI_BUSY | (GT_STATS_READ_COUNTER << 12) | (3 << 10) | (c + i);
+			list[n].cmd = HW_REG_WAIT_TILL_0;
+			list[n].addr = g1;
+			list[n].reg = QD_REG_STATS_OPERATION;
+			list[n++].data = 15;
+			list[n].cmd = HW_REG_READ;
+			list[n].addr = g1;
+			list[n].reg = QD_REG_STATS_COUNTER3_2;
+			list[n++].data = 0;
+			list[n].cmd = HW_REG_READ;
+			list[n].addr = g1;
+			list[n].reg = QD_REG_STATS_COUNTER1_0;
+			list[n++].data = 0;
+		}
+		status = mv_switch_smi_rw_reg_list(list, n, NULL);
+		for (i = 0; i < 4 && status == MV_OK; i++)
+			counters[c + i] = (list[4 * i + 2].data << 16) | list[4 * i + 3].data;
+	}
+
+	gtSemGive(dev, dev->statsRegsSem);
+
+	return status;
+}
+
+/* Walks DBNum from 'start' (broadcast starts the walk), up to max entries */
+static MV_STATUS mvSwitchSmiAtuDump(GT_QD_DEV *dev, MV_U16 dbNum, const MV_U8 *start,
+				    GT_ATU_ENTRY *entries, MV_U32 max, MV_U32 *count)
+{
+	GT_ATU_ENTRY	entry;
+	MV_STATUS	status = MV_OK;
+
+	memset(&entry, 0, sizeof(entry));
+	memcpy(entry.macAddr, start, 6);
+	entry.DBNum = dbNum;
+
+	for (*count = 0; *count < max; (*count)++) {
+		status = gfdbGetAtuEntryNext(dev, &entry);
+		if (status != MV_OK)
+			break;
+		entries[*count] = entry;
+		/* a broadcast entry is the last one, GetNext would wrap */
+		if (is_broadcast_ether_addr(entry.macAddr)) {
+			(*count)++;
+			status = MV_NO_SUCH;
+			break;
+		}
+	}
+
+	return (status == MV_NO_SUCH) ? MV_OK : status;
+}
+
+/*******************************************************************************
+* mv_switch_mib_dump - Read all MIB counters of a port.
+*
+* DESCRIPTION:
+*       Uses one RMU request when RMU is running, the statistics unit over
+*       SMI otherwise.
+*
+* OUTPUT:
+*       counters - MV_SWITCH_MIB_COUNTERS counter values.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_mib_dump(GT_QD_DEV *dev, GT_LPORT port, MV_U32 *counters)
+{
+	MV_U8		*data;
+	MV_U32		i;
+	MV_STATUS	status;
+
+	if (port >= dev->numOfPorts)
+		return MV_BAD_PARAM;
+
+	mutex_lock(&switch_rmu_lock);
+	data = switch_rmu.req + mvSwitchRmuHeader(switch_rmu.req, RMU_CODE_MIB_DUMP);
+	rmuPut16(data, port);
+	status = mvSwitchRmuRequest(data + 2 - switch_rmu.req);
+	if (status == MV_OK) {
+		data = switch_rmu.resp + RMU_HDR_LEN + 2;
+		for (i = 0; i < MV_SWITCH_MIB_COUNTERS; i++, data += 4)
+			counters[i] = rmuGet32(data);
+	} else if (status != MV_NOT_READY) {
+		switch_rmu.stats.fallbacks++;
+	}
+	mutex_unlock(&switch_rmu_lock);
+
+	if (status == MV_OK)
+		return MV_OK;
+
+	return mvSwitchSmiMibDump(dev, port, counters);
+}
+
+/*******************************************************************************
+* mv_switch_atu_dump - Read the ATU entries of an address database.
+*
+* DESCRIPTION:
+*       Uses RMU dump requests (RMU_ATU_PER_FRAME entries each) when RMU is
+*       running, a GetNext walk over SMI otherwise. Can be called repeatedly
+*       with the last MAC returned as 'startMac' to walk the table in chunks.
+*
+* INPUT:
+*       dbNum    - address database.
+*       startMac - entries after this MAC are returned; NULL or broadcast
+*                  starts from the beginning of the database.
+*       max      - size of entries[].
+*
+* OUTPUT:
+*       entries - the entries, in MAC order.
+*       count   - number of entries returned.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_atu_dump(GT_QD_DEV *dev, MV_U16 dbNum, const MV_U8 *startMac,
+			     GT_ATU_ENTRY *entries, MV_U32 max, MV_U32 *count)
+{
+	static const MV_U8	bcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	GT_ATU_ENTRY		*e;
+	MV_U8			start[6], *data;
+	MV_U32			i, n, atuData, portMask = (1 << dev->maxPorts) - 1;
+	MV_STATUS		status = MV_OK;
+
+	memcpy(start, startMac ? startMac : bcast, 6);
+	*count = 0;
+
+	mutex_lock(&switch_rmu_lock);
+	while (*count < max) {
+		data = switch_rmu.req + mvSwitchRmuHeader(switch_rmu.req, RMU_CODE_ATU_DUMP);
+		rmuPut16(data, dbNum);
+		memcpy(data + 2, start, 6);
+		status = mvSwitchRmuRequest(data + 8 - switch_rmu.req);
+		if (status != MV_OK)
+			break;
+
+		data = switch_rmu.resp + RMU_HDR_LEN;
+		n = rmuGet16(data);
+		data += 2;
+		for (i = 0; i < n && *count < max; i++, data += RMU_ATU_ENTRY_LEN) {
+			e = &entries[(*count)++];
+			memset(e, 0, sizeof(*e));
+			memcpy(e->macAddr, data, 6);
+			atuData = rmuGet16(data + 6);
+			e->prio = atuData >> 14;
+			e->portVec = (atuData >> 4) & portMask;
+			e->entryState.ucEntryState = atuData & 0xF;
+			e->DBNum = rmuGet16(data + 8);
+			memcpy(start, e->macAddr, 6);
+		}
+		if (n < RMU_ATU_PER_FRAME || is_broadcast_ether_addr(start))
+			break;
+	}
+	if (status != MV_OK && status != MV_NOT_READY)
+		switch_rmu.stats.fallbacks++;
+	mutex_unlock(&switch_rmu_lock);
+
+	if (status == MV_OK)
+		return MV_OK;
+
+	/* continue after the last entry received over RMU */
+	status = mvSwitchSmiAtuDump(dev, dbNum, start, entries + *count, max - *count, &n);
+	*count += n;
+
+	return status;
+}
+
+/*******************************************************************************
+* Loopback stand-in: answers requests in software, register accesses go to
+* SMI or the register backend installed in qddev.
+*******************************************************************************/
+extern GT_QD_DEV qddev;
+
+/* The stand-in runs from mvSwitchRmuRequest(), i.e. under switch_rmu_lock */
+static MV_U8		switch_rmu_loop_resp[RMU_FRAME_MAX];
+static HW_DEV_RW_REG	switch_rmu_loop_list[RMU_RW_MAX_OPS];
+static GT_ATU_ENTRY	switch_rmu_loop_atu[RMU_ATU_PER_FRAME];
+
+static int mvSwitchRmuLoopbackRegRw(const MV_U8 *req, int len, MV_U8 *resp)
+{
+	HW_DEV_RW_REG	*list = switch_rmu_loop_list;
+	MV_U32		n, word, op, failed;
+	MV_STATUS	status;
+
+	for (n = 0; RMU_HDR_LEN + 4 * (n + 1) <= len; n++) {
+		word = rmuGet32(req + RMU_HDR_LEN + 4 * n);
+		if (word == RMU_RW_END || n == RMU_RW_MAX_OPS)
+			break;
+
+		op = (word >> 26) & 0x3;
+		list[n].addr = (word >> 21) & 0x1F;
+		list[n].reg = (word >> 16) & 0x1F;
+		list[n].data = word & 0xFFFF;
+		if (op == RMU_RW_OP_READ)
+			list[n].cmd = HW_REG_READ;
+		else if (op == RMU_RW_OP_WRITE)
+			list[n].cmd = HW_REG_WRITE;
+		else
+			list[n].cmd = (word & RMU_RW_WAIT_TILL_1) ? HW_REG_WAIT_TILL_1 : HW_REG_WAIT_TILL_0;
+	}
+
+	status = mv_switch_smi_rw_reg_list(list, n, &failed);
+	if (status != MV_OK) {
+		rmuPut16(resp + RMU_HDR_LEN, failed);
+		return -1;
+	}
+
+	memcpy(resp + RMU_HDR_LEN, req + RMU_HDR_LEN, 4 * n);
+	for (op = 0; op < n; op++)
+		if (list[op].cmd == HW_REG_READ)
+			rmuPut32(resp + RMU_HDR_LEN + 4 * op,
+				 (rmuGet32(req + RMU_HDR_LEN + 4 * op) & 0xFFFF0000) | list[op].data);
+	rmuPut32(resp + RMU_HDR_LEN + 4 * n, RMU_RW_END);
+
+	return RMU_HDR_LEN + 4 * (n + 1);
+}
+
+static int mvSwitchRmuLoopbackAtu(const MV_U8 *req, MV_U8 *resp)
+{
+	GT_ATU_ENTRY	*entries = switch_rmu_loop_atu;
+	MV_U8		*data = resp + RMU_HDR_LEN + 2;
+	MV_U32		i, count;
+
+	if (mvSwitchSmiAtuDump(&qddev, rmuGet16(req + RMU_HDR_LEN), req + RMU_HDR_LEN + 2,
+			       entries, RMU_ATU_PER_FRAME, &count) != MV_OK)
+		return -1;
+
+	rmuPut16(resp + RMU_HDR_LEN, count);
+	for (i = 0; i < count; i++, data += RMU_ATU_ENTRY_LEN) {
+		memcpy(data, entries[i].macAddr, 6);
+		rmuPut16(data + 6, (entries[i].prio << 14) | (entries[i].portVec << 4) |
+			 entries[i].entryState.ucEntryState);
+		rmuPut16(data + 8, entries[i].DBNum);
+	}
+
+	return data - resp;
+}
+
+static int mvSwitchRmuLoopbackMib(const MV_U8 *req, MV_U8 *resp)
+{
+	MV_U32	counters[MV_SWITCH_MIB_COUNTERS];
+	MV_U16	port = rmuGet16(req + RMU_HDR_LEN);
+	MV_U32	i;
+
+	if (port >= qddev.numOfPorts || mvSwitchSmiMibDump(&qddev, port, counters) != MV_OK)
+		return -1;
+
+	rmuPut16(resp + RMU_HDR_LEN, port);
+	for (i = 0; i < MV_SWITCH_MIB_COUNTERS; i++)
+		rmuPut32(resp + RMU_HDR_LEN + 2 + 4 * i, counters[i]);
+
+	return RMU_HDR_LEN + 2 + 4 * MV_SWITCH_MIB_COUNTERS;
+}
+
+static int mvSwitchRmuLoopbackXmit(MV_U8 *req, int len)
+{
+	MV_U8	*resp = switch_rmu_loop_resp;
+	int	respLen;
+
+	if (len < RMU_HDR_LEN || memcmp(req, switch_rmu_da, 6) ||
+	    rmuGet16(req + RMU_OFFS_FORMAT) != RMU_FORMAT_REQUEST)
+		return 0;
+
+	rmuPut16(resp + RMU_HDR_LEN, RMU_RW_INDEX_UNKNOWN);
+
+	switch (rmuGet16(req + RMU_OFFS_CODE)) {
+	case RMU_CODE_GET_ID:
+		/* product number of the switch */
+		rmuPut16(resp + RMU_HDR_LEN, GT_88E6172 >> 4);
+		respLen = RMU_HDR_LEN + 2;
+		break;
+	case RMU_CODE_REG_RW:
+		respLen = mvSwitchRmuLoopbackRegRw(req, len, resp);
+		break;
+	case RMU_CODE_ATU_DUMP:
+		respLen = mvSwitchRmuLoopbackAtu(req, resp);
+		break;
+	case RMU_CODE_MIB_DUMP:
+		respLen = mvSwitchRmuLoopbackMib(req, resp);
+		break;
+	default:
+		respLen = -1;
+		break;
+	}
+
+	memcpy(resp, req + 6, 6);
+	memcpy(resp + 6, req, 6);
+	resp[RMU_OFFS_DSA] = switch_rmu.devNum & 0x1F;	/* TO_CPU */
+	resp[RMU_OFFS_DSA + 1] = RMU_DSA_RMU_PORT;
+	resp[RMU_OFFS_DSA + 2] = 0;
+	resp[RMU_OFFS_DSA + 3] = 0;
+	memcpy(resp + RMU_OFFS_SEQ, req + RMU_OFFS_SEQ, 4);
+	if (respLen < 0) {
+		rmuPut16(resp + RMU_OFFS_FORMAT, RMU_FORMAT_ERROR);
+		respLen = RMU_HDR_LEN + 2;
+	} else {
+		rmuPut16(resp + RMU_OFFS_FORMAT, RMU_FORMAT_RESPONSE);
+	}
+
+	mv_switch_rmu_rx(resp, respLen);
+
+	return 0;
+}
+
+/*******************************************************************************
+* Network device transport
+*******************************************************************************/
+static int mvSwitchRmuNetdevXmit(MV_U8 *frame, int len)
+{
+	struct sk_buff *skb;
+
+	skb = dev_alloc_skb(len);
+	if (skb == NULL)
+		return -ENOMEM;
+
+	memcpy(skb_put(skb, len), frame, len);
+	skb->dev = switch_rmu.netdev;
+	skb_reset_mac_header(skb);
+
+	/* congestion still sends the frame */
+	return net_xmit_eval(dev_queue_xmit(skb)) ? -EIO : 0;
+}
+
+static int mvSwitchRmuNetdevRcv(struct sk_buff *skb, struct net_device *dev,
+				struct packet_type *pt, struct net_device *orig_dev)
+{
+	int len = skb->len + ETH_HLEN;
+
+	if (len <= skb_headlen(skb) + ETH_HLEN)
+		mv_switch_rmu_rx(skb_mac_header(skb), len);
+
+	kfree_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+/* Checks that the switch answers, stops RMU otherwise. switch_rmu_lock held. */
+static MV_STATUS mvSwitchRmuProbe(MV_SWITCH_RMU_XMIT xmit, const MV_U8 *cpuMac, MV_U8 devNum)
+{
+	MV_STATUS status;
+
+	memcpy(switch_rmu.cpuMac, cpuMac, 6);
+	switch_rmu.devNum = devNum;
+	switch_rmu.xmit = xmit;
+
+	status = mvSwitchRmuRequest(mvSwitchRmuHeader(switch_rmu.req, RMU_CODE_GET_ID));
+	if (status != MV_OK)
+		switch_rmu.xmit = NULL;
+
+	return status;
+}
+
+/*******************************************************************************
+* mv_switch_rmu_netdev_start - Run RMU over the CPU port network device.
+*
+* DESCRIPTION:
+*       Enables the RMU on the CPU port, hooks the receive path of 'netdev'
+*       and checks that the switch answers. The CPU port must carry DSA
+*       tagged frames.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_rmu_netdev_start(GT_QD_DEV *dev, struct net_device *netdev)
+{
+	GT_RMU		rmu;
+	MV_STATUS	status;
+
+	mv_switch_rmu_stop();
+
+	rmu.rmuEn = MV_TRUE;
+	rmu.port = dev->cpuPortNum;
+	status = gsysSetRMUMode(dev, &rmu);
+	if (status != MV_OK)
+		return status;
+
+	mutex_lock(&switch_rmu_lock);
+	dev_hold(netdev);
+	switch_rmu.netdev = netdev;
+	switch_rmu_packet.type = htons(ETH_P_ALL);
+	switch_rmu_packet.dev = netdev;
+	switch_rmu_packet.func = mvSwitchRmuNetdevRcv;
+	dev_add_pack(&switch_rmu_packet);
+
+	status = mvSwitchRmuProbe(mvSwitchRmuNetdevXmit, netdev->dev_addr, dev->devNum);
+	mutex_unlock(&switch_rmu_lock);
+
+	if (status != MV_OK) {
+		printk(KERN_ERR "%s: no RMU response on %s, using SMI\n", __func__, netdev->name);
+		mv_switch_rmu_stop();
+		rmu.rmuEn = MV_FALSE;
+		gsysSetRMUMode(dev, &rmu);
+	}
+
+	return status;
+}
+
+/*******************************************************************************
+* mv_switch_rmu_loopback_start - Run RMU over the software stand-in.
+*
+*******************************************************************************/
+MV_STATUS mv_switch_rmu_loopback_start(void)
+{
+	static const MV_U8	mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	MV_STATUS		status;
+
+	mv_switch_rmu_stop();
+
+	mutex_lock(&switch_rmu_lock);
+	status = mvSwitchRmuProbe(mvSwitchRmuLoopbackXmit, mac, qddev.devNum);
+	mutex_unlock(&switch_rmu_lock);
+
+	return status;
+}
+
+void mv_switch_rmu_stop(void)
+{
+	mutex_lock(&switch_rmu_lock);
+	switch_rmu.xmit = NULL;
+	if (switch_rmu.netdev) {
+		dev_remove_pack(&switch_rmu_packet);
+		dev_put(switch_rmu.netdev);
+		switch_rmu.netdev = NULL;
+	}
+	mutex_unlock(&switch_rmu_lock);
+}
+
+int mv_switch_rmu_show(char *buf)
+{
+	MV_SWITCH_RMU_STATS	*s = &switch_rmu.stats;
+	int			off;
+
+	/* the netdev is released by mv_switch_rmu_stop() under the lock */
+	mutex_lock(&switch_rmu_lock);
+	off = sprintf(buf, "rmu %s: requests %u responses %u timeouts %u errors %u fallbacks %u reg ops %u\n",
+		      switch_rmu.xmit == NULL ? "off" :
+		      (switch_rmu.netdev ? switch_rmu.netdev->name : "loopback"),
+		      s->requests, s->responses, s->timeouts, s->errors, s->fallbacks, s->rwOps);
+	mutex_unlock(&switch_rmu_lock);
+
+	return off;
+}
@@ -0,0 +1,649 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+
+/*
+ * Software model of the switch register files, used as an MDIO backend
+ * through GT_QD_DEV::fgtReadMii/fgtWriteMii (see mv_switch_sim_attach).
+ *
+ * Emulated: PHY register pages (0..MV_SWITCH_SIM_PHYS-1), port (0x10+p),
+ * Global (0x1b) and Global2 (0x1c) register files, the Global2 SMI PHY
+ * command unit and the ATU, VTU/STU, PVT and statistics engines including
+ * their busy bits. A started operation keeps its busy bit set for a
+ * configurable number of reads, so polling loops are exercised.
+ *
+ * The model has no hardware dependencies; callers serialize accesses (the
+ * driver calls it with switch_lock held).
+ *
+ * The model runs in the kernel, selected with the switch_sim module
+ * parameter: mv_switch_api.c and the sysfs benchmarks (atu_bench,
+ * queue_bench) then run on a board without the switch, and the SMI
+ * operation counts and latencies are read from smi_stats and sim. There is
+ * no userspace build of the driver; mv_switch.c and mv_switch_api.c rely on
+ * kernel locking, ktime and sysfs, and this tree carries no shims for them.
+ */
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/delay.h>
+#include <linux/errno.h>
+
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "mv_switch.h"
+
+#define MV_SWITCH_SIM_PHYS		8
+#define MV_SWITCH_SIM_PHY_PAGES		8
+#define MV_SWITCH_SIM_PORTS		MAX_SWITCH_PORT_NUM
+#define MV_SWITCH_SIM_ATU_SIZE		1024
+#define MV_SWITCH_SIM_VID_NUM		4096
+#define MV_SWITCH_SIM_SID_NUM		64
+#define MV_SWITCH_SIM_PVT_SIZE		512
+#define MV_SWITCH_SIM_COUNTERS		32
+
+#define SIM_G1				GLOBAL_REGS_START_ADDR_8PORT
+#define SIM_G2				(GLOBAL_REGS_START_ADDR_8PORT + 1)
+#define SIM_BUSY			0x8000
+#define SIM_OP(data)			(((data) >> 12) & 0x7)
+
+/* ATU entry states of locked (static) unicast entries */
+#define SIM_ATU_UC_STATIC		0xE
+#define SIM_ATU_UC_STATIC_MGMT		0xF
+
+enum {
+	SIM_UNIT_ATU,
+	SIM_UNIT_VTU,
+	SIM_UNIT_PVT,
+	SIM_UNIT_STATS,
+	SIM_UNIT_PHY,
+	SIM_UNIT_NUM
+};
+
+typedef struct {
+	MV_U16	dbNum;
+	MV_U8	mac[6];
+	MV_U8	state;
+	MV_U8	prio;
+	MV_U16	portVec;
+} MV_SWITCH_SIM_ATU_ENTRY;
+
+typedef struct {
+	MV_U8	valid;
+	MV_U8	sid;
+	MV_U16	fid;
+	MV_U16	data[3];
+} MV_SWITCH_SIM_VTU_ENTRY;
+
+static struct {
+	MV_U16			regs[32][32];
+	MV_U16			phy[MV_SWITCH_SIM_PHYS][MV_SWITCH_SIM_PHY_PAGES][32];
+	MV_SWITCH_SIM_ATU_ENTRY	atu[MV_SWITCH_SIM_ATU_SIZE];
+	MV_U32			atuEntries;
+	MV_SWITCH_SIM_VTU_ENTRY	vtu[MV_SWITCH_SIM_VID_NUM];
+	MV_SWITCH_SIM_VTU_ENTRY	stu[MV_SWITCH_SIM_SID_NUM];
+	MV_U16			pvt[MV_SWITCH_SIM_PVT_SIZE];
+	MV_U32			counters[MV_SWITCH_SIM_PORTS][MV_SWITCH_SIM_COUNTERS];
+	MV_U32			capturedPort;
+	MV_U32			busyPolls;
+	MV_U32			busyLeft[SIM_UNIT_NUM];
+	MV_U32			latencyNs;	/* added to every transaction */
+	MV_SWITCH_SIM_STATS	stats;
+} switch_sim;
+
+/*******************************************************************************
+* PHY model
+*******************************************************************************/
+static MV_U16 *mvSwitchSimPhyReg(MV_U32 phy, MV_U32 reg)
+{
+	MV_U32 page;
+
+	/* register 22 is the page select register, common to all pages */
+	page = (reg == QD_PHY_PAGE_ANY_REG) ? 0 :
+		(switch_sim.phy[phy][0][QD_PHY_PAGE_ANY_REG] & (MV_SWITCH_SIM_PHY_PAGES - 1));
+
+	return &switch_sim.phy[phy][page][reg];
+}
+
+static MV_U16 mvSwitchSimPhyRead(MV_U32 phy, MV_U32 reg)
+{
+	if (phy >= MV_SWITCH_SIM_PHYS)
+		return 0xFFFF;
+
+	return *mvSwitchSimPhyReg(phy, reg);
+}
+
+static void mvSwitchSimPhyWrite(MV_U32 phy, MV_U32 reg, MV_U16 data)
+{
+	if (phy >= MV_SWITCH_SIM_PHYS)
+		return;
+
+	/* software reset completes immediately */
+	if (reg == QD_PHY_CONTROL_REG)
+		data &= ~QD_PHY_RESET;
+
+	*mvSwitchSimPhyReg(phy, reg) = data;
+}
+
+/* Global2 SMI PHY command unit */
+static void mvSwitchSimPhyCmd(MV_U16 cmd)
+{
+	MV_U32 phy = (cmd >> QD_SMI_DEV_ADDR_BIT) & 0x1F;
+	MV_U32 reg = (cmd >> QD_SMI_REG_ADDR_BIT) & 0x1F;
+	MV_U32 op = (cmd >> QD_SMI_OP_BIT) & 0x3;
+
+	if (op == QD_SMI_WRITE)
+		mvSwitchSimPhyWrite(phy, reg, switch_sim.regs[SIM_G2][QD_REG_SMI_PHY_DATA]);
+	else if (op == QD_SMI_READ)
+		switch_sim.regs[SIM_G2][QD_REG_SMI_PHY_DATA] = mvSwitchSimPhyRead(phy, reg);
+
+	switch_sim.stats.phyOps++;
+}
+
+/*******************************************************************************
+* ATU model
+*******************************************************************************/
+static MV_BOOL mvSwitchSimAtuLocked(MV_SWITCH_SIM_ATU_ENTRY *e)
+{
+	/* multicast entries are always static */
+	if (e->mac[0] & 0x1)
+		return MV_TRUE;
+
+	return (e->state == SIM_ATU_UC_STATIC || e->state == SIM_ATU_UC_STATIC_MGMT) ? MV_TRUE : MV_FALSE;
+}
+
+static void mvSwitchSimAtuRemove(MV_U32 i)
+{
+	switch_sim.atu[i] = switch_sim.atu[--switch_sim.atuEntries];
+}
+
+static void mvSwitchSimAtuMacGet(MV_U8 *mac)
+{
+	MV_U32 i;
+
+	for (i = 0; i < 3; i++) {
+		mac[2 * i] = switch_sim.regs[SIM_G1][QD_REG_ATU_MAC_BASE + i] >> 8;
+		mac[2 * i + 1] = switch_sim.regs[SIM_G1][QD_REG_ATU_MAC_BASE + i] & 0xFF;
+	}
+}
+
+static void mvSwitchSimAtuMacSet(const MV_U8 *mac)
+{
+	MV_U32 i;
+
+	for (i = 0; i < 3; i++)
+		switch_sim.regs[SIM_G1][QD_REG_ATU_MAC_BASE + i] = (mac[2 * i] << 8) | mac[2 * i + 1];
+}
+
+static int mvSwitchSimAtuFind(MV_U16 dbNum, const MV_U8 *mac)
+{
+	MV_U32 i;
+
+	for (i = 0; i < switch_sim.atuEntries; i++)
+		if (switch_sim.atu[i].dbNum == dbNum && !memcmp(switch_sim.atu[i].mac, mac, 6))
+			return i;
+
+	return -1;
+}
+
+static void mvSwitchSimAtuLoadPurge(MV_U16 dbNum, MV_U16 data)
+{
+	MV_SWITCH_SIM_ATU_ENTRY	*e;
+	MV_U8			mac[6];
+	int			i;
+
+	mvSwitchSimAtuMacGet(mac);
+	i = mvSwitchSimAtuFind(dbNum, mac);
+
+	if ((data & 0xF) == 0) {
+		if (i >= 0)
+			mvSwitchSimAtuRemove(i);
+		return;
+	}
+
+	if (i < 0) {
+		if (switch_sim.atuEntries == MV_SWITCH_SIM_ATU_SIZE) {
+			/* full violation */
+			switch_sim.stats.atuFull++;
+			return;
+		}
+		i = switch_sim.atuEntries++;
+	}
+
+	e = &switch_sim.atu[i];
+	e->dbNum = dbNum;
+	memcpy(e->mac, mac, 6);
+	e->state = data & 0xF;
+	e->portVec = (data >> 4) & 0x7FF;
+	e->prio = (data >> 14) & 0x3;
+}
+
+static void mvSwitchSimAtuGetNext(MV_U16 dbNum)
+{
+	static const MV_U8	bcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	MV_SWITCH_SIM_ATU_ENTRY	*e, *best = NULL;
+	MV_U8			mac[6];
+	MV_BOOL			first;
+	MV_U32			i;
+
+	mvSwitchSimAtuMacGet(mac);
+	/* the broadcast address starts the walk */
+	first = memcmp(mac, bcast, 6) ? MV_FALSE : MV_TRUE;
+
+	for (i = 0; i < switch_sim.atuEntries; i++) {
+		e = &switch_sim.atu[i];
+		if (e->dbNum != dbNum)
+			continue;
+		if (!first && memcmp(e->mac, mac, 6) <= 0)
+			continue;
+		if (best == NULL || memcmp(e->mac, best->mac, 6) < 0)
+			best = e;
+	}
+
+	if (best == NULL) {
+		mvSwitchSimAtuMacSet(bcast);
+		switch_sim.regs[SIM_G1][QD_REG_ATU_DATA_REG] = 0;
+		return;
+	}
+
+	mvSwitchSimAtuMacSet(best->mac);
+	switch_sim.regs[SIM_G1][QD_REG_ATU_DATA_REG] =
+		(best->prio << 14) | (best->portVec << 4) | best->state;
+}
+
+static void mvSwitchSimAtuFlush(MV_U16 dbNum, MV_BOOL inDb, MV_BOOL all, MV_U16 data)
+{
+	MV_SWITCH_SIM_ATU_ENTRY	*e;
+	MV_U32			i = 0, from, to;
+
+	while (i < switch_sim.atuEntries) {
+		e = &switch_sim.atu[i];
+		if ((inDb && e->dbNum != dbNum) || (!all && mvSwitchSimAtuLocked(e))) {
+			i++;
+			continue;
+		}
+
+		if ((data & 0xF) != 0xF) {
+			mvSwitchSimAtuRemove(i);
+			continue;
+		}
+
+		/* move (or remove with To = 0xF) port From */
+		from = (data >> 4) & 0xF;
+		to = (data >> 8) & 0xF;
+		if (e->portVec & (1 << from)) {
+			e->portVec &= ~(1 << from);
+			if (to != 0xF)
+				e->portVec |= (1 << to);
+		}
+		if (e->portVec == 0 && !mvSwitchSimAtuLocked(e)) {
+			mvSwitchSimAtuRemove(i);
+			continue;
+		}
+		i++;
+	}
+}
+
+static void mvSwitchSimAtuOp(MV_U16 cmd)
+{
+	MV_U16 dbNum = switch_sim.regs[SIM_G1][QD_REG_ATU_FID_REG] & 0xFFF;
+	MV_U16 data = switch_sim.regs[SIM_G1][QD_REG_ATU_DATA_REG];
+
+	switch (SIM_OP(cmd)) {
+	case FLUSH_ALL:
+		mvSwitchSimAtuFlush(dbNum, MV_FALSE, MV_TRUE, data);
+		break;
+	case FLUSH_UNLOCKED:
+		mvSwitchSimAtuFlush(dbNum, MV_FALSE, MV_FALSE, data);
+		break;
+	case LOAD_PURGE_ENTRY:
+		mvSwitchSimAtuLoadPurge(dbNum, data);
+		break;
+	case GET_NEXT_ENTRY:
+		mvSwitchSimAtuGetNext(dbNum);
+		break;
+	case FLUSH_ALL_IN_DB:
+		mvSwitchSimAtuFlush(dbNum, MV_TRUE, MV_TRUE, data);
+		break;
+	case FLUSH_UNLOCKED_IN_DB:
+		mvSwitchSimAtuFlush(dbNum, MV_TRUE, MV_FALSE, data);
+		break;
+	default:
+		/* SERVICE_VIOLATIONS: the model raises none */
+		break;
+	}
+	switch_sim.stats.atuOps++;
+}
+
+/*******************************************************************************
+* VTU / STU model
+*******************************************************************************/
+static void mvSwitchSimVtuEntryGet(MV_SWITCH_SIM_VTU_ENTRY *e)
+{
+	e->data[0] = switch_sim.regs[SIM_G1][QD_REG_VTU_DATA1_REG];
+	e->data[1] = switch_sim.regs[SIM_G1][QD_REG_VTU_DATA2_REG];
+	e->data[2] = switch_sim.regs[SIM_G1][QD_REG_VTU_DATA3_REG];
+}
+
+static void mvSwitchSimVtuEntrySet(MV_SWITCH_SIM_VTU_ENTRY *e)
+{
+	switch_sim.regs[SIM_G1][QD_REG_VTU_DATA1_REG] = e->data[0];
+	switch_sim.regs[SIM_G1][QD_REG_VTU_DATA2_REG] = e->data[1];
+	switch_sim.regs[SIM_G1][QD_REG_VTU_DATA3_REG] = e->data[2];
+}
+
+static void mvSwitchSimVtuOp(MV_U16 cmd)
+{
+	MV_U16			*regs = switch_sim.regs[SIM_G1];
+	MV_U32			vid = regs[QD_REG_VTU_VID_REG] & 0xFFF;
+	MV_U32			sid = regs[QD_REG_STU_SID_REG] & 0x3F;
+	MV_U32			i, start;
+	MV_SWITCH_SIM_VTU_ENTRY	*e;
+
+	switch (SIM_OP(cmd)) {
+	case 1: /* flush all */
+		memset(switch_sim.vtu, 0, sizeof(switch_sim.vtu));
+		memset(switch_sim.stu, 0, sizeof(switch_sim.stu));
+		break;
+
+	case 3: /* VTU load / purge */
+		e = &switch_sim.vtu[vid];
+		e->valid = (regs[QD_REG_VTU_VID_REG] >> 12) & 1;
+		e->fid = regs[QD_REG_VTU_FID_REG] & 0xFFF;
+		e->sid = sid;
+		mvSwitchSimVtuEntryGet(e);
+		break;
+
+	case 4: /* VTU get next, 0xFFF starts the walk */
+		start = (vid == 0xFFF) ? 0 : vid + 1;
+		for (i = start; i < 0xFFF; i++)
+			if (switch_sim.vtu[i].valid)
+				break;
+		if (i >= 0xFFF) {
+			regs[QD_REG_VTU_VID_REG] = 0xFFF;
+			break;
+		}
+		e = &switch_sim.vtu[i];
+		regs[QD_REG_VTU_VID_REG] = (1 << 12) | i;
+		regs[QD_REG_VTU_FID_REG] = e->fid;
+		regs[QD_REG_STU_SID_REG] = e->sid;
+		mvSwitchSimVtuEntrySet(e);
+		break;
+
+	case 5: /* STU load / purge */
+		e = &switch_sim.stu[sid];
+		e->valid = (regs[QD_REG_VTU_VID_REG] >> 12) & 1;
+		mvSwitchSimVtuEntryGet(e);
+		break;
+
+	case 6: /* STU get next, 0x3F starts the walk */
+		start = (sid == 0x3F) ? 0 : sid + 1;
+		for (i = start; i < 0x3F; i++)
+			if (switch_sim.stu[i].valid)
+				break;
+		if (i >= 0x3F) {
+			regs[QD_REG_STU_SID_REG] = 0x3F;
+			regs[QD_REG_VTU_VID_REG] &= ~(1 << 12);
+			break;
+		}
+		regs[QD_REG_STU_SID_REG] = i;
+		regs[QD_REG_VTU_VID_REG] |= (1 << 12);
+		mvSwitchSimVtuEntrySet(&switch_sim.stu[i]);
+		break;
+
+	default:
+		/* violations: the model raises none */
+		break;
+	}
+	switch_sim.stats.vtuOps++;
+}
+
+/*******************************************************************************
+* PVT and statistics model
+*******************************************************************************/
+static void mvSwitchSimPvtOp(MV_U16 cmd)
+{
+	MV_U32 addr = cmd & (MV_SWITCH_SIM_PVT_SIZE - 1);
+	MV_U32 i;
+
+	switch (SIM_OP(cmd)) {
+	case PVT_INITIALIZE:
+		for (i = 0; i < MV_SWITCH_SIM_PVT_SIZE; i++)
+			switch_sim.pvt[i] = 0x7FF;
+		break;
+	case PVT_WRITE:
+		switch_sim.pvt[addr] = switch_sim.regs[SIM_G2][QD_REG_PVT_DATA] & 0x7FF;
+		break;
+	case PVT_READ:
+		switch_sim.regs[SIM_G2][QD_REG_PVT_DATA] = switch_sim.pvt[addr];
+		break;
+	default:
+		break;
+	}
+	switch_sim.stats.pvtOps++;
+}
+
+static void mvSwitchSimStatsOp(MV_U16 cmd)
+{
+	MV_U32 port = ((cmd >> 5) & 0x1F);
+	MV_U32 value;
+
+	switch (SIM_OP(cmd)) {
+	case GT_STATS_FLUSH_ALL:
+		memset(switch_sim.counters, 0, sizeof(switch_sim.counters));
+		break;
+	case GT_STATS_FLUSH_PORT:
+		if (port > 0 && port <= MV_SWITCH_SIM_PORTS)
+			memset(switch_sim.counters[port - 1], 0, sizeof(switch_sim.counters[0]));
+		break;
+	case GT_STATS_CAPTURE_PORT:
+		switch_sim.capturedPort = (port > 0 && port <= MV_SWITCH_SIM_PORTS) ? port - 1 : 0;
+		break;
+	case GT_STATS_READ_COUNTER:
+		value = switch_sim.counters[switch_sim.capturedPort][cmd & (MV_SWITCH_SIM_COUNTERS - 1)];
+		switch_sim.regs[SIM_G1][QD_REG_STATS_COUNTER3_2] = value >> 16;
+		switch_sim.regs[SIM_G1][QD_REG_STATS_COUNTER1_0] = value & 0xFFFF;
+		break;
+	default:
+		break;
+	}
+	switch_sim.stats.statsOps++;
+}
+
+/* Maps a command register to its engine, -1 for plain registers */
+static int mvSwitchSimUnit(MV_U32 phyAddr, MV_U32 reg)
+{
+	if (phyAddr == SIM_G1) {
+		if (reg == QD_REG_ATU_OPERATION)
+			return SIM_UNIT_ATU;
+		if (reg == QD_REG_VTU_OPERATION)
+			return SIM_UNIT_VTU;
+		if (reg == QD_REG_STATS_OPERATION)
+			return SIM_UNIT_STATS;
+	} else if (phyAddr == SIM_G2) {
+		if (reg == QD_REG_PVT_ADDR)
+			return SIM_UNIT_PVT;
+		if (reg == QD_REG_SMI_PHY_CMD)
+			return SIM_UNIT_PHY;
+	}
+	return -1;
+}
+
+/*******************************************************************************
+* mv_switch_sim_read_mii / mv_switch_sim_write_mii
+*
+* DESCRIPTION:
+*       FGT_READ_MII / FGT_WRITE_MII implementations over the register model.
+*       Reading a command register whose operation is still "in progress"
+*       returns it with the busy bit set.
+*
+*******************************************************************************/
+MV_BOOL mv_switch_sim_read_mii(GT_QD_DEV *dev, unsigned int phyAddr, unsigned int miiReg,
+			       unsigned int *value)
+{
+	int unit;
+
+	if (phyAddr > 0x1F || miiReg > 0x1F)
+		return MV_FALSE;
+
+	switch_sim.stats.reads++;
+	if (switch_sim.latencyNs)
+		ndelay(switch_sim.latencyNs);
+
+	if (phyAddr < PORT_REGS_START_ADDR_8PORT) {
+		*value = mvSwitchSimPhyRead(phyAddr, miiReg);
+		return MV_TRUE;
+	}
+
+	*value = switch_sim.regs[phyAddr][miiReg];
+	unit = mvSwitchSimUnit(phyAddr, miiReg);
+	if (unit >= 0 && switch_sim.busyLeft[unit]) {
+		switch_sim.busyLeft[unit]--;
+		switch_sim.stats.busyReads++;
+		*value |= SIM_BUSY;
+	}
+
+	return MV_TRUE;
+}
+
+MV_BOOL mv_switch_sim_write_mii(GT_QD_DEV *dev, unsigned int phyAddr, unsigned int miiReg,
+				unsigned int value)
+{
+	int unit;
+
+	if (phyAddr > 0x1F || miiReg > 0x1F)
+		return MV_FALSE;
+
+	switch_sim.stats.writes++;
+	if (switch_sim.latencyNs)
+		ndelay(switch_sim.latencyNs);
+
+	if (phyAddr < PORT_REGS_START_ADDR_8PORT) {
+		mvSwitchSimPhyWrite(phyAddr, miiReg, (MV_U16)value);
+		return MV_TRUE;
+	}
+
+	unit = mvSwitchSimUnit(phyAddr, miiReg);
+	if (unit < 0 || !(value & SIM_BUSY)) {
+		switch_sim.regs[phyAddr][miiReg] = (MV_U16)value;
+		return MV_TRUE;
+	}
+
+	/* a command register written with busy set starts an operation */
+	switch_sim.regs[phyAddr][miiReg] = (MV_U16)value & ~SIM_BUSY;
+	switch_sim.busyLeft[unit] = switch_sim.busyPolls;
+
+	switch (unit) {
+	case SIM_UNIT_ATU:
+		mvSwitchSimAtuOp((MV_U16)value);
+		break;
+	case SIM_UNIT_VTU:
+		mvSwitchSimVtuOp((MV_U16)value);
+		break;
+	case SIM_UNIT_PVT:
+		mvSwitchSimPvtOp((MV_U16)value);
+		break;
+	case SIM_UNIT_STATS:
+		mvSwitchSimStatsOp((MV_U16)value);
+		break;
+	default:
+		mvSwitchSimPhyCmd((MV_U16)value);
+		break;
+	}
+
+	return MV_TRUE;
+}
+
+/*******************************************************************************
+* mv_switch_sim_reset - Reset the register model.
+*
+* INPUT:
+*       busyPolls - number of reads a started operation reports busy.
+*
+*******************************************************************************/
+void mv_switch_sim_reset(MV_U32 busyPolls)
+{
+	MV_U32 p, latencyNs = switch_sim.latencyNs;
+
+	memset(&switch_sim, 0, sizeof(switch_sim));
+	switch_sim.busyPolls = busyPolls;
+	switch_sim.latencyNs = latencyNs;
+
+	/* switch identifier of an 88E6172, port state forwarding */
+	for (p = 0; p < MV_SWITCH_SIM_PORTS; p++) {
+		switch_sim.regs[PORT_REGS_START_ADDR_8PORT + p][QD_REG_SWITCH_ID] = 0x1720;
+		switch_sim.regs[PORT_REGS_START_ADDR_8PORT + p][QD_REG_PORT_CONTROL] = 0x3;
+	}
+	for (p = 0; p < MV_SWITCH_SIM_PHYS; p++)
+		switch_sim.phy[p][0][QD_PHY_CONTROL_REG] = QD_PHY_AUTONEGO | QD_PHY_SPEED | QD_PHY_DUPLEX;
+}
+
+/*******************************************************************************
+* mv_switch_sim_attach - Use the register model as the device MDIO backend.
+*
+*******************************************************************************/
+void mv_switch_sim_attach(GT_QD_DEV *dev, MV_U32 busyPolls)
+{
+	mv_switch_sim_reset(busyPolls);
+	dev->fgtReadMii = mv_switch_sim_read_mii;
+	dev->fgtWriteMii = mv_switch_sim_write_mii;
+}
+
+/*******************************************************************************
+* mv_switch_sim_latency_set - Model the cost of an SMI transaction.
+*
+* INPUT:
+*       ns - busy-wait time added to every register read and write, up to
+*            MV_SWITCH_SIM_LATENCY_MAX. Kept over mv_switch_sim_reset.
+*
+*******************************************************************************/
+int mv_switch_sim_latency_set(MV_U32 ns)
+{
+	if (ns > MV_SWITCH_SIM_LATENCY_MAX)
+		return -EINVAL;
+
+	switch_sim.latencyNs = ns;
+	return 0;
+}
+
+void mv_switch_sim_stats_get(MV_SWITCH_SIM_STATS *stats)
+{
+	*stats = switch_sim.stats;
+}
+
+int mv_switch_sim_show(char *buf)
+{
+	MV_SWITCH_SIM_STATS	*s = &switch_sim.stats;
+	int			off = 0;
+
+	off += sprintf(buf + off, "switch register model: %u reads, %u writes, %u busy reads, %u ns/transaction\n",
+		       s->reads, s->writes, s->busyReads, switch_sim.latencyNs);
+	off += sprintf(buf + off, "  operations: atu %u, vtu %u, pvt %u, stats %u, phy %u\n",
+		       s->atuOps, s->vtuOps, s->pvtOps, s->statsOps, s->phyOps);
+	off += sprintf(buf + off, "  atu entries %u (full %u)\n", switch_sim.atuEntries, s->atuFull);
+
+	return off;
+}
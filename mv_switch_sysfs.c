@@ -41,6 +41,27 @@ disclaimer.
 #include "mv_switch.h"
 #include "dsdt/msApiPrototype.h"
 
+extern GT_QD_DEV qddev;
+
+/* port whose MIB counters 'cat mib' shows */
+static int mv_switch_mib_port;
+
+static int mv_switch_mib_show(char *buf)
+{
+	MV_U32	counters[MV_SWITCH_MIB_COUNTERS];
+	int	i, off = 0;
+
+	if (mv_switch_mib_dump(&qddev, mv_switch_mib_port, counters) != MV_OK)
+		return -EIO;
+
+	off += sprintf(buf + off, "port %d MIB counters:\n", mv_switch_mib_port);
+	for (i = 0; i < MV_SWITCH_MIB_COUNTERS; i++)
+		off += sprintf(buf + off, "  %2d: %10u%s", i, counters[i], (i % 4 == 3) ? "\n" : "");
+	if (i % 4)
+		buf[off++] = '\n';
+
+	return off;
+}
 
 static ssize_t mv_switch_help(char *buf)
 {
@@ -49,13 +70,40 @@ static ssize_t mv_switch_help(char *buf)
 	off += sprintf(buf+off, "cat help                            - show this help\n");
 	off += sprintf(buf+off, "cat stats                           - show statistics for switch all ports info\n");
 	off += sprintf(buf+off, "cat status                          - show switch status\n");
+	off += sprintf(buf+off, "cat sim                             - show software register model counters\n");
+	off += sprintf(buf+off, "cat smi_stats                       - show SMI counters and log2(us) latency histograms\n");
+	off += sprintf(buf+off, "cat rmu                             - show Remote Management Unit state and counters\n");
+	off += sprintf(buf+off, "cat queue                           - show asynchronous register queue counters and latency\n");
+	off += sprintf(buf+off, "cat atu_mirror                      - show ATU mirror and resync counters\n");
+	off += sprintf(buf+off, "cat atu_events                      - show ATU violation event counters\n");
+	off += sprintf(buf+off, "cat atu_stats                       - show ATU occupancy, learn counts and samples\n");
+	off += sprintf(buf+off, "cat atu_aging                       - show adaptive ATU aging timeout and decisions\n");
+	off += sprintf(buf+off, "cat atu_engine                      - show ATU command timeouts and recoveries\n");
+	off += sprintf(buf+off, "cat vtu                             - show VTU mirror, update counters and VLANs\n");
+	off += sprintf(buf+off, "cat pvt                             - show cross chip port VLAN table command counters\n");
+	off += sprintf(buf+off, "cat stu                             - show MSTP instance port states and counters\n");
+	off += sprintf(buf+off, "cat mib                             - show MIB counters of the selected port (RMU, SMI fallback)\n");
 #ifdef CONFIG_MV_ETH_SWITCH
 	off += sprintf(buf+off, "echo <eth_name>   > netdev_sts      - print network device status\n");
 	off += sprintf(buf+off, "echo <eth_name> p > port_add        - map switch port to a network device\n");
 	off += sprintf(buf+off, "echo <eth_name> p > port_del        - unmap switch port from a network device\n");
+	off += sprintf(buf+off, "echo <eth_name>   > rmu_netdev      - access the switch through RMU frames on a network device\n");
 #endif /* CONFIG_MV_ETH_SWITCH */
 	off += sprintf(buf+off, "echo p r t   > reg_r                - read switch register.  t: 1-phy, 2-port, 3-global, 4-global2, 5-smi\n");
 	off += sprintf(buf+off, "echo p r t v > reg_w                - write switch register. t: 1-phy, 2-port, 3-global, 4-global2, 5-smi\n");
+	off += sprintf(buf+off, "echo p r t v > reg_w_async          - queue a switch register write, t as for reg_w except 5\n");
+	off += sprintf(buf+off, "echo n       > queue_bench          - time n queued register reads\n");
+	off += sprintf(buf+off, "cat queue_bench                     - show the report of the last queue benchmark\n");
+	off += sprintf(buf+off, "echo n r ns  > atu_bench            - time ATU operations on n entries r times, ns per SMI (switch_sim=1)\n");
+	off += sprintf(buf+off, "cat atu_bench                       - show the report of the last ATU benchmark\n");
+	off += sprintf(buf+off, "echo p r n   > phy_bench            - time n direct vs. indirect (Global2) reads of phy p register r\n");
+	off += sprintf(buf+off, "cat phy_bench                       - show the report of the last phy benchmark\n");
+	off += sprintf(buf+off, "echo 0       > smi_stats            - clear SMI counters\n");
+	off += sprintf(buf+off, "echo 0|1     > rmu                  - stop RMU access / start it over the loopback stand-in\n");
+	off += sprintf(buf+off, "echo p       > mib                  - select port p for cat mib\n");
+	off += sprintf(buf+off, "echo irq     > atu_events           - service ATU violations from the switch interrupt line irq\n");
+	off += sprintf(buf+off, "echo min max > atu_aging            - adapt ATU aging timeout within [min, max] seconds, 0 - fixed default\n");
+	off += sprintf(buf+off, "echo sid p s > stu                  - set port p state in MSTP instance sid. s: 0-disabled, 1-blocking, 2-learning, 3-forwarding\n");
 	return off;
 }
 
@@ -71,6 +119,38 @@ static ssize_t mv_switch_show(struct device *dev, struct device_attribute *attr,
 		//mv_switch_stats_print();
 	}else if (!strcmp(name, "status")){
 		//mv_switch_status_print();
+	}else if (!strcmp(name, "sim")){
+		off = mv_switch_sim_show(buf);
+	}else if (!strcmp(name, "smi_stats")){
+		off = mv_switch_smi_stats_show(buf);
+	}else if (!strcmp(name, "rmu")){
+		off = mv_switch_rmu_show(buf);
+	}else if (!strcmp(name, "queue")){
+		off = mv_switch_queue_show(buf);
+	}else if (!strcmp(name, "atu_mirror")){
+		off = mv_switch_atu_mirror_show(buf);
+	}else if (!strcmp(name, "atu_events")){
+		off = mv_switch_atu_event_show(buf);
+	}else if (!strcmp(name, "atu_stats")){
+		off = mv_switch_atu_stats_show(buf);
+	}else if (!strcmp(name, "atu_aging")){
+		off = mv_switch_atu_aging_show(buf);
+	}else if (!strcmp(name, "atu_engine")){
+		off = mv_switch_atu_cmd_show(buf);
+	}else if (!strcmp(name, "vtu")){
+		off = mv_switch_vtu_show(buf);
+	}else if (!strcmp(name, "pvt")){
+		off = mv_switch_pvt_show(buf);
+	}else if (!strcmp(name, "stu")){
+		off = mv_switch_stu_show(buf);
+	}else if (!strcmp(name, "mib")){
+		off = mv_switch_mib_show(buf);
+	}else if (!strcmp(name, "atu_bench")){
+		off = mv_switch_atu_bench_show(buf);
+	}else if (!strcmp(name, "queue_bench")){
+		off = mv_switch_queue_bench_show(buf);
+	}else if (!strcmp(name, "phy_bench")){
+		off = mv_switch_phy_bench_show(buf);
 	}else
 		off = mv_switch_help(buf);
 
@@ -80,7 +160,6 @@ static ssize_t mv_switch_show(struct device *dev, struct device_attribute *attr,
 static ssize_t mv_switch_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t len)
 {
 	const char      *name = attr->attr.name;
-	unsigned long   flags;
 	int             err, port, reg, type;
 	unsigned int    v;
 	unsigned int    val;
@@ -88,16 +167,58 @@ static ssize_t mv_switch_store(struct device *dev, struct device_attribute *attr
 	if (!capable(CAP_NET_ADMIN))
 		return -EPERM;
 
+	if (!strcmp(name, "smi_stats")) {
+		mv_switch_smi_stats_clear();
+		return len;
+	}
+
 	/* Read arguments */
 	err = port = reg = type = val = 0;
 	sscanf(buf, "%d %d %d %x", &port, &reg, &type, &v);
 
-	local_irq_save(flags);
 	if (!strcmp(name, "reg_r")) {
 		err = mv_switch_reg_read(port, reg, type, &val);
 	} else if (!strcmp(name, "reg_w")) {
 		val = (MV_U16)v;
 		err = mv_switch_reg_write(port, reg, type, v);
+	} else if (!strcmp(name, "phy_bench")) {
+		/* third argument is the read count */
+		err = mv_switch_phy_bench(port, reg, type);
+		return err ? err : len;
+	} else if (!strcmp(name, "reg_w_async")) {
+		err = mv_switch_reg_write_async(port, reg, type, v);
+		return err ? err : len;
+	} else if (!strcmp(name, "atu_events")) {
+		/* first argument is the interrupt line */
+		return mv_switch_atu_irq_init(port) ? -EINVAL : len;
+	} else if (!strcmp(name, "atu_aging")) {
+		/* arguments are the timeout bounds in seconds */
+		return mv_switch_atu_aging_set(port, reg) ? -EINVAL : len;
+	} else if (!strcmp(name, "stu")) {
+		/* arguments are the instance, the port and the state */
+		if (port < 0 || port >= MV_SWITCH_STU_SIDS)
+			return -EINVAL;
+		err = mv_switch_mstp_state_set((MV_U8)port, reg, type);
+		return err ? err : len;
+	} else if (!strcmp(name, "atu_bench")) {
+		/* arguments are the entry count, rounds and SMI latency in ns */
+		err = mv_switch_atu_bench(port, reg, type);
+		return err ? err : len;
+	} else if (!strcmp(name, "queue_bench")) {
+		/* first argument is the operation count */
+		err = mv_switch_queue_bench(port);
+		return err ? err : len;
+	} else if (!strcmp(name, "rmu")) {
+		if (port == 0) {
+			mv_switch_rmu_stop();
+			return len;
+		}
+		return (mv_switch_rmu_loopback_start() == MV_OK) ? len : -EIO;
+	} else if (!strcmp(name, "mib")) {
+		if (port < 0 || port >= MAX_SWITCH_PORT_NUM)
+			return -EINVAL;
+		mv_switch_mib_port = port;
+		return len;
 	}
 	printk(KERN_ERR "switch register access: type=%d, port=%d, reg=%d", type, port, reg);
 
@@ -106,8 +227,6 @@ static ssize_t mv_switch_store(struct device *dev, struct device_attribute *attr
 	else
 		printk(KERN_ERR " - SUCCESS, val=0x%04x\n", val);
 
-	local_irq_restore(flags);
-
 	return err ? -EINVAL : len;
 }
 
@@ -134,6 +253,8 @@ static ssize_t mv_switch_netdev_store(struct device *dev, struct device_attribut
 			err = mv_eth_switch_port_add(netdev, port);
 		else if (!strcmp(name, "port_del"))
 			err = mv_eth_switch_port_del(netdev, port);
+		else if (!strcmp(name, "rmu_netdev"))
+			err = mv_switch_rmu_netdev_start(&qddev, netdev);
 
 		dev_put(netdev);
 	}
@@ -152,10 +273,28 @@ static DEVICE_ATTR(reg_w,       S_IWUSR, mv_switch_show, mv_switch_store);
 static DEVICE_ATTR(status,      S_IRUSR, mv_switch_show, mv_switch_store);
 static DEVICE_ATTR(stats,       S_IRUSR, mv_switch_show, mv_switch_store);
 static DEVICE_ATTR(help,        S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(phy_bench,   S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(sim,         S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(smi_stats,   S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(rmu,         S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(mib,         S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(queue,       S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(atu_mirror,  S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(atu_events,  S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(atu_stats,   S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(atu_aging,   S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(atu_engine,  S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(vtu,         S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(pvt,         S_IRUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(stu,         S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(queue_bench, S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(atu_bench,   S_IRUSR | S_IWUSR, mv_switch_show, mv_switch_store);
+static DEVICE_ATTR(reg_w_async, S_IWUSR, mv_switch_show, mv_switch_store);
 #ifdef CONFIG_MV_ETH_SWITCH
 static DEVICE_ATTR(netdev_sts,  S_IWUSR, mv_switch_show, mv_switch_netdev_store);
 static DEVICE_ATTR(port_add,    S_IWUSR, mv_switch_show, mv_switch_netdev_store);
 static DEVICE_ATTR(port_del,    S_IWUSR, mv_switch_show, mv_switch_netdev_store);
+static DEVICE_ATTR(rmu_netdev,  S_IWUSR, mv_switch_show, mv_switch_netdev_store);
 #endif /* CONFIG_MV_ETH_SWITCH */
 
 static struct attribute *mv_switch_attrs[] = {
@@ -164,10 +303,28 @@ static struct attribute *mv_switch_attrs[] = {
 	&dev_attr_status.attr,
 	&dev_attr_stats.attr,
 	&dev_attr_help.attr,
+	&dev_attr_phy_bench.attr,
+	&dev_attr_sim.attr,
+	&dev_attr_smi_stats.attr,
+	&dev_attr_rmu.attr,
+	&dev_attr_mib.attr,
+	&dev_attr_queue.attr,
+	&dev_attr_atu_mirror.attr,
+	&dev_attr_atu_events.attr,
+	&dev_attr_atu_stats.attr,
+	&dev_attr_atu_aging.attr,
+	&dev_attr_atu_engine.attr,
+	&dev_attr_vtu.attr,
+	&dev_attr_pvt.attr,
+	&dev_attr_stu.attr,
+	&dev_attr_queue_bench.attr,
+	&dev_attr_atu_bench.attr,
+	&dev_attr_reg_w_async.attr,
 #ifdef CONFIG_MV_ETH_SWITCH
 	&dev_attr_netdev_sts.attr,
 	&dev_attr_port_add.attr,
 	&dev_attr_port_del.attr,
+	&dev_attr_rmu_netdev.attr,
 #endif /* CONFIG_MV_ETH_SWITCH */
 	NULL
 };
@@ -178,7 +335,6 @@ static struct attribute_group mv_switch_group = {
 };
 
 static dev_t  base_dev;
-extern GT_QD_DEV qddev; 
 
 
 char* mv_str_speed_state(int port)
@@ -261,17 +417,46 @@ static ssize_t mv_link_power_show(struct device *dev,
 				  char *buf)
 {
     int port_no = MINOR(dev->devt) - MINOR(base_dev);
+    MV_BOOL on;
  
     if (!capable(CAP_NET_ADMIN))
   	return -EPERM;
            
-    return sprintf(buf, "%d\n", gprtPortPowerGet(&qddev, (GT_LPORT) port_no));
+    if (gprtPortPowerGet(&qddev, (GT_LPORT) port_no, &on) != MV_OK)
+        return -EIO;
+    return sprintf(buf, "%d\n", on ? 1 : 0);
+}
+
+static ssize_t mv_learn_limit_set(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t len)
+{
+    int port_no = MINOR(dev->devt) - MINOR(base_dev);
+
+    if (!capable(CAP_NET_ADMIN))
+  	return -EPERM;
+
+    return mv_switch_port_learn_limit_set(port_no, simple_strtoul(buf, NULL, 10)) ? -EINVAL : len;
+}
+
+static ssize_t mv_learn_limit_show(struct device *dev,
+				   struct device_attribute *attr,
+				   char *buf)
+{
+    int port_no = MINOR(dev->devt) - MINOR(base_dev);
+
+    if (!capable(CAP_NET_ADMIN))
+  	return -EPERM;
+
+    return mv_switch_port_learn_limit_show(port_no, buf);
 }
 
 static struct device_attribute neta_switch[] = {
 	__ATTR(carrier, S_IRUGO, mv_carrier_show, NULL),
 	/*can not __ATTR(power) because linux default create the power, can not duplicate */
 	__ATTR(power_config, S_IRUSR | S_IWUSR, mv_link_power_show, mv_link_power_set),
+	/* ATU learn limit, 0 = none; shows the learn count and over limit events */
+	__ATTR(learn_limit, S_IRUSR | S_IWUSR, mv_learn_limit_show, mv_learn_limit_set),
 	NULL
 };
 
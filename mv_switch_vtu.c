@@ -0,0 +1,868 @@
+/*******************************************************************************
+Copyright (C) Marvell International Ltd. and its affiliates
+
+This software file (the "File") is owned and distributed by Marvell
+International Ltd. and/or its affiliates ("Marvell") under the following
+alternative licensing terms.  Once you have made an election to distribute the
+File under one of the following license alternatives, please (i) delete this
+introductory statement regarding license alternatives, (ii) delete the two
+license alternatives that you have not elected to use and (iii) preserve the
+Marvell copyright notice above.
+
+********************************************************************************
+Marvell GPL License Option
+
+If you received this File from Marvell, you may opt to use, redistribute and/or
+modify this File in accordance with the terms and conditions of the General
+Public License Version 2, June 1991 (the "GPL License"), a copy of which is
+available along with the File in the license.txt file or by writing to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 or
+on the worldwide web at http://www.gnu.org/licenses/gpl.txt.
+
+THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE IMPLIED
+WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE ARE EXPRESSLY
+DISCLAIMED.  The GPL License provides additional details about this warranty
+disclaimer.
+*******************************************************************************/
+/*
+ * VTU mirror and VLAN table updates.
+ *
+ * Each VID is kept in an 8-byte MV_SWITCH_VLAN (port bitmap, 2-bit egress
+ * mode per port, DBNum, SID, priority) and the VIDs in use in a bitmap. The
+ * mirror is read from the switch once at init (mv_switch_vtu_sync) and kept
+ * current by gvtuLoadEntries() and gvtuFlush().
+ *
+ * Updates are diffed against the mirror: mv_switch_vtu_push() takes a whole
+ * VLAN table, derives the VIDs to purge and to load with bitmap operations
+ * and compares the VIDs present on both sides word by word, so only VIDs
+ * whose membership, tagging or attributes change reach the switch. The
+ * loads are issued in VID order, MV_SWITCH_VTU_LOAD_CHUNK per register
+ * list, so that neighbouring VIDs with the same ports also share their
+ * data register writes.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/bitops.h>
+#include "common/mvTypes.h"
+#include "dsdt/gtDrvSwRegs.h"
+#include "dsdt/msApiDefs.h"
+#include "dsdt/msApiPrototype.h"
+#include "mv_switch.h"
+
+extern GT_QD_DEV qddev;
+
+static MV_SWITCH_VLAN_MAP		switch_vtu_mirror;
+static DEFINE_SPINLOCK(switch_vtu_mirror_lock);
+static MV_SWITCH_VTU_STATS		switch_vtu_stats;
+static const MV_SWITCH_VLAN		switch_vlan_none;
+
+/* STU copy, see MSTP instances below; under switch_vtu_mirror_lock too */
+static struct {
+	DECLARE_BITMAP(valid, MV_SWITCH_STU_SIDS);
+	MV_U16	states[MV_SWITCH_STU_SIDS];	/* GT_PORT_STP_STATE of each port, 2 bits */
+} switch_stu_mirror;
+static MV_SWITCH_STU_STATS		switch_stu_stats;
+
+/* serializes the updates; the batch, the delta bitmaps and the scratch map are used under it */
+static DEFINE_MUTEX(switch_vtu_lock);
+static GT_VTU_ENTRY			switch_vtu_batch[MV_SWITCH_VTU_LOAD_CHUNK];
+static DECLARE_BITMAP(switch_vtu_load, MV_SWITCH_VTU_VIDS);
+static DECLARE_BITMAP(switch_vtu_purge, MV_SWITCH_VTU_VIDS);
+static DECLARE_BITMAP(switch_vtu_both, MV_SWITCH_VTU_VIDS);
+static MV_SWITCH_VLAN_MAP		switch_vtu_scratch;
+
+static void mvSwitchVlanPack(GT_VTU_ENTRY *entry, MV_SWITCH_VLAN *vlan)
+{
+	MV_U8	tag;
+	int	p;
+
+	memset(vlan, 0, sizeof(MV_SWITCH_VLAN));
+	vlan->fid = entry->DBNum & 0xFFF;
+	if (entry->vidPolicy)
+		vlan->fid |= MV_SWITCH_VLAN_POLICY;
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++) {
+		tag = entry->vtuData.memberTagP[p] & 0x3;
+		if (tag == NOT_A_MEMBER)
+			continue;
+		vlan->members |= (1 << p);
+		vlan->egress |= tag << (2 * p);
+	}
+	vlan->sid = entry->sid & 0x3F;
+	if (entry->vidPriOverride)
+		vlan->prio = MV_SWITCH_VLAN_PRI_OVERRIDE | (entry->vidPriority & 0x7);
+}
+
+static void mvSwitchVlanUnpack(MV_U16 vid, const MV_SWITCH_VLAN *vlan, GT_VTU_ENTRY *entry)
+{
+	int p;
+
+	memset(entry, 0, sizeof(GT_VTU_ENTRY));
+	entry->vid = vid;
+	entry->DBNum = vlan->fid & 0xFFF;
+	entry->vidPolicy = (vlan->fid & MV_SWITCH_VLAN_POLICY) ? MV_TRUE : MV_FALSE;
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		entry->vtuData.memberTagP[p] = (vlan->members & (1 << p)) ?
+					       ((vlan->egress >> (2 * p)) & 0x3) : NOT_A_MEMBER;
+	entry->sid = vlan->sid;
+	entry->vidPriOverride = (vlan->prio & MV_SWITCH_VLAN_PRI_OVERRIDE) ? MV_TRUE : MV_FALSE;
+	entry->vidPriority = vlan->prio & 0x7;
+}
+
+/* Port bitmap of the 2-bit lanes of x that are not 0 */
+static inline MV_U8 mvSwitchVlanLanes(MV_U16 x)
+{
+	x = (x | (x >> 1)) & 0x5555;
+	x = (x | (x >> 1)) & 0x3333;
+	x = (x | (x >> 2)) & 0x0F0F;
+	x = (x | (x >> 4)) & 0x00FF;
+	return (MV_U8)x;
+}
+
+/*
+ * Compare the VTU entry of a VID (switch_vlan_none if absent) with the
+ * wanted one and count the ports joining, leaving and retagged.
+ */
+static MV_BOOL mvSwitchVlanDelta(const MV_SWITCH_VLAN *cur, const MV_SWITCH_VLAN *want)
+{
+	if (!memcmp(cur, want, sizeof(MV_SWITCH_VLAN)))
+		return MV_FALSE;
+
+	switch_vtu_stats.joins += hweight8(want->members & ~cur->members);
+	switch_vtu_stats.leaves += hweight8(cur->members & ~want->members);
+	switch_vtu_stats.retags += hweight8(cur->members & want->members &
+					    mvSwitchVlanLanes(cur->egress ^ want->egress));
+	return MV_TRUE;
+}
+
+void mv_switch_vlan_map_clear(MV_SWITCH_VLAN_MAP *map)
+{
+	bitmap_zero(map->vids, MV_SWITCH_VTU_VIDS);
+}
+
+int mv_switch_vlan_map_add(MV_SWITCH_VLAN_MAP *map, GT_VTU_ENTRY *entry)
+{
+	if (entry->vid >= 0xFFF)
+		return -EINVAL;
+
+	mvSwitchVlanPack(entry, &map->vlan[entry->vid]);
+	__set_bit(entry->vid, map->vids);
+	return 0;
+}
+
+void mv_switch_vlan_map_del(MV_SWITCH_VLAN_MAP *map, MV_U16 vid)
+{
+	if (vid < MV_SWITCH_VTU_VIDS)
+		__clear_bit(vid, map->vids);
+}
+
+MV_BOOL mv_switch_vlan_map_entry(MV_SWITCH_VLAN_MAP *map, MV_U16 vid, GT_VTU_ENTRY *entry)
+{
+	if (vid >= MV_SWITCH_VTU_VIDS || !test_bit(vid, map->vids))
+		return MV_FALSE;
+	if (entry)
+		mvSwitchVlanUnpack(vid, &map->vlan[vid], entry);
+	return MV_TRUE;
+}
+
+/* Apply an entry loaded (or purged) by gvtuLoadEntries, under vtuRegsSem */
+void mv_switch_vtu_mirror_op(GT_VTU_ENTRY *entry, MV_BOOL purge)
+{
+	MV_U16 vid = entry->vid & 0xFFF;
+
+	spin_lock(&switch_vtu_mirror_lock);
+	if (purge) {
+		if (test_and_clear_bit(vid, switch_vtu_mirror.vids))
+			switch_vtu_stats.entries--;
+	} else {
+		mvSwitchVlanPack(entry, &switch_vtu_mirror.vlan[vid]);
+		if (!test_and_set_bit(vid, switch_vtu_mirror.vids))
+			switch_vtu_stats.entries++;
+	}
+	spin_unlock(&switch_vtu_mirror_lock);
+}
+
+static void mvSwitchVtuMirrorClear(void)
+{
+	spin_lock(&switch_vtu_mirror_lock);
+	bitmap_zero(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS);
+	switch_vtu_stats.entries = 0;
+	spin_unlock(&switch_vtu_mirror_lock);
+}
+
+/* The VTU and the STU were flushed (gvtuFlush) */
+void mv_switch_vtu_mirror_flush(void)
+{
+	mvSwitchVtuMirrorClear();
+
+	spin_lock(&switch_vtu_mirror_lock);
+	bitmap_zero(switch_stu_mirror.valid, MV_SWITCH_STU_SIDS);
+	switch_stu_stats.instances = 0;
+	spin_unlock(&switch_vtu_mirror_lock);
+}
+
+/*******************************************************************************
+* mv_switch_vtu_get - Look a VID up in the mirror.
+*
+* RETURN:
+*       MV_TRUE and the entry if the VTU holds the VID.
+*
+*******************************************************************************/
+MV_BOOL mv_switch_vtu_get(MV_U16 vid, GT_VTU_ENTRY *entry)
+{
+	MV_SWITCH_VLAN	vlan;
+	MV_BOOL		valid;
+
+	if (vid >= MV_SWITCH_VTU_VIDS)
+		return MV_FALSE;
+
+	spin_lock(&switch_vtu_mirror_lock);
+	valid = test_bit(vid, switch_vtu_mirror.vids) ? MV_TRUE : MV_FALSE;
+	vlan = switch_vtu_mirror.vlan[vid];
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	if (valid && entry)
+		mvSwitchVlanUnpack(vid, &vlan, entry);
+	return valid;
+}
+
+/* Copy of the whole VTU, to be edited and handed to mv_switch_vtu_push() */
+void mv_switch_vtu_map_get(MV_SWITCH_VLAN_MAP *map)
+{
+	spin_lock(&switch_vtu_mirror_lock);
+	memcpy(map, &switch_vtu_mirror, sizeof(MV_SWITCH_VLAN_MAP));
+	spin_unlock(&switch_vtu_mirror_lock);
+}
+
+/*******************************************************************************
+* mv_switch_vtu_entry_init - Fill an entry whose members egress unmodified.
+*
+* INPUT:
+*       portsMask - member ports; the other ports are not members.
+*
+*******************************************************************************/
+void mv_switch_vtu_entry_init(GT_VTU_ENTRY *entry, MV_U16 vid, MV_U16 dbNum, MV_U32 portsMask)
+{
+	int p;
+
+	memset(entry, 0, sizeof(GT_VTU_ENTRY));
+	entry->vid = vid;
+	entry->DBNum = dbNum;
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		entry->vtuData.memberTagP[p] = (portsMask & (1 << p)) ?
+					       MEMBER_EGRESS_UNMODIFIED : NOT_A_MEMBER;
+}
+
+/*******************************************************************************
+* mv_switch_vtu_sync - Rebuild the mirror from the VTU.
+*
+*******************************************************************************/
+int mv_switch_vtu_sync(void)
+{
+	GT_VTU_ENTRY	entry;
+	MV_STATUS	status;
+	int		err = 0;
+
+	mutex_lock(&switch_vtu_lock);
+	mvSwitchVtuMirrorClear();
+
+	entry.vid = 0xFFF;
+	while ((status = gvtuGetEntryNext(&qddev, &entry)) == MV_OK)
+		mv_switch_vtu_mirror_op(&entry, MV_FALSE);
+	if (status != MV_NO_SUCH) {
+		printk(KERN_ERR "%s: VTU read failed (%d)\n", __func__, status);
+		switch_vtu_stats.errors++;
+		err = -EIO;
+	}
+	switch_vtu_stats.syncs++;
+	mutex_unlock(&switch_vtu_lock);
+
+	return err;
+}
+
+/* Load or purge the n gathered entries, under switch_vtu_lock */
+static int mvSwitchVtuBatchRun(MV_U32 n, MV_BOOL purge)
+{
+	MV_STATUS status;
+
+	if (n == 0)
+		return 0;
+
+	status = gvtuLoadEntries(&qddev, switch_vtu_batch, n, purge, NULL);
+	if (status != MV_OK) {
+		switch_vtu_stats.errors++;
+		return -EIO;
+	}
+	if (purge)
+		switch_vtu_stats.purges += n;
+	else
+		switch_vtu_stats.loads += n;
+	return 0;
+}
+
+/* Queue switch_vtu_batch[*n] and run the batch once it is full */
+static int mvSwitchVtuBatchQueue(MV_U32 *n, MV_BOOL purge)
+{
+	int err = 0;
+
+	if (++(*n) == MV_SWITCH_VTU_LOAD_CHUNK) {
+		err = mvSwitchVtuBatchRun(*n, purge);
+		*n = 0;
+	}
+	return err;
+}
+
+/* Run the last batch and account the update, releases switch_vtu_lock */
+static int mvSwitchVtuUpdateEnd(int err, MV_U32 n, MV_BOOL purge, MV_U32 base, ktime_t start)
+{
+	MV_U32 written;
+
+	if (!err)
+		err = mvSwitchVtuBatchRun(n, purge);
+
+	written = switch_vtu_stats.loads + switch_vtu_stats.purges - base;
+	switch_vtu_stats.lastUs = (MV_U32)ktime_us_delta(ktime_get(), start);
+	mutex_unlock(&switch_vtu_lock);
+
+	return err ? err : written;
+}
+
+/*******************************************************************************
+* mv_switch_vtu_set - Load VTU entries that differ from the VTU.
+*
+* INPUT:
+*       entries - entries to have in the VTU, any VID order.
+*       count   - number of entries.
+*
+* RETURN:
+*       Number of entries written, or a negative error. Entries already in
+*       the VTU with the same members, DBNum, SID and priority are skipped.
+*
+*******************************************************************************/
+int mv_switch_vtu_set(GT_VTU_ENTRY *entries, MV_U32 count)
+{
+	MV_SWITCH_VLAN	vlan, cur;
+	ktime_t		start;
+	MV_U32		i, n = 0, base;
+	MV_U16		vid;
+	int		err = 0;
+
+	for (i = 0; i < count; i++)
+		if (entries[i].vid >= 0xFFF)
+			return -EINVAL;
+
+	mutex_lock(&switch_vtu_lock);
+	start = ktime_get();
+	base = switch_vtu_stats.loads + switch_vtu_stats.purges;
+	switch_vtu_stats.requests += count;
+
+	for (i = 0; i < count && !err; i++) {
+		vid = entries[i].vid;
+		mvSwitchVlanPack(&entries[i], &vlan);
+		spin_lock(&switch_vtu_mirror_lock);
+		cur = test_bit(vid, switch_vtu_mirror.vids) ? switch_vtu_mirror.vlan[vid] : switch_vlan_none;
+		spin_unlock(&switch_vtu_mirror_lock);
+
+		if (!mvSwitchVlanDelta(&cur, &vlan)) {
+			switch_vtu_stats.unchanged++;
+			continue;
+		}
+		switch_vtu_batch[n] = entries[i];
+		err = mvSwitchVtuBatchQueue(&n, MV_FALSE);
+	}
+
+	return mvSwitchVtuUpdateEnd(err, n, MV_FALSE, base, start);
+}
+
+/*******************************************************************************
+* mv_switch_vtu_del - Purge VIDs from the VTU.
+*
+* RETURN:
+*       Number of entries purged, or a negative error. VIDs not in the VTU
+*       are skipped.
+*
+*******************************************************************************/
+int mv_switch_vtu_del(MV_U16 *vids, MV_U32 count)
+{
+	MV_SWITCH_VLAN	cur;
+	MV_BOOL		valid;
+	ktime_t		start;
+	MV_U32		i, n = 0, base;
+	int		err = 0;
+
+	for (i = 0; i < count; i++)
+		if (vids[i] >= 0xFFF)
+			return -EINVAL;
+
+	mutex_lock(&switch_vtu_lock);
+	start = ktime_get();
+	base = switch_vtu_stats.loads + switch_vtu_stats.purges;
+	switch_vtu_stats.requests += count;
+
+	for (i = 0; i < count && !err; i++) {
+		spin_lock(&switch_vtu_mirror_lock);
+		valid = test_bit(vids[i], switch_vtu_mirror.vids) ? MV_TRUE : MV_FALSE;
+		cur = switch_vtu_mirror.vlan[vids[i]];
+		spin_unlock(&switch_vtu_mirror_lock);
+
+		if (!valid) {
+			switch_vtu_stats.unchanged++;
+			continue;
+		}
+		mvSwitchVlanDelta(&cur, &switch_vlan_none);
+
+		switch_vtu_batch[n].vid = vids[i];
+		err = mvSwitchVtuBatchQueue(&n, MV_TRUE);
+	}
+
+	return mvSwitchVtuUpdateEnd(err, n, MV_TRUE, base, start);
+}
+
+/* Push under switch_vtu_lock, see mv_switch_vtu_push(); releases the lock */
+static int mvSwitchVtuPush(const MV_SWITCH_VLAN_MAP *map)
+{
+	ktime_t		start;
+	MV_U32		n = 0, base;
+	int		vid, err = 0;
+
+	start = ktime_get();
+	base = switch_vtu_stats.loads + switch_vtu_stats.purges;
+	switch_vtu_stats.pushes++;
+
+	spin_lock(&switch_vtu_mirror_lock);
+	bitmap_andnot(switch_vtu_purge, switch_vtu_mirror.vids, map->vids, MV_SWITCH_VTU_VIDS);
+	bitmap_andnot(switch_vtu_load, map->vids, switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS);
+	bitmap_and(switch_vtu_both, map->vids, switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS);
+	/* 0xFFF is reserved; the caller's map is left as it is */
+	__clear_bit(0xFFF, switch_vtu_load);
+	__clear_bit(0xFFF, switch_vtu_both);
+	switch_vtu_stats.requests += bitmap_weight(switch_vtu_load, MV_SWITCH_VTU_VIDS) +
+				     bitmap_weight(switch_vtu_both, MV_SWITCH_VTU_VIDS);
+
+	for (vid = find_first_bit(switch_vtu_purge, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS;
+	     vid = find_next_bit(switch_vtu_purge, MV_SWITCH_VTU_VIDS, vid + 1))
+		mvSwitchVlanDelta(&switch_vtu_mirror.vlan[vid], &switch_vlan_none);
+	for (vid = find_first_bit(switch_vtu_load, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS;
+	     vid = find_next_bit(switch_vtu_load, MV_SWITCH_VTU_VIDS, vid + 1))
+		mvSwitchVlanDelta(&switch_vlan_none, &map->vlan[vid]);
+	for (vid = find_first_bit(switch_vtu_both, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS;
+	     vid = find_next_bit(switch_vtu_both, MV_SWITCH_VTU_VIDS, vid + 1)) {
+		if (mvSwitchVlanDelta(&switch_vtu_mirror.vlan[vid], &map->vlan[vid]))
+			__set_bit(vid, switch_vtu_load);
+		else
+			switch_vtu_stats.unchanged++;
+	}
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	/* purge first, so that the loads find room in the VTU */
+	for (vid = find_first_bit(switch_vtu_purge, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS && !err;
+	     vid = find_next_bit(switch_vtu_purge, MV_SWITCH_VTU_VIDS, vid + 1)) {
+		switch_vtu_batch[n].vid = vid;
+		err = mvSwitchVtuBatchQueue(&n, MV_TRUE);
+	}
+	if (!err)
+		err = mvSwitchVtuBatchRun(n, MV_TRUE);
+	n = 0;
+
+	for (vid = find_first_bit(switch_vtu_load, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS && !err;
+	     vid = find_next_bit(switch_vtu_load, MV_SWITCH_VTU_VIDS, vid + 1)) {
+		mvSwitchVlanUnpack(vid, &map->vlan[vid], &switch_vtu_batch[n]);
+		err = mvSwitchVtuBatchQueue(&n, MV_FALSE);
+	}
+
+	return mvSwitchVtuUpdateEnd(err, n, MV_FALSE, base, start);
+}
+
+/*******************************************************************************
+* mv_switch_vtu_push - Make the VTU hold exactly the VLAN table given.
+*
+* DESCRIPTION:
+*       VIDs only in the VTU are purged, VIDs only in the table are loaded
+*       and VIDs in both are loaded if their entries differ. Nothing is
+*       written for the others. The map is not modified.
+*
+* RETURN:
+*       Number of entries written, or a negative error.
+*
+*******************************************************************************/
+int mv_switch_vtu_push(const MV_SWITCH_VLAN_MAP *map)
+{
+	mutex_lock(&switch_vtu_lock);
+	return mvSwitchVtuPush(map);
+}
+
+/*******************************************************************************
+* mv_switch_vtu_range_set - Replace the VIDs of a range by the given entries.
+*
+* DESCRIPTION:
+*       The VTU is copied, the VIDs first..last dropped from the copy and
+*       the entries added, and the copy is pushed, all under one hold of
+*       the update lock, so concurrent updates outside the range are kept.
+*       VIDs of the range left out of 'entries' are purged.
+*
+* RETURN:
+*       Number of entries written, or a negative error.
+*
+*******************************************************************************/
+int mv_switch_vtu_range_set(MV_U16 first, MV_U16 last, GT_VTU_ENTRY *entries, MV_U32 count)
+{
+	MV_U32 i;
+
+	if (first > last || last >= 0xFFF)
+		return -EINVAL;
+	for (i = 0; i < count; i++)
+		if (entries[i].vid >= 0xFFF)
+			return -EINVAL;
+
+	mutex_lock(&switch_vtu_lock);
+	spin_lock(&switch_vtu_mirror_lock);
+	memcpy(&switch_vtu_scratch, &switch_vtu_mirror, sizeof(MV_SWITCH_VLAN_MAP));
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	bitmap_clear(switch_vtu_scratch.vids, first, last - first + 1);
+	for (i = 0; i < count; i++)
+		mv_switch_vlan_map_add(&switch_vtu_scratch, &entries[i]);
+
+	return mvSwitchVtuPush(&switch_vtu_scratch);
+}
+
+int mv_switch_vtu_show(char *buf)
+{
+	static const char	tag_char[4] = { '=', '-', 'u', 't' };
+	MV_SWITCH_VTU_STATS	*s = &switch_vtu_stats;
+	MV_SWITCH_VLAN		vlan;
+	int			off = 0, vid, p, shown = 0;
+
+	off += sprintf(buf + off, "vtu: entries %u, requests %u unchanged %u loads %u purges %u errors %u syncs %u pushes %u\n",
+		       s->entries, s->requests, s->unchanged, s->loads, s->purges, s->errors, s->syncs, s->pushes);
+	off += sprintf(buf + off, "ports: joined %u left %u retagged %u, last update %u us\n",
+		       s->joins, s->leaves, s->retags, s->lastUs);
+	off += sprintf(buf + off, " vid  fid sid pri ports (= unmodified, u untagged, t tagged, - none)\n");
+
+	spin_lock(&switch_vtu_mirror_lock);
+	vid = find_first_bit(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS);
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	while (vid < MV_SWITCH_VTU_VIDS && shown < MV_SWITCH_VTU_SHOW_MAX) {
+		spin_lock(&switch_vtu_mirror_lock);
+		vlan = switch_vtu_mirror.vlan[vid];
+		spin_unlock(&switch_vtu_mirror_lock);
+
+		off += sprintf(buf + off, "%4d %4d %3d ", vid, vlan.fid & 0xFFF, vlan.sid);
+		off += sprintf(buf + off, (vlan.prio & MV_SWITCH_VLAN_PRI_OVERRIDE) ? "%3d " : "  - ", vlan.prio & 0x7);
+		for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+			buf[off++] = (vlan.members & (1 << p)) ? tag_char[(vlan.egress >> (2 * p)) & 0x3] : '-';
+		buf[off++] = '\n';
+		shown++;
+
+		spin_lock(&switch_vtu_mirror_lock);
+		vid = find_next_bit(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS, vid + 1);
+		spin_unlock(&switch_vtu_mirror_lock);
+	}
+	if (shown < s->entries)
+		off += sprintf(buf + off, "... %u more\n", s->entries - shown);
+
+	return off;
+}
+
+/*******************************************************************************
+* MSTP instances
+*
+* Each STU entry (SID) holds the port states of one spanning tree instance
+* for the VLANs whose VTU entry carries that SID; SID 0, the CIST, holds the
+* VLANs created by the driver. A copy of the STU, a 2-bit port state per port
+* and SID, is read at init next to the VTU mirror, so that a state request
+* that changes nothing costs no register access. A port leaving forwarding
+* or learning in an instance only loses its dynamic addresses in the
+* databases of that instance's VLANs. The per-instance states apply to ports left forwarding
+* in their Port Control register (gstpSetPortState).
+*******************************************************************************/
+#define SWITCH_STU_ALL_FORWARDING	((1 << (2 * MAX_SWITCH_PORT_NUM)) - 1)
+
+/* databases of the VLANs of an instance, used under switch_vtu_lock */
+static DECLARE_BITMAP(switch_stu_fids, MV_SWITCH_VTU_VIDS);
+
+static MV_U16 mvSwitchStuPack(GT_STU_ENTRY *entry)
+{
+	MV_U16	states = 0;
+	int	p;
+
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		states |= (entry->portState[p] & 0x3) << (2 * p);
+	return states;
+}
+
+static void mvSwitchStuUnpack(MV_U8 sid, MV_U16 states, GT_STU_ENTRY *entry)
+{
+	int p;
+
+	memset(entry, 0, sizeof(GT_STU_ENTRY));
+	entry->sid = sid;
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		entry->portState[p] = (states >> (2 * p)) & 0x3;
+}
+
+/* Apply an entry loaded (or purged) by gstuAddEntry/gstuDelEntry */
+void mv_switch_stu_mirror_op(GT_STU_ENTRY *entry, MV_BOOL purge)
+{
+	if (entry->sid >= MV_SWITCH_STU_SIDS)
+		return;
+
+	spin_lock(&switch_vtu_mirror_lock);
+	if (purge) {
+		if (test_and_clear_bit(entry->sid, switch_stu_mirror.valid))
+			switch_stu_stats.instances--;
+	} else {
+		switch_stu_mirror.states[entry->sid] = mvSwitchStuPack(entry);
+		if (!test_and_set_bit(entry->sid, switch_stu_mirror.valid))
+			switch_stu_stats.instances++;
+	}
+	spin_unlock(&switch_vtu_mirror_lock);
+}
+
+/* Load an instance with all ports forwarding unless the STU has it, under switch_vtu_lock */
+static int mvSwitchStuEnsure(MV_U8 sid)
+{
+	GT_STU_ENTRY	entry;
+	MV_BOOL		valid;
+
+	spin_lock(&switch_vtu_mirror_lock);
+	valid = test_bit(sid, switch_stu_mirror.valid) ? MV_TRUE : MV_FALSE;
+	spin_unlock(&switch_vtu_mirror_lock);
+	if (valid)
+		return 0;
+
+	mvSwitchStuUnpack(sid, SWITCH_STU_ALL_FORWARDING, &entry);
+	if (gstuAddEntry(&qddev, &entry) != MV_OK) {
+		switch_stu_stats.errors++;
+		return -EIO;
+	}
+	return 0;
+}
+
+/*******************************************************************************
+* mv_switch_stu_sync - Rebuild the STU copy from the switch.
+*
+* DESCRIPTION:
+*       The CIST (SID 0) is loaded with all ports forwarding if the STU
+*       does not hold it.
+*
+*******************************************************************************/
+int mv_switch_stu_sync(void)
+{
+	GT_STU_ENTRY	entry;
+	MV_STATUS	status;
+	int		err = 0;
+
+	mutex_lock(&switch_vtu_lock);
+	spin_lock(&switch_vtu_mirror_lock);
+	bitmap_zero(switch_stu_mirror.valid, MV_SWITCH_STU_SIDS);
+	switch_stu_stats.instances = 0;
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	entry.sid = 0x3F;
+	while ((status = gstuGetEntryNext(&qddev, &entry)) == MV_OK)
+		mv_switch_stu_mirror_op(&entry, MV_FALSE);
+	if (status != MV_NO_SUCH) {
+		printk(KERN_ERR "%s: STU read failed (%d)\n", __func__, status);
+		switch_stu_stats.errors++;
+		err = -EIO;
+	}
+	if (!err)
+		err = mvSwitchStuEnsure(0);
+	mutex_unlock(&switch_vtu_lock);
+
+	return err;
+}
+
+/* Drop the dynamic addresses of a port in the databases of an instance, under switch_vtu_lock */
+static void mvSwitchStuPortFlush(MV_U8 sid, int port)
+{
+	MV_SWITCH_VLAN	*vlan;
+	int		vid, fid;
+
+	bitmap_zero(switch_stu_fids, MV_SWITCH_VTU_VIDS);
+	spin_lock(&switch_vtu_mirror_lock);
+	for (vid = find_first_bit(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS;
+	     vid = find_next_bit(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS, vid + 1)) {
+		vlan = &switch_vtu_mirror.vlan[vid];
+		if (vlan->sid == sid && (vlan->members & (1 << port)))
+			__set_bit(vlan->fid & 0xFFF, switch_stu_fids);
+	}
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	for (fid = find_first_bit(switch_stu_fids, MV_SWITCH_VTU_VIDS); fid < MV_SWITCH_VTU_VIDS;
+	     fid = find_next_bit(switch_stu_fids, MV_SWITCH_VTU_VIDS, fid + 1)) {
+		if (gfdbRemovePortInDB(&qddev, GT_MOVE_ALL_UNLOCKED, port, fid) != MV_OK) {
+			switch_stu_stats.errors++;
+			continue;
+		}
+		switch_stu_stats.flushes++;
+	}
+}
+
+/*******************************************************************************
+* mv_switch_mstp_state_set - Set the state of a port in one MSTP instance.
+*
+* DESCRIPTION:
+*       Only the STU entry of the instance is loaded; a missing instance is
+*       created with all ports forwarding first. A port leaving forwarding
+*       or learning loses its dynamic addresses in the databases of the
+*       instance's VLANs only.
+*
+*******************************************************************************/
+int mv_switch_mstp_state_set(MV_U8 sid, int port, GT_PORT_STP_STATE state)
+{
+	GT_STU_ENTRY		entry;
+	GT_PORT_STP_STATE	old;
+	MV_U16			states;
+	int			err;
+
+	if (sid >= MV_SWITCH_STU_SIDS || port < 0 || port >= MAX_SWITCH_PORT_NUM || state > GT_PORT_FORWARDING)
+		return -EINVAL;
+
+	mutex_lock(&switch_vtu_lock);
+	err = mvSwitchStuEnsure(sid);
+	if (err)
+		goto out;
+
+	spin_lock(&switch_vtu_mirror_lock);
+	states = switch_stu_mirror.states[sid];
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	old = (states >> (2 * port)) & 0x3;
+	if (old == state) {
+		switch_stu_stats.unchanged++;
+		goto out;
+	}
+
+	states = (states & ~(0x3 << (2 * port))) | (state << (2 * port));
+	mvSwitchStuUnpack(sid, states, &entry);
+	if (gstuAddEntry(&qddev, &entry) != MV_OK) {
+		switch_stu_stats.errors++;
+		err = -EIO;
+		goto out;
+	}
+	switch_stu_stats.changes++;
+
+	/* learning -> forwarding keeps what the port has learned */
+	if (old == GT_PORT_FORWARDING || (old == GT_PORT_LEARNING && state != GT_PORT_FORWARDING))
+		mvSwitchStuPortFlush(sid, port);
+out:
+	mutex_unlock(&switch_vtu_lock);
+	return err;
+}
+
+/*******************************************************************************
+* mv_switch_mstp_vlan_set - Map VLANs to an MSTP instance.
+*
+* DESCRIPTION:
+*       The VTU entries of the VIDs get the instance's SID; VIDs not in the
+*       VTU are skipped and VIDs already mapped cost no register access.
+*
+* RETURN:
+*       Number of VIDs moved, or a negative error.
+*
+*******************************************************************************/
+int mv_switch_mstp_vlan_set(MV_U8 sid, MV_U16 *vids, MV_U32 count)
+{
+	GT_VTU_ENTRY	entries[MAX_SWITCH_PORT_NUM + 1];
+	MV_U32		i, n = 0, moved = 0;
+	int		err;
+
+	if (sid >= MV_SWITCH_STU_SIDS)
+		return -EINVAL;
+
+	mutex_lock(&switch_vtu_lock);
+	err = mvSwitchStuEnsure(sid);
+	mutex_unlock(&switch_vtu_lock);
+	if (err)
+		return err;
+
+	for (i = 0; i < count; i++) {
+		if (!mv_switch_vtu_get(vids[i], &entries[n]) || entries[n].sid == sid)
+			continue;
+		entries[n++].sid = sid;
+
+		if (n == ARRAY_SIZE(entries)) {
+			err = mv_switch_vtu_set(entries, n);
+			if (err < 0)
+				return err;
+			moved += n;
+			n = 0;
+		}
+	}
+	if (n) {
+		err = mv_switch_vtu_set(entries, n);
+		if (err < 0)
+			return err;
+		moved += n;
+	}
+	switch_stu_stats.vlans += moved;
+
+	return moved;
+}
+
+/* Map the VIDs of a VLAN group (see mv_eth_switch_vlan_set) to an MSTP instance */
+int mv_switch_mstp_vlan_grp_set(MV_U16 vlan_grp_id, MV_U8 sid)
+{
+	MV_U16	vids[MAX_SWITCH_PORT_NUM + 1];
+	MV_U16	vlan_id = MV_SWITCH_GROUP_VLAN_ID(vlan_grp_id);
+	int	p, n = 0;
+
+	vids[n++] = vlan_id;
+	for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+		vids[n++] = MV_SWITCH_PORT_VLAN_ID(vlan_id, p);
+
+	return mv_switch_mstp_vlan_set(sid, vids, n);
+}
+
+int mv_switch_stu_show(char *buf)
+{
+	static const char	state_char[4] = { 'D', 'B', 'L', 'F' };
+	MV_SWITCH_STU_STATS	*s = &switch_stu_stats;
+	MV_U16			vlans[MV_SWITCH_STU_SIDS];
+	MV_U16			states;
+	int			off = 0, sid, vid, p;
+
+	memset(vlans, 0, sizeof(vlans));
+	spin_lock(&switch_vtu_mirror_lock);
+	for (vid = find_first_bit(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS); vid < MV_SWITCH_VTU_VIDS;
+	     vid = find_next_bit(switch_vtu_mirror.vids, MV_SWITCH_VTU_VIDS, vid + 1))
+		if (switch_vtu_mirror.vlan[vid].sid < MV_SWITCH_STU_SIDS)
+			vlans[switch_vtu_mirror.vlan[vid].sid]++;
+	spin_unlock(&switch_vtu_mirror_lock);
+
+	off += sprintf(buf + off, "stu: instances %u, state changes %u unchanged %u, vlans moved %u, port flushes %u errors %u\n",
+		       s->instances, s->changes, s->unchanged, s->vlans, s->flushes, s->errors);
+	off += sprintf(buf + off, "sid ports (D disabled, B blocking, L learning, F forwarding) vlans\n");
+
+	for (sid = 0; sid < MV_SWITCH_STU_SIDS; sid++) {
+		spin_lock(&switch_vtu_mirror_lock);
+		if (!test_bit(sid, switch_stu_mirror.valid)) {
+			spin_unlock(&switch_vtu_mirror_lock);
+			continue;
+		}
+		states = switch_stu_mirror.states[sid];
+		spin_unlock(&switch_vtu_mirror_lock);
+
+		off += sprintf(buf + off, "%3d ", sid);
+		for (p = 0; p < MAX_SWITCH_PORT_NUM; p++)
+			buf[off++] = state_char[(states >> (2 * p)) & 0x3];
+		off += sprintf(buf + off, " %u\n", vlans[sid]);
+	}
+
+	return off;
+}
+
+int mv_switch_vtu_init(void)
+{
+	int err;
+
+	err = mv_switch_vtu_sync();
+	if (!err)
+		err = mv_switch_stu_sync();
+	return err;
+}